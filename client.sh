@@ -8,12 +8,17 @@ if [ -z "$HOST" ] || [ -z "$PORT" ]; then
     exit 1
 fi
 
+# The server keeps connections alive, so a single connection is reused for every query.
+exec 3<>"/dev/tcp/$HOST/$PORT" || exit 1
+
 send_query() {
-    read -r query
+    read -r query || exit 0
 
     query="$query |"
 
-    response=$(echo "$query" | netcat "$HOST" "$PORT")
+    printf "%s" "$query" >&3
+
+    read -r response <&3 || { echo "Connection closed by server"; exit 1; }
 
     echo "$response"
 }
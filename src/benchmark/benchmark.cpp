@@ -0,0 +1,464 @@
+#include <client.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /** The data types the benchmark exercises, in the order of `TYPE_NAMES`. */
+    constexpr std::size_t TYPE_COUNT = 4;
+    constexpr std::array<std::string_view, TYPE_COUNT> TYPE_NAMES{"STR", "SET", "HASH", "QUEUE"};
+
+    /** The number of fields of every hash and of items initially pushed to every queue. */
+    constexpr std::size_t FIELDS_PER_KEY = 16;
+
+    /**
+     * The parameters of a run, given as `--name=value` arguments.
+     */
+    struct Options
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "5555";
+
+        /** The number of concurrent connections. */
+        std::size_t connections = 8;
+
+        /** The number of commands each connection keeps in flight. */
+        std::size_t pipeline = 1;
+
+        /** The number of commands measured. */
+        std::size_t requests = 100000;
+
+        /** The number of threads running the connections. */
+        std::size_t threads = 2;
+
+        /** The number of keys of every type. */
+        std::size_t keyspace = 10000;
+
+        std::size_t key_size = 16;
+        std::size_t value_size = 64;
+
+        /** The fraction of commands modifying a key. Queues are pushed and popped equally often regardless. */
+        double write_ratio = 0.1;
+
+        /** The relative frequency of the commands on each type, e.g. `STR:50,SET:20,HASH:20,QUEUE:10`. */
+        std::array<unsigned int, TYPE_COUNT> mix{1, 0, 0, 0};
+
+        /** The file the JSON report is written to, standard output if empty. */
+        std::string output;
+    };
+
+    /**
+     * The latencies and errors measured by one pipeline slot, merged when the run ends.
+     */
+    struct Samples
+    {
+        std::array<std::vector<std::uint64_t>, TYPE_COUNT> latencies;
+        std::array<std::uint64_t, TYPE_COUNT> errors{};
+    };
+
+    void print_usage()
+    {
+        std::cerr << "Usage: database-benchmark [--host=127.0.0.1] [--port=5555] [--connections=8] [--pipeline=1]\n"
+                     "                          [--requests=100000] [--threads=2] [--keyspace=10000] [--key-size=16]\n"
+                     "                          [--value-size=64] [--write-ratio=0.1] [--mix=STR:1,SET:0,HASH:0,QUEUE:0]\n"
+                     "                          [--output=report.json]\n";
+    }
+
+    std::array<unsigned int, TYPE_COUNT> parse_mix(const std::string &value)
+    {
+        std::array<unsigned int, TYPE_COUNT> mix{};
+        std::vector<std::string> entries;
+        boost::split(entries, value, boost::is_any_of(","));
+        for (auto &&entry : entries)
+        {
+            auto separator = entry.find(':');
+            auto type = std::find(TYPE_NAMES.begin(), TYPE_NAMES.end(), boost::to_upper_copy(entry.substr(0, separator)));
+            if (type == TYPE_NAMES.end())
+            {
+                throw db::DatabaseException("Unknown type in mix: " + entry, "BAD_ARG");
+            }
+            mix[type - TYPE_NAMES.begin()] = separator == std::string::npos ? 1 : boost::lexical_cast<unsigned int>(entry.substr(separator + 1));
+        }
+        if (std::all_of(mix.begin(), mix.end(), [](unsigned int weight)
+                        { return weight == 0; }))
+        {
+            throw db::DatabaseException("The mix has no command", "BAD_ARG");
+        }
+        return mix;
+    }
+
+    Options parse_options(int argc, char *argv[])
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argument = argv[i];
+            auto separator = argument.find('=');
+            if (argument.rfind("--", 0) != 0 || separator == std::string::npos)
+            {
+                throw db::DatabaseException("Expected --name=value, got " + argument, "BAD_ARG");
+            }
+            std::string name = argument.substr(2, separator - 2);
+            std::string value = argument.substr(separator + 1);
+
+            if (name == "host")
+            {
+                options.host = value;
+            }
+            else if (name == "port")
+            {
+                options.port = value;
+            }
+            else if (name == "connections")
+            {
+                options.connections = std::max<std::size_t>(boost::lexical_cast<std::size_t>(value), 1);
+            }
+            else if (name == "pipeline")
+            {
+                options.pipeline = std::max<std::size_t>(boost::lexical_cast<std::size_t>(value), 1);
+            }
+            else if (name == "requests")
+            {
+                options.requests = boost::lexical_cast<std::size_t>(value);
+            }
+            else if (name == "threads")
+            {
+                options.threads = std::max<std::size_t>(boost::lexical_cast<std::size_t>(value), 1);
+            }
+            else if (name == "keyspace")
+            {
+                options.keyspace = std::max<std::size_t>(boost::lexical_cast<std::size_t>(value), 1);
+            }
+            else if (name == "key-size")
+            {
+                options.key_size = boost::lexical_cast<std::size_t>(value);
+            }
+            else if (name == "value-size")
+            {
+                options.value_size = std::max<std::size_t>(boost::lexical_cast<std::size_t>(value), 1);
+            }
+            else if (name == "write-ratio")
+            {
+                options.write_ratio = boost::lexical_cast<double>(value);
+            }
+            else if (name == "mix")
+            {
+                options.mix = parse_mix(value);
+            }
+            else if (name == "output")
+            {
+                options.output = value;
+            }
+            else
+            {
+                throw db::DatabaseException("Unknown option: " + name, "BAD_ARG");
+            }
+        }
+        return options;
+    }
+
+    /**
+     * Returns the name of a key, padded with zeros to the configured key size.
+     */
+    std::string make_key(std::string_view type, std::size_t index, std::size_t key_size)
+    {
+        std::string prefix = "bench:" + boost::to_lower_copy(std::string{type}) + ":";
+        std::string number = std::to_string(index);
+        std::size_t padding = key_size > prefix.size() + number.size() ? key_size - prefix.size() - number.size() : 0;
+        return prefix + std::string(padding, '0') + number;
+    }
+
+    /**
+     * Creates the keys the measured commands operate on. Keys left over by an earlier run are reused.
+     */
+    void populate(db::ClientConnection &connection, const Options &options)
+    {
+        const std::string value(options.value_size, 'v');
+        db::CommandBatch batch;
+        auto flush = [&]
+        {
+            connection.async_execute(std::move(batch), boost::asio::use_future).get();
+            batch = db::CommandBatch{};
+        };
+
+        for (std::size_t type = 0; type < TYPE_COUNT; ++type)
+        {
+            if (options.mix[type] == 0)
+            {
+                continue;
+            }
+            for (std::size_t i = 0; i < options.keyspace; ++i)
+            {
+                std::string key = make_key(TYPE_NAMES[type], i, options.key_size);
+                batch.add({"CREATE", TYPE_NAMES[type], key, value});
+                for (std::size_t j = 0; j < FIELDS_PER_KEY && type != 0; ++j)
+                {
+                    std::string item = std::to_string(j);
+                    if (TYPE_NAMES[type] == "SET")
+                    {
+                        batch.add({"SET", key, "ADD", item});
+                    }
+                    else if (TYPE_NAMES[type] == "HASH")
+                    {
+                        batch.add({"HASH", key, "SET", item, value});
+                    }
+                    else
+                    {
+                        batch.add({"QUEUE", key, "PUSH", value});
+                    }
+                }
+                if (batch.size() >= 4096)
+                {
+                    flush();
+                }
+            }
+        }
+        flush();
+    }
+
+    /**
+     * Executes commands one after another until the shared budget is used up.
+     */
+    boost::asio::awaitable<void> run_slot(std::shared_ptr<db::ClientConnection> connection, const Options &options, std::string run,
+                                          std::atomic<std::int64_t> &remaining, Samples &samples, unsigned int seed)
+    {
+        std::mt19937 random{seed};
+        std::discrete_distribution<std::size_t> pick_type(options.mix.begin(), options.mix.end());
+        std::uniform_int_distribution<std::size_t> pick_key(0, options.keyspace - 1);
+        std::uniform_int_distribution<std::size_t> pick_field(0, FIELDS_PER_KEY - 1);
+        std::bernoulli_distribution pick_write(options.write_ratio);
+        std::bernoulli_distribution pick_push(0.5);
+        const std::string value(options.value_size, 'v');
+        std::uint64_t created = 0;
+
+        std::array<std::string, 2> owned;
+        std::array<std::string_view, 5> arguments;
+        while (remaining.fetch_sub(1, std::memory_order_relaxed) > 0)
+        {
+            std::size_t type = pick_type(random);
+            bool write = pick_write(random);
+            owned[0] = make_key(TYPE_NAMES[type], pick_key(random), options.key_size);
+            owned[1] = std::to_string(pick_field(random));
+            std::size_t count = 0;
+            switch (type)
+            {
+            case 0:
+                if (write)
+                {
+                    // Strings cannot be overwritten, so writes create new keys, unique across runs.
+                    owned[0] = make_key("str-" + run + "-" + std::to_string(seed), created++, options.key_size);
+                    arguments = {"CREATE", "STR", owned[0], value};
+                    count = 4;
+                }
+                else
+                {
+                    arguments = {"STR", owned[0], "GET"};
+                    count = 3;
+                }
+                break;
+            case 1:
+                arguments = {"SET", owned[0], write ? "ADD" : "CONTAINS", owned[1]};
+                count = 4;
+                break;
+            case 2:
+                arguments = {"HASH", owned[0], write ? "SET" : "GET", owned[1], value};
+                count = write ? 5 : 4;
+                break;
+            default:
+                arguments = {"QUEUE", owned[0], pick_push(random) ? "PUSH" : "POP", value};
+                count = arguments[2] == "PUSH" ? 4 : 3;
+                break;
+            }
+
+            auto start = Clock::now();
+            auto operation = connection->async_execute(std::span<const std::string_view>(arguments.data(), count), boost::asio::use_awaitable);
+            db::ClientReply reply = co_await std::move(operation);
+            samples.latencies[type].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            if (!reply.success())
+            {
+                ++samples.errors[type];
+            }
+        }
+    }
+
+    /**
+     * Returns the latency below which the given fraction of the sorted latencies lies, in microseconds.
+     */
+    double percentile(const std::vector<std::uint64_t> &sorted, double fraction)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+        return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)] / 1000.0;
+    }
+
+    void write_statistics(std::ostream &out, std::vector<std::uint64_t> &latencies, std::uint64_t errors, double seconds)
+    {
+        std::sort(latencies.begin(), latencies.end());
+        double mean = 0;
+        for (auto latency : latencies)
+        {
+            mean += latency;
+        }
+        mean = latencies.empty() ? 0 : mean / latencies.size() / 1000.0;
+
+        out << "{\"requests\": " << latencies.size()
+            << ", \"errors\": " << errors
+            << ", \"throughput\": " << (seconds > 0 ? latencies.size() / seconds : 0)
+            << ", \"latency_us\": {\"mean\": " << mean
+            << ", \"p50\": " << percentile(latencies, 0.5)
+            << ", \"p99\": " << percentile(latencies, 0.99)
+            << ", \"p999\": " << percentile(latencies, 0.999)
+            << ", \"max\": " << (latencies.empty() ? 0 : latencies.back() / 1000.0) << "}}";
+    }
+
+    void write_report(std::ostream &out, const Options &options, std::vector<Samples> &samples, double seconds)
+    {
+        std::vector<std::uint64_t> all;
+        std::uint64_t all_errors = 0;
+        std::array<std::vector<std::uint64_t>, TYPE_COUNT> by_type;
+        std::array<std::uint64_t, TYPE_COUNT> errors{};
+        for (auto &&slot : samples)
+        {
+            for (std::size_t type = 0; type < TYPE_COUNT; ++type)
+            {
+                by_type[type].insert(by_type[type].end(), slot.latencies[type].begin(), slot.latencies[type].end());
+                all.insert(all.end(), slot.latencies[type].begin(), slot.latencies[type].end());
+                errors[type] += slot.errors[type];
+                all_errors += slot.errors[type];
+            }
+        }
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\n  \"config\": {\"host\": \"" << options.host << "\", \"port\": \"" << options.port
+            << "\", \"connections\": " << options.connections
+            << ", \"pipeline\": " << options.pipeline
+            << ", \"requests\": " << options.requests
+            << ", \"threads\": " << options.threads
+            << ", \"keyspace\": " << options.keyspace
+            << ", \"key_size\": " << options.key_size
+            << ", \"value_size\": " << options.value_size
+            << ", \"write_ratio\": " << options.write_ratio
+            << ", \"mix\": {";
+        for (std::size_t type = 0; type < TYPE_COUNT; ++type)
+        {
+            out << (type ? ", " : "") << "\"" << TYPE_NAMES[type] << "\": " << options.mix[type];
+        }
+        out << "}},\n  \"seconds\": " << seconds << ",\n  \"total\": ";
+        write_statistics(out, all, all_errors, seconds);
+        out << ",\n  \"types\": {";
+        bool first = true;
+        for (std::size_t type = 0; type < TYPE_COUNT; ++type)
+        {
+            if (options.mix[type] == 0)
+            {
+                continue;
+            }
+            out << (first ? "\n    \"" : ",\n    \"") << TYPE_NAMES[type] << "\": ";
+            write_statistics(out, by_type[type], errors[type], seconds);
+            first = false;
+        }
+        out << "\n  }\n}\n";
+    }
+
+    /**
+     * Runs an IO context on several threads until it is destroyed.
+     */
+    class IoThreads
+    {
+    private:
+        boost::asio::io_context &io_context_;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_;
+        std::vector<std::thread> threads_;
+
+    public:
+        IoThreads(boost::asio::io_context &io_context, std::size_t count) : io_context_{io_context}, work_{io_context.get_executor()}
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                threads_.emplace_back([&io_context]
+                                      { io_context.run(); });
+            }
+        }
+
+        ~IoThreads()
+        {
+            io_context_.stop();
+            for (auto &&thread : threads_)
+            {
+                thread.join();
+            }
+        }
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        Options options = parse_options(argc, argv);
+
+        boost::asio::io_context io_context;
+        IoThreads threads{io_context, options.threads};
+
+        std::vector<std::shared_ptr<db::ClientConnection>> connections;
+        for (std::size_t i = 0; i < options.connections; ++i)
+        {
+            connections.push_back(db::ClientConnection::connect(io_context, options.host, options.port));
+        }
+        populate(*connections.front(), options);
+
+        std::string run = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+        std::atomic<std::int64_t> remaining{static_cast<std::int64_t>(options.requests)};
+        std::vector<Samples> samples(options.connections * options.pipeline);
+        std::vector<std::future<void>> slots;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < samples.size(); ++i)
+        {
+            slots.push_back(boost::asio::co_spawn(io_context, run_slot(connections[i % options.connections], options, run, remaining, samples[i], static_cast<unsigned int>(i)),
+                                                  boost::asio::use_future));
+        }
+        for (auto &&slot : slots)
+        {
+            slot.get();
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (options.output.empty())
+        {
+            write_report(std::cout, options, samples, seconds);
+        }
+        else
+        {
+            std::ofstream file(options.output);
+            write_report(file, options, samples, seconds);
+            std::cerr << options.requests << " requests in " << seconds << " s, " << options.requests / seconds << " requests/s" << std::endl;
+        }
+    }
+    catch (const db::DatabaseException &e)
+    {
+        std::cerr << e.get_message() << std::endl;
+        print_usage();
+        return 1;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,249 @@
+#include "client.hpp"
+#include <algorithm>
+
+namespace db
+{
+    ClientReply::ClientReply(std::shared_ptr<const std::string> block, bool success, std::string_view payload, std::string_view code)
+        : block_{std::move(block)}, success_{success}, payload_{payload}, code_{code} {}
+
+    std::string_view ClientReply::value() const
+    {
+        if (!success_)
+        {
+            throw DatabaseException(std::string{payload_}, std::string{code_});
+        }
+        return payload_;
+    }
+
+    void CommandBatch::add(std::span<const std::string_view> arguments)
+    {
+        protocol::encode_frame(frames_, protocol::Opcode::COMMAND, arguments);
+        ++size_;
+    }
+
+    void CommandBatch::add(std::initializer_list<std::string_view> arguments)
+    {
+        add(std::span<const std::string_view>(arguments.begin(), arguments.size()));
+    }
+
+    std::string CommandBatch::release()
+    {
+        size_ = 0;
+        return std::exchange(frames_, std::string{});
+    }
+
+    ClientConnection::ClientConnection(boost::asio::io_context &io_context)
+        : socket_{io_context},
+          strand_{boost::asio::make_strand(io_context)},
+          writing_{false},
+          block_{std::make_shared<std::string>(BLOCK_SIZE, '\0')},
+          begin_{0},
+          end_{0},
+          broken_{false},
+          in_flight_{0} {}
+
+    std::shared_ptr<ClientConnection> ClientConnection::connect(boost::asio::io_context &io_context, const std::string &host, const std::string &port)
+    {
+        auto connection = std::make_shared<ClientConnection>(io_context);
+        boost::asio::ip::tcp::resolver resolver{io_context};
+        boost::asio::connect(connection->socket_, resolver.resolve(host, port));
+        connection->socket_.set_option(boost::asio::ip::tcp::no_delay(true));
+
+        const char magic = static_cast<char>(protocol::MAGIC);
+        boost::asio::write(connection->socket_, boost::asio::buffer(&magic, 1));
+
+        boost::asio::co_spawn(connection->strand_, read_replies(connection), boost::asio::detached);
+        return connection;
+    }
+
+    void ClientConnection::close()
+    {
+        boost::asio::post(strand_, [self = shared_from_this()]
+                          { self->fail(boost::asio::error::operation_aborted); });
+    }
+
+    void ClientConnection::submit(std::string frames, std::size_t count, Completion completion)
+    {
+        in_flight_ += count;
+        boost::asio::post(strand_, [self = shared_from_this(), frames = std::move(frames), count, completion = std::move(completion)]() mutable
+                          {
+                              if (count == 0)
+                              {
+                                  completion({}, {});
+                                  return;
+                              }
+                              if (self->broken_)
+                              {
+                                  self->in_flight_ -= count;
+                                  completion(boost::asio::error::not_connected, {});
+                                  return;
+                              }
+                              self->outgoing_.append(frames);
+                              self->pending_.push_back(PendingCommands{count, {}, std::move(completion)});
+                              self->pending_.back().replies.reserve(count);
+                              self->flush(); });
+    }
+
+    void ClientConnection::flush()
+    {
+        if (writing_ || outgoing_.empty())
+        {
+            return;
+        }
+
+        // Commands submitted during this write are sent together by the next one.
+        writing_ = true;
+        writing_buffer_.swap(outgoing_);
+        outgoing_.clear();
+        boost::asio::async_write(socket_, boost::asio::buffer(writing_buffer_),
+                                 boost::asio::bind_executor(strand_, [self = shared_from_this()](const boost::system::error_code &ec, std::size_t)
+                                                            {
+                                                                self->writing_ = false;
+                                                                self->writing_buffer_.clear();
+                                                                if (ec)
+                                                                {
+                                                                    self->fail(ec);
+                                                                    return;
+                                                                }
+                                                                self->flush(); }));
+    }
+
+    boost::asio::awaitable<void> ClientConnection::read_replies(std::shared_ptr<ClientConnection> self)
+    {
+        boost::system::error_code ec;
+        while (!ec)
+        {
+            if (!self->deliver_replies())
+            {
+                ec = boost::asio::error::invalid_argument;
+                break;
+            }
+            self->prepare_block();
+            std::size_t size = co_await self->socket_.async_read_some(boost::asio::buffer(self->block_->data() + self->end_, self->block_->size() - self->end_),
+                                                                      boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            self->end_ += size;
+        }
+        self->fail(ec);
+    }
+
+    bool ClientConnection::deliver_replies()
+    {
+        while (end_ - begin_ >= protocol::HEADER_SIZE)
+        {
+            protocol::FrameHeader header = protocol::decode_header(block_->data() + begin_);
+            if (end_ - begin_ < protocol::HEADER_SIZE + header.length)
+            {
+                break;
+            }
+            auto arguments = protocol::decode_arguments(header, block_->data() + begin_ + protocol::HEADER_SIZE);
+            begin_ += protocol::HEADER_SIZE + header.length;
+
+            ClientReply reply;
+            if (header.opcode == protocol::Opcode::REPLY_OK && arguments.size() == 1)
+            {
+                reply = ClientReply(block_, true, arguments[0], {});
+            }
+            else if (header.opcode == protocol::Opcode::REPLY_ERROR && arguments.size() == 2)
+            {
+                reply = ClientReply(block_, false, arguments[0], arguments[1]);
+            }
+            else if (header.opcode == protocol::Opcode::MESSAGE)
+            {
+                continue;
+            }
+            else
+            {
+                return false;
+            }
+
+            if (pending_.empty())
+            {
+                return false;
+            }
+            auto &front = pending_.front();
+            front.replies.push_back(std::move(reply));
+            if (front.replies.size() == front.count)
+            {
+                PendingCommands completed = std::move(front);
+                pending_.pop_front();
+                in_flight_ -= completed.count;
+                completed.completion({}, std::move(completed.replies));
+            }
+        }
+        return true;
+    }
+
+    void ClientConnection::prepare_block()
+    {
+        // No reply points into the block any more, so it is reused from the start.
+        if (begin_ == end_ && block_.use_count() == 1)
+        {
+            begin_ = end_ = 0;
+        }
+
+        std::size_t needed = protocol::HEADER_SIZE;
+        if (end_ - begin_ >= protocol::HEADER_SIZE)
+        {
+            needed += protocol::decode_header(block_->data() + begin_).length;
+        }
+        if (begin_ + needed <= block_->size() && end_ < block_->size())
+        {
+            return;
+        }
+
+        // The replies handed out keep the old block alive, only the start of the next reply is copied.
+        auto block = std::make_shared<std::string>(std::max(BLOCK_SIZE, needed), '\0');
+        std::copy(block_->data() + begin_, block_->data() + end_, block->data());
+        end_ -= begin_;
+        begin_ = 0;
+        block_ = std::move(block);
+    }
+
+    void ClientConnection::fail(boost::system::error_code ec)
+    {
+        broken_ = true;
+        boost::system::error_code ignored;
+        socket_.close(ignored);
+
+        auto pending = std::move(pending_);
+        pending_.clear();
+        for (auto &&commands : pending)
+        {
+            in_flight_ -= commands.count;
+            commands.completion(ec, {});
+        }
+    }
+
+    ClientPool::ClientPool(boost::asio::io_context &io_context, std::string host, std::string port, std::size_t size)
+        : io_context_{io_context},
+          host_{std::move(host)},
+          port_{std::move(port)},
+          connections_(std::max<std::size_t>(size, 1)) {}
+
+    ClientPool::~ClientPool()
+    {
+        for (auto &&connection : connections_)
+        {
+            if (connection)
+            {
+                connection->close();
+            }
+        }
+    }
+
+    std::shared_ptr<ClientConnection> ClientPool::acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto least_loaded = std::min_element(connections_.begin(), connections_.end(), [](const auto &lhs, const auto &rhs)
+                                             {
+                                                 // Missing and failed connections are replaced first, they have no load.
+                                                 auto load = [](const std::shared_ptr<ClientConnection> &connection)
+                                                 { return connection && !connection->is_broken() ? connection->in_flight() + 1 : 0; };
+                                                 return load(lhs) < load(rhs); });
+        if (!*least_loaded || (*least_loaded)->is_broken())
+        {
+            *least_loaded = ClientConnection::connect(io_context_, host_, port_);
+        }
+        return *least_loaded;
+    }
+}
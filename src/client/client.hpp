@@ -0,0 +1,388 @@
+#pragma once
+
+#include <utility>
+#include <boost/asio.hpp>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <protocol.hpp>
+#include <utils.hpp>
+
+namespace db
+{
+    /**
+     * @brief A reply of the server to a single command.
+     *
+     * The payload and the code are views into the bytes received from the server, nothing is copied. The reply keeps those
+     * bytes alive, so it may outlive the connection.
+     */
+    class ClientReply
+    {
+    private:
+        std::shared_ptr<const std::string> block_;
+        bool success_ = false;
+        std::string_view payload_;
+        std::string_view code_;
+
+    public:
+        ClientReply() = default;
+
+        /**
+         * @brief Constructs a ClientReply object.
+         *
+         * @param block The received bytes the payload and the code point into.
+         * @param success Whether the command succeeded.
+         * @param payload The result of the command, or the error message if it failed.
+         * @param code The error code, empty if the command succeeded.
+         */
+        ClientReply(std::shared_ptr<const std::string> block, bool success, std::string_view payload, std::string_view code);
+
+        /**
+         * @brief Returns whether the command succeeded.
+         */
+        bool success() const { return success_; }
+
+        /**
+         * @brief Returns the result of the command, or the error message if it failed.
+         */
+        std::string_view payload() const { return payload_; }
+
+        /**
+         * @brief Returns the error code, empty if the command succeeded.
+         */
+        std::string_view code() const { return code_; }
+
+        /**
+         * @brief Returns the result of the command.
+         *
+         * Throws a `DatabaseException` with the message and the code of the error if the command failed.
+         */
+        std::string_view value() const;
+    };
+
+    /**
+     * @brief Commands sent to the server with a single write. The replies arrive in the order of the commands.
+     */
+    class CommandBatch
+    {
+    private:
+        /** The commands, encoded as binary protocol frames. */
+        std::string frames_;
+        std::size_t size_ = 0;
+
+    public:
+        /**
+         * @brief Appends a command.
+         *
+         * @param arguments The tokens of the command, e.g. `{"STR", "name", "GET"}`.
+         */
+        void add(std::span<const std::string_view> arguments);
+
+        /**
+         * @brief Appends a command.
+         *
+         * @param arguments The tokens of the command, e.g. `{"STR", "name", "GET"}`.
+         */
+        void add(std::initializer_list<std::string_view> arguments);
+
+        /**
+         * @brief Returns the number of commands.
+         */
+        std::size_t size() const { return size_; }
+
+        /**
+         * @brief Returns whether the batch has no command.
+         */
+        bool empty() const { return size_ == 0; }
+
+        /**
+         * @brief Takes the encoded commands out of the batch, leaving it empty.
+         */
+        std::string release();
+    };
+
+    /**
+     * @brief A persistent connection to the server speaking the binary protocol.
+     *
+     * Commands may be submitted from any thread without waiting for the replies of earlier ones. They are pipelined: commands
+     * submitted while a write is in progress are sent together with the next write, and the replies are matched to the
+     * commands in order. Every asynchronous operation accepts any completion token, e.g. `boost::asio::use_future` or
+     * `boost::asio::use_awaitable`. The IO context passed to `connect()` must be run by at least one thread.
+     *
+     * Messages pushed to a subscribed client are dropped, so the connection must not be used to subscribe to channels.
+     */
+    class ClientConnection : public std::enable_shared_from_this<ClientConnection>
+    {
+    public:
+        /** Completes the commands of a submission with their replies, or with the error that broke the connection. */
+        using Completion = std::function<void(boost::system::error_code, std::vector<ClientReply>)>;
+
+    private:
+        using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
+        /** The minimum size of a block of received bytes. */
+        static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+        /** Commands sent to the server and waiting for their replies. */
+        struct PendingCommands
+        {
+            std::size_t count;
+            std::vector<ClientReply> replies;
+            Completion completion;
+        };
+
+        boost::asio::ip::tcp::socket socket_;
+
+        /** Serializes the writes, the reads and the pending commands. */
+        Strand strand_;
+
+        /** Commands waiting for the write in progress. */
+        std::string outgoing_;
+
+        /** Commands being written. */
+        std::string writing_buffer_;
+
+        bool writing_;
+
+        /** The commands sent or about to be sent, in order. */
+        std::deque<PendingCommands> pending_;
+
+        /** The block the bytes are received into, shared with the replies pointing into it. */
+        std::shared_ptr<std::string> block_;
+
+        /** The received bytes not parsed yet are `[begin_, end_)` of the block. */
+        std::size_t begin_;
+        std::size_t end_;
+
+        /** Whether the connection failed or was closed, which fails every further command. */
+        std::atomic<bool> broken_;
+
+        /** The number of commands submitted and not completed yet. */
+        std::atomic<std::size_t> in_flight_;
+
+    public:
+        /**
+         * @brief Constructs an unconnected ClientConnection object. Use `connect()` instead.
+         *
+         * @param io_context The IO context the connection runs on.
+         */
+        explicit ClientConnection(boost::asio::io_context &io_context);
+
+        /**
+         * @brief Connects to the server.
+         *
+         * Throws a `boost::system::system_error` if the server cannot be reached. The connection lives until it is closed or
+         * the server disconnects.
+         *
+         * @param io_context The IO context the connection runs on.
+         * @param host The host of the server.
+         * @param port The port of the server.
+         */
+        static std::shared_ptr<ClientConnection> connect(boost::asio::io_context &io_context, const std::string &host, const std::string &port);
+
+        /**
+         * @brief Executes the commands of a batch.
+         *
+         * @param batch The commands.
+         * @param token Completed with `void(boost::system::error_code, std::vector<ClientReply>)`. Commands failing on the
+         *              server are reported by their replies, the error code is set only if the connection failed.
+         */
+        template <typename CompletionToken>
+        auto async_execute(CommandBatch batch, CompletionToken &&token)
+        {
+            auto initiation = [self = shared_from_this()](auto handler, CommandBatch batch)
+            {
+                std::size_t count = batch.size();
+                self->submit(batch.release(), count, self->bind_completion(std::move(handler), [](auto &&completion, boost::system::error_code ec, std::vector<ClientReply> replies)
+                                                                           { std::move(completion)(ec, std::move(replies)); }));
+            };
+            return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, std::vector<ClientReply>)>(initiation, token, std::move(batch));
+        }
+
+        /**
+         * @brief Executes a single command.
+         *
+         * @param arguments The tokens of the command, e.g. `{"STR", "name", "GET"}`.
+         * @param token Completed with `void(boost::system::error_code, ClientReply)`.
+         */
+        template <typename CompletionToken>
+        auto async_execute(std::initializer_list<std::string_view> arguments, CompletionToken &&token)
+        {
+            return async_execute(std::span<const std::string_view>(arguments.begin(), arguments.size()), std::forward<CompletionToken>(token));
+        }
+
+        /**
+         * @brief Executes a single command.
+         *
+         * @param arguments The tokens of the command. They are encoded before the function returns.
+         * @param token Completed with `void(boost::system::error_code, ClientReply)`.
+         */
+        template <typename CompletionToken>
+        auto async_execute(std::span<const std::string_view> arguments, CompletionToken &&token)
+        {
+            std::string frame;
+            protocol::encode_frame(frame, protocol::Opcode::COMMAND, arguments);
+            auto initiation = [self = shared_from_this()](auto handler, std::string frame)
+            {
+                self->submit(std::move(frame), 1, self->bind_completion(std::move(handler), [](auto &&completion, boost::system::error_code ec, std::vector<ClientReply> replies)
+                                                                        { std::move(completion)(ec, replies.empty() ? ClientReply{} : std::move(replies.front())); }));
+            };
+            return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, ClientReply)>(initiation, token, std::move(frame));
+        }
+
+        /**
+         * @brief Returns whether the connection failed or was closed.
+         */
+        bool is_broken() const { return broken_; }
+
+        /**
+         * @brief Returns the number of commands submitted and not completed yet.
+         */
+        std::size_t in_flight() const { return in_flight_; }
+
+        /**
+         * @brief Closes the connection. Commands still waiting for their replies fail with `operation_aborted`.
+         */
+        void close();
+
+    private:
+        /**
+         * @brief Sends encoded commands. It may be called from any thread.
+         *
+         * @param frames The commands, encoded as binary protocol frames.
+         * @param count The number of commands.
+         * @param completion Called on the strand once every command got its reply.
+         */
+        void submit(std::string frames, std::size_t count, Completion completion);
+
+        /**
+         * @brief Wraps a completion handler, so it is invoked on its associated executor.
+         *
+         * @param handler The completion handler.
+         * @param deliver Invokes the handler with the replies.
+         */
+        template <typename Handler, typename Deliver>
+        Completion bind_completion(Handler handler, Deliver deliver)
+        {
+            struct PendingCompletion
+            {
+                Handler completion;
+                boost::asio::executor_work_guard<boost::asio::associated_executor_t<Handler, Strand>> work;
+            };
+            auto work = boost::asio::make_work_guard(handler, strand_);
+            auto pending = std::make_shared<PendingCompletion>(PendingCompletion{std::move(handler), std::move(work)});
+            return [pending, deliver](boost::system::error_code ec, std::vector<ClientReply> replies)
+            {
+                boost::asio::post(pending->work.get_executor(), [pending, deliver, ec, replies = std::move(replies)]() mutable
+                                  { deliver(std::move(pending->completion), ec, std::move(replies)); });
+            };
+        }
+
+        /**
+         * @brief Writes the outgoing commands unless a write is in progress.
+         */
+        void flush();
+
+        /**
+         * @brief Reads the replies until the connection fails.
+         *
+         * @param self The connection, kept alive while it reads.
+         */
+        static boost::asio::awaitable<void> read_replies(std::shared_ptr<ClientConnection> self);
+
+        /**
+         * @brief Completes the pending commands with the replies received so far.
+         *
+         * @return False if the server sent a reply nobody waits for.
+         */
+        bool deliver_replies();
+
+        /**
+         * @brief Makes room in the block for the rest of the next reply.
+         */
+        void prepare_block();
+
+        /**
+         * @brief Breaks the connection and fails the pending commands.
+         *
+         * @param ec The error the pending commands fail with.
+         */
+        void fail(boost::system::error_code ec);
+    };
+
+    /**
+     * @brief A fixed number of persistent connections to the server shared by many callers.
+     *
+     * Each command goes to the connection with the fewest commands in flight, so the pool spreads the load without checking
+     * connections out. A connection that failed is replaced the next time it would be chosen.
+     */
+    class ClientPool
+    {
+    private:
+        boost::asio::io_context &io_context_;
+        std::string host_;
+        std::string port_;
+
+        /** Guards `connections_`. */
+        std::mutex mutex_;
+        std::vector<std::shared_ptr<ClientConnection>> connections_;
+
+    public:
+        /**
+         * @brief Constructs a ClientPool object. Connections are opened when they are first needed.
+         *
+         * @param io_context The IO context the connections run on.
+         * @param host The host of the server.
+         * @param port The port of the server.
+         * @param size The number of connections.
+         */
+        ClientPool(boost::asio::io_context &io_context, std::string host, std::string port, std::size_t size);
+
+        /**
+         * @brief Closes every connection.
+         */
+        ~ClientPool();
+
+        /**
+         * @brief Returns the connection with the fewest commands in flight.
+         *
+         * Throws a `boost::system::system_error` if a new connection is needed and the server cannot be reached.
+         */
+        std::shared_ptr<ClientConnection> acquire();
+
+        /**
+         * @brief Executes the commands of a batch on one of the connections, see `ClientConnection::async_execute()`.
+         */
+        template <typename CompletionToken>
+        auto async_execute(CommandBatch batch, CompletionToken &&token)
+        {
+            return acquire()->async_execute(std::move(batch), std::forward<CompletionToken>(token));
+        }
+
+        /**
+         * @brief Executes a single command on one of the connections, see `ClientConnection::async_execute()`.
+         */
+        template <typename CompletionToken>
+        auto async_execute(std::initializer_list<std::string_view> arguments, CompletionToken &&token)
+        {
+            return acquire()->async_execute(arguments, std::forward<CompletionToken>(token));
+        }
+
+        /**
+         * @brief Executes a single command on one of the connections, see `ClientConnection::async_execute()`.
+         */
+        template <typename CompletionToken>
+        auto async_execute(std::span<const std::string_view> arguments, CompletionToken &&token)
+        {
+            return acquire()->async_execute(arguments, std::forward<CompletionToken>(token));
+        }
+    };
+}
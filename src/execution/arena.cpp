@@ -0,0 +1,38 @@
+#include <arena.hpp>
+
+namespace db
+{
+    CommandArena::CommandArena() : resource_{initial_buffer_, sizeof(initial_buffer_)} {}
+
+    CommandArena::ThreadScope &CommandArena::current()
+    {
+        thread_local ThreadScope scope;
+        return scope;
+    }
+
+    std::pmr::memory_resource *CommandArena::resource()
+    {
+        ThreadScope &scope = current();
+        if (!scope.active)
+        {
+            return std::pmr::get_default_resource();
+        }
+        if (!scope.arena)
+        {
+            scope.arena = boost::make_shared<CommandArena>();
+        }
+        return &scope.arena->resource_;
+    }
+
+    CommandArena::Scope::Scope() : previous_active_{current().active}, previous_arena_{std::move(current().arena)}
+    {
+        current().active = true;
+        current().arena.reset();
+    }
+
+    CommandArena::Scope::~Scope()
+    {
+        current().active = previous_active_;
+        current().arena = std::move(previous_arena_);
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+namespace db
+{
+    /**
+     * @brief Memory the commands of a single request are allocated from.
+     *
+     * The commands of a request are built together and released together, so their memory is carved from one buffer and
+     * never freed individually: a whole batch of commands costs one heap allocation instead of one per command. Every
+     * command holds a reference to the arena, which is freed with the last command of the request, even if a command
+     * outlives the request, e.g. a blocking pop waiting for an item. The keys and values a command holds are allocated from
+     * its arena as well, see `resource()`, so parsing a command does not allocate from the heap.
+     *
+     * The arena is only allocated from by the thread building the commands, see `CommandArena::Scope`.
+     */
+    class CommandArena
+    {
+    public:
+        /** The size of the buffer allocated with the arena, enough for a few dozen commands. */
+        static constexpr std::size_t INITIAL_SIZE = 4096;
+
+        /**
+         * @brief Allocates objects from a CommandArena, keeping the arena alive. Deallocation does nothing, the memory is
+         * reclaimed with the arena.
+         */
+        template <typename T>
+        class Allocator
+        {
+        private:
+            template <typename U>
+            friend class Allocator;
+
+            boost::shared_ptr<CommandArena> arena_;
+
+        public:
+            using value_type = T;
+
+            explicit Allocator(boost::shared_ptr<CommandArena> arena) : arena_{std::move(arena)} {}
+
+            template <typename U>
+            Allocator(const Allocator<U> &other) : arena_{other.arena_} {}
+
+            T *allocate(std::size_t n)
+            {
+                return static_cast<T *>(arena_->resource_.allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T *, std::size_t) {}
+
+            template <typename U>
+            bool operator==(const Allocator<U> &other) const { return arena_ == other.arena_; }
+        };
+
+        /**
+         * @brief Makes the commands built by the calling thread come from a new arena for as long as the scope lives. The
+         * arena is allocated with the first command.
+         *
+         * The scope must not be held across a suspension point of a coroutine, another request could be parsed on the same
+         * thread meanwhile.
+         */
+        class Scope
+        {
+        private:
+            bool previous_active_;
+            boost::shared_ptr<CommandArena> previous_arena_;
+
+        public:
+            Scope();
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+        };
+
+    private:
+        /** The innermost scope of a thread. */
+        struct ThreadScope
+        {
+            bool active = false;
+
+            /** Null until the first command of the scope is built. */
+            boost::shared_ptr<CommandArena> arena;
+        };
+
+        std::byte initial_buffer_[INITIAL_SIZE];
+        std::pmr::monotonic_buffer_resource resource_;
+
+        /**
+         * @brief Returns the innermost scope of the calling thread.
+         */
+        static ThreadScope &current();
+
+    public:
+        CommandArena();
+
+        CommandArena(const CommandArena &) = delete;
+        CommandArena &operator=(const CommandArena &) = delete;
+
+        /**
+         * @brief Returns the memory resource of the arena of the calling thread, or the default resource outside of a
+         * `Scope`.
+         *
+         * Only the members of an object created by `make()` may be allocated from it, the object keeps the arena alive.
+         */
+        static std::pmr::memory_resource *resource();
+
+        /**
+         * @brief Creates an object in the arena of the calling thread, or on the heap outside of a `Scope`.
+         *
+         * @param args The arguments of the constructor.
+         * @return A shared pointer to the object.
+         */
+        template <typename T, typename... Args>
+        static boost::shared_ptr<T> make(Args &&...args)
+        {
+            ThreadScope &scope = current();
+            if (!scope.active)
+            {
+                return boost::make_shared<T>(std::forward<Args>(args)...);
+            }
+            if (!scope.arena)
+            {
+                scope.arena = boost::make_shared<CommandArena>();
+            }
+            return boost::allocate_shared<T>(Allocator<T>{scope.arena}, std::forward<Args>(args)...);
+        }
+    };
+}
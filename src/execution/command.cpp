@@ -1,16 +1,48 @@
 #include <command.hpp>
+#include <dispatch.hpp>
+#include <arena.hpp>
 #include <string>
+#include <utility>
 #include <vector>
 #include <repository.hpp>
+#include <channels.hpp>
+#include <replication_log.hpp>
+#include <cluster.hpp>
+#include <metrics.hpp>
+#include <protocol.hpp>
 #include <sstream>
+#include <boost/asio.hpp>
 #include <boost/lexical_cast.hpp>
 #include <iostream>
 
 namespace db
 {
+    namespace
+    {
+      /**
+       * Runs a streaming command and returns everything it wrote.
+       */
+      std::string collect_result(Command &command)
+      {
+        std::string result;
+        StringSink sink{result};
+        command.execute_into(sink);
+        return result;
+      }
+
+      /**
+       * Writes an element of a listed collection, in the `[ a b ]` format of the replies.
+       */
+      void append_element(ResultSink &sink, const std::string &element)
+      {
+        sink.append(element);
+        sink.append(" ");
+      }
+    }
+
     // STRING
 
-  CreateStringCommand::CreateStringCommand(const std::string &string_name, const std::string &value) : KeyedCommand{string_name}, value_{value} {}
+  CreateStringCommand::CreateStringCommand(std::string_view string_name, std::string_view value) : KeyedCommand{string_name}, value_(value, CommandArena::resource()) {}
 
   std::string CreateStringCommand::execute()
   {
@@ -18,14 +50,29 @@ namespace db
     return "OK";
   }
 
-  StringGetCommand::StringGetCommand(const std::string &str_name) : KeyedCommand(str_name) {}
+    CommandType CreateStringCommand::type() const
+    {
+      return CommandType::CREATE_STRING;
+    }
+
+  StringGetCommand::StringGetCommand(std::string_view str_name) : KeyedCommand(str_name) {}
 
   std::string StringGetCommand::execute()
   {
     return StringRepository::get_instance().get(key_name_);
     }
 
-  StringExistsCommand::StringExistsCommand(const std::string &str_name) : KeyedCommand(str_name) {}
+    CommandType StringGetCommand::type() const
+    {
+      return CommandType::STRING_GET;
+    }
+
+    bool StringGetCommand::is_read_only() const
+    {
+      return true;
+    }
+
+  StringExistsCommand::StringExistsCommand(std::string_view str_name) : KeyedCommand(str_name) {}
 
   std::string StringExistsCommand::execute()
   {
@@ -34,14 +81,34 @@ namespace db
         return ss.str();
     }
 
-  StringLenCommand::StringLenCommand(const std::string &str_name) : KeyedCommand(str_name) {}
+    CommandType StringExistsCommand::type() const
+    {
+      return CommandType::STRING_EXISTS;
+    }
+
+    bool StringExistsCommand::is_read_only() const
+    {
+      return true;
+    }
+
+  StringLenCommand::StringLenCommand(std::string_view str_name) : KeyedCommand(str_name) {}
 
   std::string StringLenCommand::execute()
   {
     return std::to_string(StringRepository::get_instance().length(key_name_));
     }
 
-  StringSubCommand::StringSubCommand(const std::string &str_name, uint start_pos, uint end_pos)
+    CommandType StringLenCommand::type() const
+    {
+      return CommandType::STRING_LEN;
+    }
+
+    bool StringLenCommand::is_read_only() const
+    {
+      return true;
+    }
+
+  StringSubCommand::StringSubCommand(std::string_view str_name, uint start_pos, uint end_pos)
     : KeyedCommand(str_name), start_pos_(start_pos), end_pos_(end_pos) {}
 
   std::string StringSubCommand::execute()
@@ -49,8 +116,18 @@ namespace db
     return StringRepository::get_instance().substring(key_name_, start_pos_, end_pos_);
   }
 
-  StringAppendCommand::StringAppendCommand(const std::string &str_name, const std::string &value)
-    : KeyedCommand(str_name), value_(value) {}
+    CommandType StringSubCommand::type() const
+    {
+      return CommandType::STRING_SUB;
+    }
+
+    bool StringSubCommand::is_read_only() const
+    {
+      return true;
+    }
+
+  StringAppendCommand::StringAppendCommand(std::string_view str_name, std::string_view value)
+    : KeyedCommand(str_name), value_(value, CommandArena::resource()) {}
 
   std::string StringAppendCommand::execute()
   {
@@ -58,8 +135,13 @@ namespace db
     return "OK";
   }
 
-  StringPrependCommand::StringPrependCommand(const std::string &str_name, const std::string &value)
-    : KeyedCommand(str_name), value_(value) {}
+    CommandType StringAppendCommand::type() const
+    {
+      return CommandType::STRING_APPEND;
+    }
+
+  StringPrependCommand::StringPrependCommand(std::string_view str_name, std::string_view value)
+    : KeyedCommand(str_name), value_(value, CommandArena::resource()) {}
 
   std::string StringPrependCommand::execute()
   {
@@ -67,8 +149,13 @@ namespace db
     return "OK";
   }
 
-  StringInsertCommand::StringInsertCommand(const std::string &str_name, uint pos, const std::string &value)
-    : KeyedCommand(str_name), pos_(pos), value_(value) {}
+    CommandType StringPrependCommand::type() const
+    {
+      return CommandType::STRING_PREPEND;
+    }
+
+  StringInsertCommand::StringInsertCommand(std::string_view str_name, uint pos, std::string_view value)
+    : KeyedCommand(str_name), pos_(pos), value_(value, CommandArena::resource()) {}
 
   std::string StringInsertCommand::execute()
   {
@@ -76,7 +163,12 @@ namespace db
     return "OK";
   }
 
-  StringTrimCommand::StringTrimCommand(const std::string &str_name, uint start_pos, uint end_pos)
+    CommandType StringInsertCommand::type() const
+    {
+      return CommandType::STRING_INSERT;
+    }
+
+  StringTrimCommand::StringTrimCommand(std::string_view str_name, uint start_pos, uint end_pos)
     : KeyedCommand(str_name), start_pos_(start_pos), end_pos_(end_pos) {}
 
   std::string StringTrimCommand::execute()
@@ -85,7 +177,12 @@ namespace db
     return "OK";
   }
 
-  StringLtrimCommand::StringLtrimCommand(const std::string &str_name, uint char_count)
+    CommandType StringTrimCommand::type() const
+    {
+      return CommandType::STRING_TRIM;
+    }
+
+  StringLtrimCommand::StringLtrimCommand(std::string_view str_name, uint char_count)
     : KeyedCommand(str_name), char_count_(char_count) {}
 
   std::string StringLtrimCommand::execute()
@@ -94,7 +191,12 @@ namespace db
     return "OK";
   }
 
-  StringRtrimCommand::StringRtrimCommand(const std::string &str_name, uint char_count)
+    CommandType StringLtrimCommand::type() const
+    {
+      return CommandType::STRING_LTRIM;
+    }
+
+  StringRtrimCommand::StringRtrimCommand(std::string_view str_name, uint char_count)
     : KeyedCommand(str_name), char_count_(char_count) {}
 
   std::string StringRtrimCommand::execute()
@@ -103,29 +205,91 @@ namespace db
     return "OK";
   }
 
-  boost::shared_ptr<Command> CreateCommandFactory::create_command(const std::vector<std::string> &input)
+    CommandType StringRtrimCommand::type() const
     {
-        std::vector<std::string> new_command(input.begin() + 1, input.end());
-        if (!children_factories_.contains(input[0]))
+      return CommandType::STRING_RTRIM;
+    }
+
+  boost::shared_ptr<Command> GenericCommandFactory::create_command(std::span<std::string_view> input)
+  {
+        const dispatch::Group *group = dispatch::GROUPS.find(input[0]);
+        if (group == nullptr)
         {
-            throw DatabaseException("Unknown command: " + input[0], "CMD_UNKNOWN");
+            throw DatabaseException("Unknown command: " + std::string{input[0]}, "CMD_UNKNOWN");
+        }
+        if (group->layout == dispatch::Layout::SINGLE)
+        {
+            return factories_[static_cast<std::size_t>(group->type)]->get_command(input.subspan(1));
         }
-        return children_factories_[input[0]]->get_command(new_command);
-  }
-
-  CreateCommandFactory::CreateCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-  boost::shared_ptr<Command> GenericCommandFactory::create_command(const std::vector<std::string> &input)
-  {
-    std::vector<std::string> new_command(input.begin() + 1, input.end());
-        if (!children_factories_.contains(input[0]))
+        ArgumentsCountValidator{group->arity}.validate(input.subspan(1));
+        std::size_t verb = group->layout == dispatch::Layout::KEYED ? 2 : 1;
+        const dispatch::Route *route = dispatch::ROUTES.find(input[0], input[verb]);
+        if (route == nullptr)
         {
-            throw DatabaseException("Unknown command: " + input[0], "CMD_UNKNOWN");
+            throw DatabaseException("Unknown command: " + std::string{input[verb]}, "CMD_UNKNOWN");
         }
-        return children_factories_[input[0]]->get_command(new_command);
-  }
+        if (group->layout == dispatch::Layout::KEYED)
+        {
+            // [GROUP, name, VERB, args...] -> [GROUP, VERB, name, args...], so the factory gets [name, args...] without copying the tokens.
+            std::swap(input[1], input[2]);
+        }
+        return factories_[static_cast<std::size_t>(route->type)]->get_command(input.subspan(2));
+    }
 
-  GenericCommandFactory::GenericCommandFactory(const boost::shared_ptr<Validator> &validator) : CommandFactory(validator) {}
+  GenericCommandFactory::GenericCommandFactory(const boost::shared_ptr<Validator> &validator) : CommandFactory(validator)
+  {
+        auto add = [this](CommandType type, boost::shared_ptr<CommandFactory> factory)
+        {
+            factories_[static_cast<std::size_t>(type)] = std::move(factory);
+        };
+        add(CommandType::CREATE_STRING, boost::make_shared<CreateStringCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::CREATE_SET, boost::make_shared<CreateSetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::CREATE_HASH, boost::make_shared<CreateHashCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::CREATE_QUEUE, boost::make_shared<CreateQueueCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::STRING_EXISTS, boost::make_shared<StringExistsCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::STRING_GET, boost::make_shared<StringGetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::STRING_LEN, boost::make_shared<StringLenCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::STRING_SUB, boost::make_shared<StringSubCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3)));
+        add(CommandType::STRING_APPEND, boost::make_shared<StringAppendCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::STRING_PREPEND, boost::make_shared<StringPrependCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::STRING_INSERT, boost::make_shared<StringInsertCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3)));
+        add(CommandType::STRING_TRIM, boost::make_shared<StringTrimCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3)));
+        add(CommandType::STRING_LTRIM, boost::make_shared<StringLtrimCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::STRING_RTRIM, boost::make_shared<StringRtrimCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::SET_ADD, boost::make_shared<SetAddCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::SET_LEN, boost::make_shared<SetLenCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::SET_INTER, boost::make_shared<SetIntersectionCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::SET_DIFF, boost::make_shared<SetDifferenceCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::SET_UNION, boost::make_shared<SetUnionCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::SET_CONTAINS, boost::make_shared<SetContainsCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::SET_GETALL, boost::make_shared<SetGetAllCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::SET_POP, boost::make_shared<SetPopCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::QUEUE_PUSH, boost::make_shared<QueuePushCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::QUEUE_POP, boost::make_shared<QueuePopCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::QUEUE_BPOP, boost::make_shared<QueueBlockingPopCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::HASH_DEL, boost::make_shared<HashDelCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::HASH_EXISTS, boost::make_shared<HashExistsCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::HASH_GET, boost::make_shared<HashGetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::HASH_GETALL, boost::make_shared<HashGetAllCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::HASH_GETKEYS, boost::make_shared<HashGetKeysCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::HASH_SET, boost::make_shared<HashSetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3)));
+        add(CommandType::HASH_LEN, boost::make_shared<HashLenCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::HASH_SEARCH, boost::make_shared<HashSearchCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::CLUSTER_KEYSLOT, boost::make_shared<ClusterKeySlotCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::CLUSTER_SLOTS, boost::make_shared<ClusterSlotsCommandFactory>(boost::make_shared<ArgumentsCountValidator>(0)));
+        add(CommandType::CLUSTER_SETSLOT, boost::make_shared<ClusterSetSlotCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::CLUSTER_GETKEYSINSLOT, boost::make_shared<ClusterGetKeysInSlotCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::DEL, boost::make_shared<DeleteCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::KEYS, boost::make_shared<KeysCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::SUBSCRIBE, boost::make_shared<SubscribeCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1)));
+        add(CommandType::UNSUBSCRIBE, boost::make_shared<UnsubscribeCommandFactory>(boost::make_shared<ArgumentsCountValidator>(0)));
+        add(CommandType::PUBLISH, boost::make_shared<PublishCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::REPLSYNC, boost::make_shared<ReplicaSyncCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::ASKING, boost::make_shared<AskingCommandFactory>(boost::make_shared<ArgumentsCountValidator>(0)));
+        add(CommandType::MIGRATE, boost::make_shared<MigrateCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2)));
+        add(CommandType::INFO, boost::make_shared<InfoCommandFactory>(boost::make_shared<ArgumentsCountValidator>(0)));
+    }
 
   CommandFactory &GenericCommandFactory::get_instance()
   {
@@ -141,83 +305,918 @@ namespace db
     return "OK";
   }
 
-  CreateSetCommand::CreateSetCommand(const std::string &set_name) : KeyedCommand{set_name} {}
+    CommandType CreateSetCommand::type() const
+    {
+      return CommandType::CREATE_SET;
+    }
+
+  CreateSetCommand::CreateSetCommand(std::string_view set_name) : KeyedCommand{set_name} {}
+
+    SetAddCommand::SetAddCommand(std::string_view set_name, std::string_view value) : KeyedCommand(set_name), value_(value, CommandArena::resource()) {}
+
+    std::string SetAddCommand::execute()
+    {
+      SetRepository::get_instance().add(key_name_, value_);
+      return "OK";
+    }
+
+    CommandType SetAddCommand::type() const
+    {
+      return CommandType::SET_ADD;
+    }
+
+    SetLenCommand::SetLenCommand(std::string_view set_name) : KeyedCommand(set_name) {}
+
+    std::string SetLenCommand::execute()
+    {
+      return std::to_string(SetRepository::get_instance().len(key_name_));
+    }
+
+    CommandType SetLenCommand::type() const
+    {
+      return CommandType::SET_LEN;
+    }
+
+    bool SetLenCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    SetIntersectionCommand::SetIntersectionCommand(std::span<const std::string_view> set_names)
+        : set_names_(set_names.begin(), set_names.end(), CommandArena::resource()) {}
+
+    std::string SetIntersectionCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void SetIntersectionCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      SetRepository::get_instance().intersection(set_names_, [&](const std::string &element)
+                                                { append_element(sink, element); });
+      sink.append("]");
+    }
+
+    CommandType SetIntersectionCommand::type() const
+    {
+      return CommandType::SET_INTER;
+    }
+
+    bool SetIntersectionCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane SetIntersectionCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    std::span<const std::pmr::string> SetIntersectionCommand::keys() const
+    {
+      return set_names_;
+    }
+
+    SetDifferenceCommand::SetDifferenceCommand(std::string_view set_name_1, std::string_view set_name_2) : set_names_{std::pmr::string{set_name_1, CommandArena::resource()}, std::pmr::string{set_name_2, CommandArena::resource()}} {}
+
+    std::string SetDifferenceCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void SetDifferenceCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      SetRepository::get_instance().difference(set_names_[0], set_names_[1], [&](const std::string &element)
+                                                { append_element(sink, element); });
+      sink.append("]");
+    }
+
+    CommandType SetDifferenceCommand::type() const
+    {
+      return CommandType::SET_DIFF;
+    }
+
+    bool SetDifferenceCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane SetDifferenceCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    std::span<const std::pmr::string> SetDifferenceCommand::keys() const
+    {
+      return set_names_;
+    }
+
+    SetUnionCommand::SetUnionCommand(std::span<const std::string_view> set_names)
+        : set_names_(set_names.begin(), set_names.end(), CommandArena::resource()) {}
+
+    std::string SetUnionCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void SetUnionCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      SetRepository::get_instance().union_(set_names_, [&](const std::string &element)
+                                          { append_element(sink, element); });
+      sink.append("]");
+    }
+
+    CommandType SetUnionCommand::type() const
+    {
+      return CommandType::SET_UNION;
+    }
+
+    bool SetUnionCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane SetUnionCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    std::span<const std::pmr::string> SetUnionCommand::keys() const
+    {
+      return set_names_;
+    }
+
+    SetContainsCommand::SetContainsCommand(std::string_view set_name, std::string_view value) : KeyedCommand(set_name), value_(value, CommandArena::resource()) {}
+
+    std::string SetContainsCommand::execute()
+    {
+      std::stringstream ss;
+      ss << std::boolalpha << SetRepository::get_instance().contains(key_name_, value_);
+        return ss.str();
+    }
+
+    CommandType SetContainsCommand::type() const
+    {
+      return CommandType::SET_CONTAINS;
+    }
+
+    bool SetContainsCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    SetGetAllCommand::SetGetAllCommand(std::string_view set_name) : KeyedCommand(set_name) {}
+
+    std::string SetGetAllCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void SetGetAllCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      SetRepository::get_instance().get_all(key_name_, [&](const std::string &element)
+                                           { append_element(sink, element); });
+      sink.append("]");
+    }
+
+    CommandType SetGetAllCommand::type() const
+    {
+      return CommandType::SET_GETALL;
+    }
+
+    bool SetGetAllCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane SetGetAllCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    SetPopCommand::SetPopCommand(std::string_view set_name, std::string_view value) : KeyedCommand(set_name), value_(value, CommandArena::resource()) {}
+
+    std::string SetPopCommand::execute()
+    {
+      return SetRepository::get_instance().pop(key_name_, value_);
+    }
 
-    SetAddCommand::SetAddCommand(const std::string &set_name, const std::string &value) : KeyedCommand(set_name), value_(value) {}
+    CommandType SetPopCommand::type() const
+    {
+      return CommandType::SET_POP;
+    }
+
+    // QUEUES
+
+    CreateQueueCommand::CreateQueueCommand(std::string_view queue_name) : KeyedCommand{queue_name} {}
+
+    std::string CreateQueueCommand::execute()
+    {
+      QueueRepository::get_instance().create(key_name_);
+        return "OK";
+    }
+
+    CommandType CreateQueueCommand::type() const
+    {
+      return CommandType::CREATE_QUEUE;
+    }
+
+    bool CreateQueueCommand::is_replicated() const
+    {
+      return false;
+    }
+
+    QueuePushCommand::QueuePushCommand(std::string_view queue_name, std::string_view value) : KeyedCommand(queue_name), value_(value, CommandArena::resource()) {}
+
+    std::string QueuePushCommand::execute()
+    {
+      QueueRepository::get_instance().push(key_name_, value_);
+      return "OK";
+    }
+
+    CommandType QueuePushCommand::type() const
+    {
+      return CommandType::QUEUE_PUSH;
+    }
+
+    bool QueuePushCommand::is_replicated() const
+    {
+      return false;
+    }
+
+    QueuePopCommand::QueuePopCommand(std::string_view queue_name) : KeyedCommand(queue_name) {}
+
+    std::string QueuePopCommand::execute()
+    {
+      return QueueRepository::get_instance().pop(key_name_);
+    }
+
+    CommandType QueuePopCommand::type() const
+    {
+      return CommandType::QUEUE_POP;
+    }
+
+    bool QueuePopCommand::is_replicated() const
+    {
+      return false;
+    }
+
+    QueueBlockingPopCommand::QueueBlockingPopCommand(std::string_view queue_name, std::chrono::milliseconds timeout) : KeyedCommand(queue_name), timeout_(timeout) {}
+
+    std::string QueueBlockingPopCommand::execute()
+    {
+      throw DatabaseException("BPOP can only be executed asynchronously", "CMD_ASYNC");
+    }
+
+    CommandType QueueBlockingPopCommand::type() const
+    {
+      return CommandType::QUEUE_BPOP;
+    }
+
+    bool QueueBlockingPopCommand::is_replicated() const
+    {
+      return false;
+    }
+
+    void QueueBlockingPopCommand::execute_async(CommandCompletion completion)
+    {
+      completion_ = std::move(completion);
+      waiter_ = std::make_shared<QueueWaiter>([completion = completion_, name = std::string(key_name_)](std::optional<std::string> value)
+                                              {
+                                                if (value)
+                                                {
+                                                  completion(std::move(*value), nullptr);
+                                                  return;
+                                                }
+                                                completion({}, std::make_exception_ptr(DatabaseException(name + " does not exist", "KEY_NOT_FOUND"))); });
+
+      std::optional<std::string> value;
+      try
+      {
+        auto migration = ClusterState::get_instance().lock_write(keys());
+        auto write = GlobalRepository::get_instance().lock_write();
+        value = QueueRepository::get_instance().pop_or_wait(key_name_, waiter_);
+        if (value)
+        {
+          waiter_->try_claim();
+          completion_(std::move(*value), nullptr);
+        }
+      }
+      catch (...)
+      {
+        // The waiter was not registered, claiming it makes a later cancel() a no-op.
+        waiter_->try_claim();
+        completion_({}, std::current_exception());
+      }
+
+      // A cancel() arriving meanwhile only left a note, the waiter was not registered yet when it was called.
+      bool cancelled = false;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        started_ = true;
+        cancelled = cancel_pending_;
+      }
+      if (cancelled)
+      {
+        cancel();
+      }
+    }
+
+    std::chrono::milliseconds QueueBlockingPopCommand::timeout() const
+    {
+      return timeout_;
+    }
+
+    void QueueBlockingPopCommand::cancel()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_)
+        {
+          cancel_pending_ = true;
+          return;
+        }
+      }
+      if (waiter_ && waiter_->try_claim())
+      {
+        QueueRepository::get_instance().cancel_wait(key_name_, waiter_);
+        completion_({}, std::make_exception_ptr(DatabaseException("Queue is empty", "QUEUE_EMPTY")));
+      }
+    }
+
+    // HASHES
+
+    std::string CreateHashCommand::execute()
+    {
+        HashRepository::get_instance().create(key_name_);
+        return "OK";
+    }
+
+    CommandType CreateHashCommand::type() const
+    {
+      return CommandType::CREATE_HASH;
+    }
+
+    CreateHashCommand::CreateHashCommand(std::string_view hash_name) : KeyedCommand{hash_name} {}
+
+    HashDelCommand::HashDelCommand(std::string_view hash_name, std::string_view hash_key) : KeyedCommand(hash_name), hash_key_(hash_key, CommandArena::resource()) {}
+
+    std::string HashDelCommand::execute()
+    {
+      HashRepository::get_instance().del(key_name_, hash_key_);
+      return "OK";
+    }
+
+    CommandType HashDelCommand::type() const
+    {
+      return CommandType::HASH_DEL;
+    }
+
+    HashExistsCommand::HashExistsCommand(std::string_view hash_name, std::string_view hash_key) : KeyedCommand(hash_name), hash_key_(hash_key, CommandArena::resource()) {}
+
+    std::string HashExistsCommand::execute()
+    {
+      std::stringstream ss;
+      ss << std::boolalpha << HashRepository::get_instance().exists(key_name_, hash_key_);
+        return ss.str();
+    }
+
+    CommandType HashExistsCommand::type() const
+    {
+      return CommandType::HASH_EXISTS;
+    }
+
+    bool HashExistsCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    HashGetCommand::HashGetCommand(std::string_view hash_name, std::string_view hash_key) : KeyedCommand(hash_name), hash_key_(hash_key, CommandArena::resource()) {}
+
+    std::string HashGetCommand::execute()
+    {
+      return HashRepository::get_instance().get(key_name_, hash_key_);
+    }
+
+    CommandType HashGetCommand::type() const
+    {
+      return CommandType::HASH_GET;
+    }
+
+    bool HashGetCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    HashGetAllCommand::HashGetAllCommand(std::string_view hash_name) : KeyedCommand(hash_name) {}
+
+    std::string HashGetAllCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void HashGetAllCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      HashRepository::get_instance().get_all(key_name_, [&](const std::string &key, const std::string &value)
+                                            {
+                                              sink.append("{");
+                                              sink.append(key);
+                                              sink.append(" : ");
+                                              sink.append(value);
+                                              sink.append("} "); });
+      sink.append("]");
+    }
+
+    CommandType HashGetAllCommand::type() const
+    {
+      return CommandType::HASH_GETALL;
+    }
+
+    bool HashGetAllCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane HashGetAllCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    HashKeysCommand::HashKeysCommand(std::string_view hash_name) : KeyedCommand(hash_name) {}
+
+    std::string HashKeysCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void HashKeysCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      HashRepository::get_instance().get_keys(key_name_, [&](const std::string &element)
+                                             { append_element(sink, element); });
+      sink.append("]");
+    }
+
+    CommandType HashKeysCommand::type() const
+    {
+      return CommandType::HASH_GETKEYS;
+    }
+
+    bool HashKeysCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane HashKeysCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    HashSetCommand::HashSetCommand(std::string_view hash_name, std::string_view hash_key, std::string_view hash_value) : KeyedCommand(hash_name), hash_key_(hash_key, CommandArena::resource()), hash_value_(hash_value, CommandArena::resource()) {}
+
+    std::string HashSetCommand::execute()
+    {
+      HashRepository::get_instance().set(key_name_, hash_key_, hash_value_);
+      return "OK";
+    }
+
+    CommandType HashSetCommand::type() const
+    {
+      return CommandType::HASH_SET;
+    }
+
+    HashLenCommand::HashLenCommand(std::string_view hash_name) : KeyedCommand(hash_name) {}
+
+    std::string HashLenCommand::execute()
+    {
+      return std::to_string(HashRepository::get_instance().len(key_name_));
+    }
+
+    CommandType HashLenCommand::type() const
+    {
+      return CommandType::HASH_LEN;
+    }
+
+    bool HashLenCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    HashSearchCommand::HashSearchCommand(std::string_view hash_name, std::string_view query) : KeyedCommand(hash_name), query_(query, CommandArena::resource()) {}
+
+    std::string HashSearchCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void HashSearchCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      HashRepository::get_instance().search(key_name_, query_, [&](const std::string &element)
+                                           { append_element(sink, element); });
+      sink.append("]");
+    }
+
+    CommandType HashSearchCommand::type() const
+    {
+      return CommandType::HASH_SEARCH;
+    }
+
+    bool HashSearchCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane HashSearchCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    // OTHER
+
+    KeysCommand::KeysCommand(std::optional<std::string_view> pattern)
+    {
+      if (pattern)
+      {
+        pattern_.emplace(*pattern, CommandArena::resource());
+      }
+    }
+
+    std::string KeysCommand::execute()
+    {
+      return collect_result(*this);
+    }
+
+    void KeysCommand::execute_into(ResultSink &sink)
+    {
+      sink.append("[ ");
+      GlobalRepository::get_instance().keys(pattern_ ? std::string_view{*pattern_} : std::string_view{}, [&](const std::string &element)
+                                           { append_element(sink, element); });
+      sink.append("]");
+    }
+
+    CommandType KeysCommand::type() const
+    {
+      return CommandType::KEYS;
+    }
+
+    bool KeysCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane KeysCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    DelCommand::DelCommand(std::string_view key) : KeyedCommand(key) {}
+
+    std::string DelCommand::execute()
+    {
+      GlobalRepository::get_instance().del(key_name_);
+        return "OK";
+    }
+
+    CommandType DelCommand::type() const
+    {
+      return CommandType::DEL;
+    }
+
+    // CHANNELS
+
+    SubscribeCommand::SubscribeCommand(std::vector<std::string> channels) : channels_(std::move(channels)) {}
+
+    std::string SubscribeCommand::execute()
+    {
+      throw DatabaseException("SUBSCRIBE can only be executed for a connection", "CMD_SESSION");
+    }
+
+    CommandType SubscribeCommand::type() const
+    {
+      return CommandType::SUBSCRIBE;
+    }
+
+    bool SubscribeCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    std::string SubscribeCommand::execute_in(Session &session)
+    {
+      std::size_t count = 0;
+      for (const auto &channel : channels_)
+      {
+        count = session.subscribe(channel);
+      }
+      return std::to_string(count);
+    }
+
+    UnsubscribeCommand::UnsubscribeCommand(std::vector<std::string> channels) : channels_(std::move(channels)) {}
+
+    std::string UnsubscribeCommand::execute()
+    {
+      throw DatabaseException("UNSUBSCRIBE can only be executed for a connection", "CMD_SESSION");
+    }
+
+    CommandType UnsubscribeCommand::type() const
+    {
+      return CommandType::UNSUBSCRIBE;
+    }
+
+    bool UnsubscribeCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    std::string UnsubscribeCommand::execute_in(Session &session)
+    {
+      if (channels_.empty())
+      {
+        session.unsubscribe_all();
+        return "0";
+      }
+
+      std::size_t count = 0;
+      for (const auto &channel : channels_)
+      {
+        count = session.unsubscribe(channel);
+      }
+      return std::to_string(count);
+    }
+
+    PublishCommand::PublishCommand(std::string_view channel, std::string_view payload) : channel_(channel), payload_(payload) {}
+
+    std::string PublishCommand::execute()
+    {
+      return std::to_string(ChannelRegistry::get_instance().publish(channel_, std::move(payload_)));
+    }
+
+    CommandType PublishCommand::type() const
+    {
+      return CommandType::PUBLISH;
+    }
+
+    bool PublishCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    ExecutionLane PublishCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
+    }
+
+    // REPLICATION
+
+    ReplicaSyncCommand::ReplicaSyncCommand(std::string_view primary_id, std::string_view offset) : primary_id_(primary_id), offset_(offset) {}
+
+    std::string ReplicaSyncCommand::execute()
+    {
+      throw DatabaseException("REPLSYNC can only be executed for a connection", "CMD_SESSION");
+    }
+
+    CommandType ReplicaSyncCommand::type() const
+    {
+      return CommandType::REPLSYNC;
+    }
+
+    std::string ReplicaSyncCommand::execute_in(Session &session)
+    {
+      auto &log = ReplicationLog::get_instance();
+      if (!log.enabled())
+      {
+        throw DatabaseException("Replication is not enabled", "REPL_DISABLED");
+      }
+
+      std::uint64_t offset = boost::lexical_cast<std::uint64_t>(offset_);
+      if (log.can_continue(primary_id_, offset))
+      {
+        session.follow_replication_log(offset);
+        return "CONTINUE " + log.id() + " " + std::to_string(offset);
+      }
+
+      session.follow_snapshot();
+      return "FULL " + log.id();
+    }
+
+    bool ReplicaSyncCommand::is_read_only() const
+    {
+      return true;
+    }
+
+    // CLUSTER
+
+    namespace
+    {
+      /**
+       * Returns the commands recreating a key on another node and removes the items of a queue, which cannot be read
+       * without being popped. Every kind of value is read with a single lookup, the caller holds off the writes to the key.
+       */
+      std::vector<std::vector<std::string>> dump_key(const std::string &key, std::vector<std::string> &queue_items)
+      {
+        std::vector<std::vector<std::string>> commands;
+        try
+        {
+          commands.push_back({"CREATE", "STR", key, StringRepository::get_instance().get(key)});
+          return commands;
+        }
+        catch (const DatabaseException &)
+        {
+        }
+        // The lookups throw before visiting anything if the key holds another kind of value.
+        try
+        {
+          commands.push_back({"CREATE", "SET", key});
+          SetRepository::get_instance().get_all(key, [&](const std::string &member)
+                                                { commands.push_back({"SET", key, "ADD", member}); });
+          return commands;
+        }
+        catch (const DatabaseException &)
+        {
+          commands.clear();
+        }
+        try
+        {
+          commands.push_back({"CREATE", "HASH", key});
+          HashRepository::get_instance().get_all(key, [&](const std::string &field, const std::string &value)
+                                                 { commands.push_back({"HASH", key, "SET", field, value}); });
+          return commands;
+        }
+        catch (const DatabaseException &)
+        {
+          commands.clear();
+        }
+
+        commands.push_back({"CREATE", "QUEUE", key});
+        try
+        {
+          while (true)
+          {
+            queue_items.push_back(QueueRepository::get_instance().pop(key));
+            commands.push_back({"QUEUE", key, "PUSH", queue_items.back()});
+          }
+        }
+        catch (const DatabaseException &)
+        {
+        }
+        return commands;
+      }
+
+      /**
+       * The connection of MIGRATE to the target node.
+       *
+       * Every operation runs asynchronously on a private io_context and waits at most until a deadline, then the connection
+       * is closed. An unresponsive target fails the migration instead of occupying the executor thread for good.
+       */
+      class MigrationConnection
+      {
+      private:
+        boost::asio::io_context io_context_;
+        boost::asio::ip::tcp::resolver resolver_{io_context_};
+        boost::asio::ip::tcp::socket socket_{io_context_};
+
+        /**
+         * Runs the started operation until it completes or the deadline passes, and throws the error it failed with.
+         */
+        void wait(std::chrono::steady_clock::time_point deadline, const boost::system::error_code &error)
+        {
+          io_context_.restart();
+          io_context_.run_until(deadline);
+          if (!io_context_.stopped())
+          {
+            // Closing aborts the operation, whose handler still has to run before the error it writes goes away.
+            boost::system::error_code ignored;
+            resolver_.cancel();
+            socket_.close(ignored);
+            io_context_.restart();
+            io_context_.run();
+            throw boost::system::system_error(boost::asio::error::timed_out);
+          }
+          if (error)
+          {
+            throw boost::system::system_error(error);
+          }
+        }
+
+        /**
+         * Reads exactly the size of the buffer.
+         */
+        void read(boost::asio::mutable_buffer buffer, std::chrono::steady_clock::time_point deadline)
+        {
+          boost::system::error_code error;
+          boost::asio::async_read(socket_, buffer, [&](const boost::system::error_code &ec, std::size_t)
+                                  { error = ec; });
+          wait(deadline, error);
+        }
+
+      public:
+        /**
+         * Connects to the node and switches the connection to the binary protocol.
+         */
+        void connect(const std::string &host, const std::string &port, std::chrono::steady_clock::time_point deadline)
+        {
+          boost::system::error_code error;
+          boost::asio::ip::tcp::resolver::results_type endpoints;
+          resolver_.async_resolve(host, port, [&](const boost::system::error_code &ec, boost::asio::ip::tcp::resolver::results_type results)
+                                  {
+                                    error = ec;
+                                    endpoints = std::move(results); });
+          wait(deadline, error);
+
+          boost::asio::async_connect(socket_, endpoints, [&](const boost::system::error_code &ec, const boost::asio::ip::tcp::endpoint &)
+                                     { error = ec; });
+          wait(deadline, error);
+
+          static const char magic = static_cast<char>(protocol::MAGIC);
+          boost::asio::async_write(socket_, boost::asio::buffer(&magic, 1), [&](const boost::system::error_code &ec, std::size_t)
+                                   { error = ec; });
+          wait(deadline, error);
+        }
+
+        /**
+         * Sends commands to the node and throws the first error it replies with.
+         */
+        void send_commands(const std::vector<std::vector<std::string>> &commands, std::chrono::steady_clock::time_point deadline)
+        {
+          std::string request;
+          std::vector<std::string_view> arguments;
+          for (auto &&command : commands)
+          {
+            protocol::encode_frame(request, protocol::Opcode::COMMAND, {"ASKING"});
+            arguments.assign(command.begin(), command.end());
+            protocol::encode_frame(request, protocol::Opcode::COMMAND, arguments);
+          }
+          boost::system::error_code error;
+          boost::asio::async_write(socket_, boost::asio::buffer(request), [&](const boost::system::error_code &ec, std::size_t)
+                                   { error = ec; });
+          wait(deadline, error);
+
+          std::optional<DatabaseException> reply_error;
+          std::string frame;
+          for (std::size_t i = 0; i < 2 * commands.size(); ++i)
+          {
+            frame.resize(protocol::HEADER_SIZE);
+            read(boost::asio::buffer(frame), deadline);
+            protocol::FrameHeader header = protocol::decode_header(frame.data());
+            frame.resize(protocol::HEADER_SIZE + header.length);
+            read(boost::asio::buffer(frame.data() + protocol::HEADER_SIZE, header.length), deadline);
+            if (header.opcode != protocol::Opcode::REPLY_OK && !reply_error)
+            {
+              auto reply = protocol::decode_arguments(header, frame.data() + protocol::HEADER_SIZE);
+              reply_error = reply.size() == 2 ? DatabaseException(std::string{reply[0]}, std::string{reply[1]})
+                                              : DatabaseException("Unexpected reply of the target node", "MIGRATE_FAILED");
+            }
+          }
+          if (reply_error)
+          {
+            throw *reply_error;
+          }
+        }
+      };
+    }
 
-    std::string SetAddCommand::execute()
+    std::string AskingCommand::execute()
     {
-      SetRepository::get_instance().add(key_name_, value_);
       return "OK";
     }
 
-    SetLenCommand::SetLenCommand(const std::string &set_name) : KeyedCommand(set_name) {}
-
-    std::string SetLenCommand::execute()
+    CommandType AskingCommand::type() const
     {
-      return std::to_string(SetRepository::get_instance().len(key_name_));
+      return CommandType::ASKING;
     }
 
-    SetIntersectionCommand::SetIntersectionCommand(const std::vector<std::string> &set_names) : set_names_(set_names) {}
-
-    std::string SetIntersectionCommand::execute()
+    bool AskingCommand::is_read_only() const
     {
-      auto result = SetRepository::get_instance().intersection(set_names_);
-        std::stringstream ss;
-        ss << "[ ";
-        for (const auto &element : result)
-        {
-            ss << element << " ";
-        }
-        ss << "]";
-        return ss.str();
+      return true;
     }
 
-    SetDifferenceCommand::SetDifferenceCommand(const std::string &set_name_1, const std::string &set_name_2) : set_name_1_(set_name_1), set_name_2_(set_name_2) {}
+    ClusterKeySlotCommand::ClusterKeySlotCommand(std::string_view key) : key_(key, CommandArena::resource()) {}
 
-    std::string SetDifferenceCommand::execute()
+    std::string ClusterKeySlotCommand::execute()
     {
-      auto result = SetRepository::get_instance().difference(set_name_1_, set_name_2_);
-      std::stringstream ss;
-        ss << "[ ";
-        for (const auto &element : result)
-        {
-            ss << element << " ";
-        }
-        ss << "]";
-        return ss.str();
+      return std::to_string(ClusterState::slot(key_));
     }
 
-    SetUnionCommand::SetUnionCommand(const std::vector<std::string> &set_names) : set_names_(set_names) {}
-
-    std::string SetUnionCommand::execute()
+    CommandType ClusterKeySlotCommand::type() const
     {
-      auto result = SetRepository::get_instance().union_(set_names_);
-        std::stringstream ss;
-        ss << "[ ";
-        for (const auto &element : result)
-        {
-            ss << element << " ";
-        }
-        ss << "]";
-        return ss.str();
+      return CommandType::CLUSTER_KEYSLOT;
     }
 
-    SetContainsCommand::SetContainsCommand(const std::string &set_name, const std::string &value) : KeyedCommand(set_name), value_(value) {}
-
-    std::string SetContainsCommand::execute()
+    bool ClusterKeySlotCommand::is_read_only() const
     {
-      std::stringstream ss;
-      ss << std::boolalpha << SetRepository::get_instance().contains(key_name_, value_);
-        return ss.str();
+      return true;
     }
 
-    SetGetAllCommand::SetGetAllCommand(const std::string &set_name) : KeyedCommand(set_name) {}
-
-    std::string SetGetAllCommand::execute()
+    std::string ClusterSlotsCommand::execute()
     {
-      auto result = SetRepository::get_instance().get_all(key_name_);
-        std::stringstream ss;
+      auto result = ClusterState::get_instance().describe();
+      std::stringstream ss;
         ss << "[ ";
         for (const auto &element : result)
         {
@@ -227,469 +1226,607 @@ namespace db
         return ss.str();
     }
 
-    SetPopCommand::SetPopCommand(const std::string &set_name, const std::string value) : KeyedCommand(set_name), value_(value) {}
-
-    std::string SetPopCommand::execute()
+    CommandType ClusterSlotsCommand::type() const
     {
-      return SetRepository::get_instance().pop(key_name_, value_);
+      return CommandType::CLUSTER_SLOTS;
     }
 
-    // QUEUES
-
-    CreateQueueCommand::CreateQueueCommand(const std::string &queue_name) : KeyedCommand{queue_name} {}
-
-    std::string CreateQueueCommand::execute()
+    bool ClusterSlotsCommand::is_read_only() const
     {
-      QueueRepository::get_instance().create(key_name_);
-        return "OK";
+      return true;
     }
 
-    QueuePushCommand::QueuePushCommand(const std::string &queue_name, const std::string &value) : KeyedCommand(queue_name), value_(value) {}
+    ClusterSetSlotCommand::ClusterSetSlotCommand(std::uint16_t slot, std::string_view state, std::string_view node)
+        : slot_(slot), state_(state), node_(node) {}
 
-    std::string QueuePushCommand::execute()
+    std::string ClusterSetSlotCommand::execute()
     {
-      QueueRepository::get_instance().push(key_name_, value_);
+      auto &cluster = ClusterState::get_instance();
+      if (!cluster.enabled())
+      {
+        throw DatabaseException("Cluster mode is not enabled", "CLUSTER_DISABLED");
+      }
+      if (slot_ >= ClusterState::SLOT_COUNT)
+      {
+        throw DatabaseException("Slot out of range: " + std::to_string(slot_), "CLUSTER_SLOT");
+      }
+      if (state_ == "STABLE")
+      {
+        cluster.stabilize(slot_);
+        return "OK";
+      }
+      if (node_.empty())
+      {
+        throw DatabaseException("Missing node of the slot", "CMD_INVALID");
+      }
+      if (state_ == "NODE")
+      {
+        cluster.assign(slot_, node_);
+      }
+      else if (state_ == "MIGRATING")
+      {
+        cluster.migrate(slot_, node_);
+      }
+      else if (state_ == "IMPORTING")
+      {
+        cluster.import(slot_, node_);
+      }
+      else
+      {
+        throw DatabaseException("Unknown slot state: " + state_, "CMD_INVALID");
+      }
       return "OK";
     }
 
-    QueuePopCommand::QueuePopCommand(const std::string &queue_name) : KeyedCommand(queue_name) {}
-
-    std::string QueuePopCommand::execute()
+    CommandType ClusterSetSlotCommand::type() const
     {
-      return QueueRepository::get_instance().pop(key_name_);
+      return CommandType::CLUSTER_SETSLOT;
     }
 
-    // HASHES
-
-    std::string CreateHashCommand::execute()
+    bool ClusterSetSlotCommand::is_read_only() const
     {
-        HashRepository::get_instance().create(key_name_);
-        return "OK";
+      return false;
     }
 
-    CreateHashCommand::CreateHashCommand(const std::string &hash_name) : KeyedCommand{hash_name} {}
-
-    HashDelCommand::HashDelCommand(const std::string &hash_name, const std::string &hash_key) : KeyedCommand(hash_name), hash_key_(hash_key) {}
-
-    std::string HashDelCommand::execute()
+    bool ClusterSetSlotCommand::is_replicated() const
     {
-      HashRepository::get_instance().del(key_name_, hash_key_);
-      return "OK";
+      return false;
     }
 
-    HashExistsCommand::HashExistsCommand(const std::string &hash_name, const std::string &hash_key) : KeyedCommand(hash_name), hash_key_(hash_key) {}
+    ClusterGetKeysInSlotCommand::ClusterGetKeysInSlotCommand(std::uint16_t slot, std::size_t count) : slot_(slot), count_(count) {}
 
-    std::string HashExistsCommand::execute()
+    std::string ClusterGetKeysInSlotCommand::execute()
     {
+      auto result = ClusterState::get_instance().keys_in_slot(slot_, count_);
       std::stringstream ss;
-      ss << std::boolalpha << HashRepository::get_instance().exists(key_name_, hash_key_);
+        ss << "[ ";
+        for (const auto &element : result)
+        {
+            ss << element << " ";
+        }
+        ss << "]";
         return ss.str();
     }
 
-    HashGetCommand::HashGetCommand(const std::string &hash_name, const std::string &hash_key) : KeyedCommand(hash_name), hash_key_(hash_key) {}
+    CommandType ClusterGetKeysInSlotCommand::type() const
+    {
+      return CommandType::CLUSTER_GETKEYSINSLOT;
+    }
 
-    std::string HashGetCommand::execute()
+    bool ClusterGetKeysInSlotCommand::is_read_only() const
     {
-      return HashRepository::get_instance().get(key_name_, hash_key_);
+      return true;
+    }
+
+    ExecutionLane ClusterGetKeysInSlotCommand::lane() const
+    {
+      return ExecutionLane::SLOW;
     }
 
-    HashGetAllCommand::HashGetAllCommand(const std::string &hash_name) : KeyedCommand(hash_name) {}
+    MigrateCommand::MigrateCommand(std::string_view target, std::span<const std::string_view> keys)
+        : target_(target), keys_(keys.begin(), keys.end(), CommandArena::resource()) {}
 
-    std::string HashGetAllCommand::execute()
+    std::string MigrateCommand::execute()
     {
-      auto result = HashRepository::get_instance().get_all(key_name_);
-        std::stringstream ss;
-        ss << "[ ";
-        for (const auto &element : result)
+      auto separator = target_.rfind(':');
+      if (separator == std::string::npos)
+      {
+        throw DatabaseException("Expected host:port, got " + target_, "CMD_INVALID");
+      }
+
+      MigrationConnection connection;
+      try
+      {
+        connection.connect(target_.substr(0, separator), target_.substr(separator + 1), std::chrono::steady_clock::now() + TIMEOUT);
+      }
+      catch (const boost::system::system_error &e)
+      {
+        throw DatabaseException("Cannot connect to " + target_ + ": " + e.what(), "MIGRATE_FAILED");
+      }
+
+      std::size_t migrated = 0;
+      for (std::string_view name : keys_)
+      {
+        // The commands recreating the key and the errors are built from a std::string.
+        std::string key{name};
+
+        // Writes to the key wait from its dump until its deletion, then they are redirected to the target.
+        auto lock = ClusterState::get_instance().lock_migration(key);
+        if (!KeysStorage::get_instance().contains(key))
         {
-            ss << "{" << element.first << " : " << element.second << "} ";
+          continue;
         }
-        ss << "]";
-        return ss.str();
-    }
 
-    HashKeysCommand::HashKeysCommand(const std::string &hash_name) : KeyedCommand(hash_name) {}
+        // Snapshots are only held off while the key is modified here, not while the target is waited for.
+        std::vector<std::string> queue_items;
+        std::vector<std::vector<std::string>> commands;
+        {
+          auto write = GlobalRepository::get_instance().lock_write();
+          commands = dump_key(key, queue_items);
+        }
+        try
+        {
+          connection.send_commands(commands, std::chrono::steady_clock::now() + TIMEOUT);
+        }
+        catch (const std::exception &e)
+        {
+          // The popped items are put back, the key stays here.
+          {
+            auto write = GlobalRepository::get_instance().lock_write();
+            for (auto &&item : queue_items)
+            {
+              QueueRepository::get_instance().push(key, item);
+            }
+          }
+          if (auto error = dynamic_cast<const DatabaseException *>(&e))
+          {
+            throw DatabaseException("Migrating " + key + " failed: " + error->get_message(), error->get_code());
+          }
+          throw DatabaseException("Migrating " + key + " failed: " + e.what(), "MIGRATE_FAILED");
+        }
 
-    std::string HashKeysCommand::execute()
-    {
-      auto result = HashRepository::get_instance().get_keys(key_name_);
-        std::stringstream ss;
-        ss << "[ ";
-        for (const auto &element : result)
+        auto write = GlobalRepository::get_instance().lock_write();
+        auto &log = ReplicationLog::get_instance();
+        if (log.enabled())
         {
-            ss << element << " ";
+          std::string entry;
+          protocol::encode_frame(entry, protocol::Opcode::COMMAND, {"DEL", key});
+          log.record(key, std::move(entry), [&]
+                     {
+                       GlobalRepository::get_instance().del(key);
+                       return std::string{}; });
         }
-        ss << "]";
-        return ss.str();
+        else
+        {
+          GlobalRepository::get_instance().del(key);
+        }
+        ++migrated;
+      }
+      return std::to_string(migrated);
     }
 
-    HashSetCommand::HashSetCommand(const std::string &hash_name, const std::string &hash_key, const std::string &hash_value) : KeyedCommand(hash_name), hash_key_(hash_key), hash_value_(hash_value) {}
-
-    std::string HashSetCommand::execute()
+    CommandType MigrateCommand::type() const
     {
-      HashRepository::get_instance().set(key_name_, hash_key_, hash_value_);
-      return "OK";
+      return CommandType::MIGRATE;
     }
 
-    HashLenCommand::HashLenCommand(const std::string &hash_name) : KeyedCommand(hash_name) {}
-
-    std::string HashLenCommand::execute()
+    ExecutionLane MigrateCommand::lane() const
     {
-      return std::to_string(HashRepository::get_instance().len(key_name_));
+      return ExecutionLane::SLOW;
     }
 
-    HashSearchCommand::HashSearchCommand(const std::string &hash_name, const std::string &query) : KeyedCommand(hash_name), query_(query) {}
-
-    std::string HashSearchCommand::execute()
+    std::span<const std::pmr::string> MigrateCommand::keys() const
     {
-      auto result = HashRepository::get_instance().search(key_name_, query_);
-      std::stringstream ss;
-        ss << "[ ";
-        for (const auto &element : result)
-        {
-            ss << element << " ";
-        }
-        ss << "]";
-        return ss.str();
+      return keys_;
     }
 
-    // OTHER
+    bool MigrateCommand::is_replicated() const
+    {
+      return false;
+    }
 
-    KeysCommand::KeysCommand(const std::optional<std::string> pattern) : pattern_(pattern) {}
+    // INFO
 
-    std::string KeysCommand::execute()
+    std::string InfoCommand::execute()
     {
+      auto &metrics = Metrics::get_instance();
+      std::uint64_t opened = metrics.connections_opened();
+      std::uint64_t closed = metrics.connections_closed();
+
+      // The text protocol frames replies with brackets, so the report must not contain any.
       std::stringstream ss;
-      auto pattern = pattern_.value_or("");
-        auto result = GlobalRepository::get_instance().keys(pattern);
-        ss << "[ ";
-        for (const auto &element : result)
+      ss << "{\"connections\":{\"current\":" << opened - std::min(opened, closed) << ",\"total\":" << opened << "}";
+      ss << ",\"bytes\":{\"in\":" << metrics.bytes_in() << ",\"out\":" << metrics.bytes_out() << "}";
+
+      ss << ",\"errors\":{";
+      bool first = true;
+      for (auto &&[code, count] : metrics.errors())
+      {
+        ss << (first ? "" : ",") << "\"" << code << "\":" << count;
+        first = false;
+      }
+      ss << "}";
+
+      ss << ",\"commands\":{";
+      first = true;
+      for (std::size_t type = 0; type < static_cast<std::size_t>(CommandType::COUNT); ++type)
+      {
+        LatencySummary executed = metrics.summarize(type, Phase::EXECUTE);
+        if (executed.count() == 0)
         {
-            ss << element << " ";
+          continue;
         }
-        ss << "]";
-        return ss.str();
+        ss << (first ? "" : ",") << "\"" << command_type_name(static_cast<CommandType>(type)) << "\":{\"calls\":" << executed.count();
+        first = false;
+        for (auto [phase, name] : {std::pair{Phase::PARSE, "parse_us"}, std::pair{Phase::EXECUTE, "execute_us"}, std::pair{Phase::SERIALIZE, "serialize_us"}})
+        {
+          LatencySummary summary = phase == Phase::EXECUTE ? executed : metrics.summarize(type, phase);
+          ss << ",\"" << name << "\":{";
+          ss << "\"p50\":" << summary.percentile(0.5) / 1000.0;
+          ss << ",\"p99\":" << summary.percentile(0.99) / 1000.0;
+          ss << ",\"p999\":" << summary.percentile(0.999) / 1000.0 << "}";
+        }
+        ss << "}";
+      }
+      ss << "}}";
+      return ss.str();
     }
 
-    DelCommand::DelCommand(const std::string &key) : KeyedCommand(key) {}
+    bool InfoCommand::is_read_only() const
+    {
+      return true;
+    }
 
-    std::string DelCommand::execute()
+    CommandType InfoCommand::type() const
     {
-      GlobalRepository::get_instance().del(key_name_);
-        return "OK";
+      return CommandType::INFO;
     }
 
     // STRING FACTORIES
 
-    boost::shared_ptr<Command> CreateStringCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> CreateStringCommandFactory::create_command(std::span<std::string_view> input)
     {
-        return boost::make_shared<CreateStringCommand>(input[0], input[1]);
+        return CommandArena::make<CreateStringCommand>(input[0], input[1]);
     }
 
     CreateStringCommandFactory::CreateStringCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringGetCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringGetCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringGetCommand>(input[0]);
+      return CommandArena::make<StringGetCommand>(input[0]);
     }
 
     StringGetCommandFactory::StringGetCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringExistsCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringExistsCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringExistsCommand>(input[0]);
+      return CommandArena::make<StringExistsCommand>(input[0]);
     }
 
     StringExistsCommandFactory::StringExistsCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringLenCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringLenCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringLenCommand>(input[0]);
+      return CommandArena::make<StringLenCommand>(input[0]);
     }
 
     StringLenCommandFactory::StringLenCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringSubCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringSubCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringSubCommand>(input[0],
+      return CommandArena::make<StringSubCommand>(input[0],
                                                     boost::lexical_cast<unsigned int>(input[1]),
                                                     boost::lexical_cast<unsigned int>(input[2]));
     }
 
     StringSubCommandFactory::StringSubCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringAppendCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringAppendCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringAppendCommand>(input[0], input[1]);
+      return CommandArena::make<StringAppendCommand>(input[0], input[1]);
     }
 
     StringAppendCommandFactory::StringAppendCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringPrependCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringPrependCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringPrependCommand>(input[0], input[1]);
+      return CommandArena::make<StringPrependCommand>(input[0], input[1]);
     }
 
     StringPrependCommandFactory::StringPrependCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringInsertCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringInsertCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringInsertCommand>(input[0], boost::lexical_cast<unsigned int>(input[1]), input[2]);
+      return CommandArena::make<StringInsertCommand>(input[0], boost::lexical_cast<unsigned int>(input[1]), input[2]);
     }
 
     StringInsertCommandFactory::StringInsertCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringTrimCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringTrimCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringTrimCommand>(input[0],
+      return CommandArena::make<StringTrimCommand>(input[0],
                                                      boost::lexical_cast<unsigned int>(input[1]),
                                                      boost::lexical_cast<unsigned int>(input[2]));
     }
 
     StringTrimCommandFactory::StringTrimCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringLtrimCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringLtrimCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringLtrimCommand>(input[0], boost::lexical_cast<unsigned int>(input[1]));
+      return CommandArena::make<StringLtrimCommand>(input[0], boost::lexical_cast<unsigned int>(input[1]));
     }
 
     StringLtrimCommandFactory::StringLtrimCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringRtrimCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> StringRtrimCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<StringRtrimCommand>(input[0], boost::lexical_cast<unsigned int>(input[1]));
+      return CommandArena::make<StringRtrimCommand>(input[0], boost::lexical_cast<unsigned int>(input[1]));
     }
 
     StringRtrimCommandFactory::StringRtrimCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> StringCommandFactory::create_command(const std::vector<std::string> &input)
-    {
-      std::vector<std::string> new_command(input);
-        auto it = new_command.begin() + 1;
-        new_command.erase(it);
-        if (!children_factories_.contains(input[1]))
-        {
-            throw DatabaseException("Unknown command: " + input[1], "CMD_UNKNOWN");
-        }
-        return children_factories_[input[1]]->get_command(new_command);
-    }
-
-    StringCommandFactory::StringCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
-
     // SETS FACTORIES
 
-    boost::shared_ptr<Command> CreateSetCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> CreateSetCommandFactory::create_command(std::span<std::string_view> input)
     {
-        return boost::make_shared<CreateSetCommand>(input[0]);
+        return CommandArena::make<CreateSetCommand>(input[0]);
     }
 
     CreateSetCommandFactory::CreateSetCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetAddCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetAddCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<SetAddCommand>(input[0], input[1]);
+      return CommandArena::make<SetAddCommand>(input[0], input[1]);
     }
 
     SetAddCommandFactory::SetAddCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetLenCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetLenCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<SetLenCommand>(input[0]);
+      return CommandArena::make<SetLenCommand>(input[0]);
     }
 
     SetLenCommandFactory::SetLenCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetIntersectionCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetIntersectionCommandFactory::create_command(std::span<std::string_view> input)
     {
-        return boost::make_shared<SetIntersectionCommand>(input);
+        return CommandArena::make<SetIntersectionCommand>(input);
     }
 
     SetIntersectionCommandFactory::SetIntersectionCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetDifferenceCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetDifferenceCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<SetDifferenceCommand>(input[0], input[1]);
+      return CommandArena::make<SetDifferenceCommand>(input[0], input[1]);
     }
 
     SetDifferenceCommandFactory::SetDifferenceCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetUnionCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetUnionCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<SetUnionCommand>(input);
+      return CommandArena::make<SetUnionCommand>(input);
     }
 
     SetUnionCommandFactory::SetUnionCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetContainsCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetContainsCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<SetContainsCommand>(input[0], input[1]);
+      return CommandArena::make<SetContainsCommand>(input[0], input[1]);
     }
 
     SetContainsCommandFactory::SetContainsCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetGetAllCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetGetAllCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<SetGetAllCommand>(input[0]);
+      return CommandArena::make<SetGetAllCommand>(input[0]);
     }
 
     SetGetAllCommandFactory::SetGetAllCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetPopCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> SetPopCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<SetPopCommand>(input[0], input[1]);
+      return CommandArena::make<SetPopCommand>(input[0], input[1]);
     }
 
     SetPopCommandFactory::SetPopCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> SetCommandFactory::create_command(const std::vector<std::string> &input)
-    {
-      std::vector<std::string> new_command(input);
-        auto it = new_command.begin() + 1;
-        new_command.erase(it);
-        if (!children_factories_.contains(input[1]))
-        {
-            throw DatabaseException("Unknown command: " + input[1], "CMD_UNKNOWN");
-        }
-        return children_factories_[input[1]]->get_command(new_command);
-    }
-
-    SetCommandFactory::SetCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
-
     // QUEUES FACTORIES
 
-    boost::shared_ptr<Command> CreateQueueCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> CreateQueueCommandFactory::create_command(std::span<std::string_view> input)
     {
-        return boost::make_shared<CreateQueueCommand>(input[0]);
+        return CommandArena::make<CreateQueueCommand>(input[0]);
     }
 
     CreateQueueCommandFactory::CreateQueueCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> QueueCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> QueuePushCommandFactory::create_command(std::span<std::string_view> input)
     {
-      std::vector<std::string> new_command(input);
-        auto it = new_command.begin() + 1;
-        new_command.erase(it);
-        if (!children_factories_.contains(input[1]))
-        {
-            throw DatabaseException("Unknown command: " + input[1], "CMD_UNKNOWN");
-        }
-        return children_factories_[input[1]]->get_command(new_command);
+      return CommandArena::make<QueuePushCommand>(input[0], input[1]);
     }
 
-    QueueCommandFactory::QueueCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+    QueuePushCommandFactory::QueuePushCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> QueuePushCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> QueuePopCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<QueuePushCommand>(input[0], input[1]);
+      return CommandArena::make<QueuePopCommand>(input[0]);
     }
 
-    QueuePushCommandFactory::QueuePushCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+    QueuePopCommandFactory::QueuePopCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> QueuePopCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> QueueBlockingPopCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<QueuePopCommand>(input[0]);
+      return CommandArena::make<QueueBlockingPopCommand>(input[0], std::chrono::milliseconds(boost::lexical_cast<unsigned int>(input[1])));
     }
 
-    QueuePopCommandFactory::QueuePopCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+    QueueBlockingPopCommandFactory::QueueBlockingPopCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
     // HASHES FACTORIES
 
-    boost::shared_ptr<Command> CreateHashCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> CreateHashCommandFactory::create_command(std::span<std::string_view> input)
     {
-        return boost::make_shared<CreateHashCommand>(input[0]);
+        return CommandArena::make<CreateHashCommand>(input[0]);
     }
 
     CreateHashCommandFactory::CreateHashCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashCommandFactory::create_command(const std::vector<std::string> &input)
-    {
-      std::vector<std::string> new_command(input);
-        auto it = new_command.begin() + 1;
-        new_command.erase(it);
-        if (!children_factories_.contains(input[1]))
-        {
-            throw DatabaseException("Unknown command: " + input[1], "CMD_UNKNOWN");
-        }
-        return children_factories_[input[1]]->get_command(new_command);
-    }
-
-    HashCommandFactory::HashCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
-
-    boost::shared_ptr<Command> HashDelCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashDelCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashDelCommand>(input[0], input[1]);
+      return CommandArena::make<HashDelCommand>(input[0], input[1]);
     }
 
     HashDelCommandFactory::HashDelCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashExistsCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashExistsCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashExistsCommand>(input[0], input[1]);
+      return CommandArena::make<HashExistsCommand>(input[0], input[1]);
     }
 
     HashExistsCommandFactory::HashExistsCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashGetCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashGetCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashGetCommand>(input[0], input[1]);
+      return CommandArena::make<HashGetCommand>(input[0], input[1]);
     }
 
     HashGetCommandFactory::HashGetCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashGetAllCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashGetAllCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashGetAllCommand>(input[0]);
+      return CommandArena::make<HashGetAllCommand>(input[0]);
     }
 
     HashGetAllCommandFactory::HashGetAllCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashGetKeysCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashGetKeysCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashKeysCommand>(input[0]);
+      return CommandArena::make<HashKeysCommand>(input[0]);
     }
 
     HashGetKeysCommandFactory::HashGetKeysCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashSetCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashSetCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashSetCommand>(input[0], input[1], input[2]);
+      return CommandArena::make<HashSetCommand>(input[0], input[1], input[2]);
     }
 
     HashSetCommandFactory::HashSetCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashLenCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashLenCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashLenCommand>(input[0]);
+      return CommandArena::make<HashLenCommand>(input[0]);
     }
 
     HashLenCommandFactory::HashLenCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> HashSearchCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> HashSearchCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<HashSearchCommand>(input[0], input[1]);
+      return CommandArena::make<HashSearchCommand>(input[0], input[1]);
     }
 
     HashSearchCommandFactory::HashSearchCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
     // OTHER
 
-    boost::shared_ptr<Command> DeleteCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> DeleteCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<DelCommand>(input[0]);
+      return CommandArena::make<DelCommand>(input[0]);
     }
 
     DeleteCommandFactory::DeleteCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
-    boost::shared_ptr<Command> KeysCommandFactory::create_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> KeysCommandFactory::create_command(std::span<std::string_view> input)
     {
-      return boost::make_shared<KeysCommand>(input.size() > 0 ? std::optional<std::string>{input[0]} : std::optional<std::string>{});
+      return CommandArena::make<KeysCommand>(input.size() > 0 ? std::optional<std::string_view>{input[0]} : std::nullopt);
     }
 
     KeysCommandFactory::KeysCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
 
+    boost::shared_ptr<Command> SubscribeCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<SubscribeCommand>(std::vector<std::string>(input.begin(), input.end()));
+    }
+
+    SubscribeCommandFactory::SubscribeCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> UnsubscribeCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<UnsubscribeCommand>(std::vector<std::string>(input.begin(), input.end()));
+    }
+
+    UnsubscribeCommandFactory::UnsubscribeCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> PublishCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<PublishCommand>(input[0], input[1]);
+    }
+
+    PublishCommandFactory::PublishCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> ReplicaSyncCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<ReplicaSyncCommand>(input[0], input[1]);
+    }
+
+    ReplicaSyncCommandFactory::ReplicaSyncCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    // CLUSTER FACTORIES
+
+    boost::shared_ptr<Command> AskingCommandFactory::create_command(std::span<std::string_view>)
+    {
+      return CommandArena::make<AskingCommand>();
+    }
+
+    AskingCommandFactory::AskingCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> ClusterKeySlotCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<ClusterKeySlotCommand>(input[0]);
+    }
+
+    ClusterKeySlotCommandFactory::ClusterKeySlotCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> ClusterSlotsCommandFactory::create_command(std::span<std::string_view>)
+    {
+      return CommandArena::make<ClusterSlotsCommand>();
+    }
+
+    ClusterSlotsCommandFactory::ClusterSlotsCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> ClusterSetSlotCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<ClusterSetSlotCommand>(boost::lexical_cast<std::uint16_t>(input[0]), input[1],
+                                                       input.size() > 2 ? input[2] : std::string_view{});
+    }
+
+    ClusterSetSlotCommandFactory::ClusterSetSlotCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> ClusterGetKeysInSlotCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<ClusterGetKeysInSlotCommand>(boost::lexical_cast<std::uint16_t>(input[0]),
+                                                             boost::lexical_cast<std::size_t>(input[1]));
+    }
+
+    ClusterGetKeysInSlotCommandFactory::ClusterGetKeysInSlotCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    boost::shared_ptr<Command> MigrateCommandFactory::create_command(std::span<std::string_view> input)
+    {
+      return CommandArena::make<MigrateCommand>(input[0], input.subspan(1));
+    }
+
+    MigrateCommandFactory::MigrateCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
+    // INFO FACTORIES
+
+    boost::shared_ptr<Command> InfoCommandFactory::create_command(std::span<std::string_view>)
+    {
+      return CommandArena::make<InfoCommand>();
+    }
+
+    InfoCommandFactory::InfoCommandFactory(const boost::shared_ptr<Validator> validator) : CommandFactory(validator) {}
+
     ArgumentsCountValidator::ArgumentsCountValidator(uint count) : count_(count) {}
 
-    bool ArgumentsCountValidator::validate(const std::vector<std::string> &input)
+    bool ArgumentsCountValidator::validate(std::span<const std::string_view> input)
     {
         if (input.size() < count_)
         {
@@ -700,11 +1837,157 @@ namespace db
         return true;
     }
 
-    KeyedCommand::KeyedCommand(const std::string &str_name) : key_name_(str_name) {}
+    ExecutionLane Command::lane() const
+    {
+      return ExecutionLane::FAST;
+    }
+
+    bool Command::is_read_only() const
+    {
+      return false;
+    }
+
+    bool Command::is_replicated() const
+    {
+      return !is_read_only();
+    }
+
+    std::span<const std::pmr::string> Command::keys() const
+    {
+      return {};
+    }
+
+    CommandType Command::type() const
+    {
+      return CommandType::OTHER;
+    }
+
+    void Command::execute_into(ResultSink &sink)
+    {
+      sink.take(execute());
+    }
+
+    void ResultSink::take(std::string &&result)
+    {
+      append(result);
+    }
+
+    void StringSink::append(std::string_view bytes)
+    {
+      output_.append(bytes);
+    }
+
+    void StringSink::take(std::string &&result)
+    {
+      if (output_.empty())
+      {
+        output_ = std::move(result);
+      }
+      else
+      {
+        output_.append(result);
+      }
+    }
+
+    static_assert(static_cast<std::size_t>(CommandType::COUNT) <= Metrics::MAX_COMMAND_TYPES);
+
+    std::string_view command_type_name(CommandType type)
+    {
+      static constexpr std::array<std::string_view, static_cast<std::size_t>(CommandType::COUNT)> names{
+          "OTHER",
+          "CREATE STR",
+          "CREATE SET",
+          "CREATE HASH",
+          "CREATE QUEUE",
+          "STR GET",
+          "STR EXISTS",
+          "STR LEN",
+          "STR SUB",
+          "STR APPEND",
+          "STR PREPEND",
+          "STR INSERT",
+          "STR TRIM",
+          "STR LTRIM",
+          "STR RTRIM",
+          "SET ADD",
+          "SET LEN",
+          "SET INTER",
+          "SET DIFF",
+          "SET UNION",
+          "SET CONTAINS",
+          "SET GETALL",
+          "SET POP",
+          "QUEUE PUSH",
+          "QUEUE POP",
+          "QUEUE BPOP",
+          "HASH DEL",
+          "HASH EXISTS",
+          "HASH GET",
+          "HASH GETALL",
+          "HASH GETKEYS",
+          "HASH SET",
+          "HASH LEN",
+          "HASH SEARCH",
+          "KEYS",
+          "DEL",
+          "SUBSCRIBE",
+          "UNSUBSCRIBE",
+          "PUBLISH",
+          "REPLSYNC",
+          "ASKING",
+          "CLUSTER KEYSLOT",
+          "CLUSTER SLOTS",
+          "CLUSTER SETSLOT",
+          "CLUSTER GETKEYSINSLOT",
+          "MIGRATE",
+          "INFO"};
+      return names[static_cast<std::size_t>(type)];
+    }
+
+    KeyedCommand::KeyedCommand(std::string_view str_name) : key_name_(str_name, CommandArena::resource()) {}
+
+    std::string_view KeyedCommand::key() const
+    {
+      return key_name_;
+    }
+
+    std::span<const std::pmr::string> KeyedCommand::keys() const
+    {
+      return {&key_name_, 1};
+    }
+
+    ReplicatedCommand::ReplicatedCommand(boost::shared_ptr<Command> command, std::string_view key, std::string entry)
+        : command_(std::move(command)), key_(key, CommandArena::resource()), entry_(std::move(entry)) {}
+
+    std::string ReplicatedCommand::execute()
+    {
+      return ReplicationLog::get_instance().record(key_, std::move(entry_), [this]
+                                                   { return command_->execute(); });
+    }
+
+    ExecutionLane ReplicatedCommand::lane() const
+    {
+      return command_->lane();
+    }
+
+    bool ReplicatedCommand::is_read_only() const
+    {
+      return command_->is_read_only();
+    }
+
+    std::span<const std::pmr::string> ReplicatedCommand::keys() const
+    {
+      return command_->keys();
+    }
+
+    CommandType ReplicatedCommand::type() const
+    {
+      return command_->type();
+    }
 
     CommandFactory::CommandFactory(const boost::shared_ptr<Validator> &validator) : validator_(validator) {}
 
-    boost::shared_ptr<Command> CommandFactory::get_command(const std::vector<std::string> &input)
+    boost::shared_ptr<Command> CommandFactory::get_command(std::span<std::string_view> input)
     {
       validator_->validate(input);
       return create_command(input);
@@ -1,14 +1,27 @@
 #pragma once
 
+#include <array>
 #include <string>
+#include <string_view>
+#include <span>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <map>
+#include <memory_resource>
 #include <boost/make_shared.hpp>
 #include <optional>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <utils.hpp>
+#include <executor.hpp>
 
 namespace db
 {
+    class QueueWaiter;
 
     /**
      * The Validator interface defines a contract for validating data.
@@ -21,10 +34,10 @@ namespace db
          *
          * Subclasses implementing this interface should define specific validation logic for their data type.
          *
-         * \param input The data to be validated, represented as a vector of strings.
+         * \param input The data to be validated, represented as a sequence of tokens.
          * \return True if the data is valid, false otherwise.
          */
-        virtual bool validate(const std::vector<std::string> &input) = 0;
+        virtual bool validate(std::span<const std::string_view> input) = 0;
     };
 
     /**
@@ -54,9 +67,109 @@ namespace db
          * - Throws a `DatabaseException` with a descriptive message and error code if the number of arguments is less than expected.
          * - Returns true if the number of arguments is valid (greater than or equal to `count_`).
          *
-         * \param input The data to be validated, represented as a vector of strings.
+         * \param input The data to be validated, represented as a sequence of tokens.
          */
-        bool validate(const std::vector<std::string> &input) override;
+        bool validate(std::span<const std::string_view> input) override;
+    };
+
+    /**
+     * @brief The kinds of commands, one per command syntax. Metrics are recorded per kind.
+     */
+    enum class CommandType
+    {
+        /** Commands rejected before execution and any command not listed below. */
+        OTHER,
+        CREATE_STRING,
+        CREATE_SET,
+        CREATE_HASH,
+        CREATE_QUEUE,
+        STRING_GET,
+        STRING_EXISTS,
+        STRING_LEN,
+        STRING_SUB,
+        STRING_APPEND,
+        STRING_PREPEND,
+        STRING_INSERT,
+        STRING_TRIM,
+        STRING_LTRIM,
+        STRING_RTRIM,
+        SET_ADD,
+        SET_LEN,
+        SET_INTER,
+        SET_DIFF,
+        SET_UNION,
+        SET_CONTAINS,
+        SET_GETALL,
+        SET_POP,
+        QUEUE_PUSH,
+        QUEUE_POP,
+        QUEUE_BPOP,
+        HASH_DEL,
+        HASH_EXISTS,
+        HASH_GET,
+        HASH_GETALL,
+        HASH_GETKEYS,
+        HASH_SET,
+        HASH_LEN,
+        HASH_SEARCH,
+        KEYS,
+        DEL,
+        SUBSCRIBE,
+        UNSUBSCRIBE,
+        PUBLISH,
+        REPLSYNC,
+        ASKING,
+        CLUSTER_KEYSLOT,
+        CLUSTER_SLOTS,
+        CLUSTER_SETSLOT,
+        CLUSTER_GETKEYSINSLOT,
+        MIGRATE,
+        INFO,
+
+        /** The number of kinds, not a kind itself. */
+        COUNT
+    };
+
+    /**
+     * @brief Returns the syntax of a kind of command, e.g. `STR GET`.
+     */
+    std::string_view command_type_name(CommandType type);
+
+    /**
+     * @brief Receives the output of a command while the command produces it.
+     *
+     * A command listing a collection writes every element as it visits it, instead of building a copy of the collection
+     * and then a string from the copy. If the command fails, whatever it has written is discarded by the caller.
+     */
+    class ResultSink
+    {
+    public:
+        virtual ~ResultSink() = default;
+
+        /**
+         * @brief Appends bytes to the output.
+         */
+        virtual void append(std::string_view bytes) = 0;
+
+        /**
+         * @brief Appends a whole result built by the command, which a sink may keep without copying.
+         */
+        virtual void take(std::string &&result);
+    };
+
+    /**
+     * @brief Collects the output of a command in a string.
+     */
+    class StringSink : public ResultSink
+    {
+    private:
+        std::string &output_;
+
+    public:
+        explicit StringSink(std::string &output) : output_{output} {}
+
+        void append(std::string_view bytes) override;
+        void take(std::string &&result) override;
     };
 
     /**
@@ -74,6 +187,145 @@ namespace db
          * @return A string representing the result or output of the command execution.
          */
         virtual std::string execute() = 0;
+
+        /**
+         * @brief Executes the command, writing its output to a sink.
+         *
+         * By default the result of `execute()` is handed to the sink. Commands listing a collection override this to
+         * stream the collection, and implement `execute()` with it.
+         */
+        virtual void execute_into(ResultSink &sink);
+
+        /**
+         * @brief Returns the lane the command should be executed on.
+         *
+         * @return ExecutionLane::SLOW if the cost of the command grows with the size of a collection or of the keyspace,
+         *         ExecutionLane::FAST otherwise.
+         */
+        virtual ExecutionLane lane() const;
+
+        /**
+         * @brief Returns whether the command leaves the keyspace unchanged, so a replica may execute it. Such a command
+         * only reads through the repositories, which lock the data it reads shared.
+         */
+        virtual bool is_read_only() const;
+
+        /**
+         * @brief Returns whether the command is recorded in the replication log. By default every command modifying the
+         * keyspace is.
+         */
+        virtual bool is_replicated() const;
+
+        /**
+         * @brief Returns the keys the command operates on. A cluster node executes the command only if it serves their slot.
+         */
+        virtual std::span<const std::pmr::string> keys() const;
+
+        /**
+         * @brief Returns the kind of the command.
+         */
+        virtual CommandType type() const;
+    };
+
+    /**
+     * @brief Completes an asynchronous command with its result, or with the exception it failed with.
+     */
+    using CommandCompletion = std::function<void(std::string result, std::exception_ptr error)>;
+
+    /**
+     * @brief The AsyncCommand interface is implemented by commands that may have to wait for another command, e.g. a blocking pop.
+     *
+     * Such a command does not occupy an executor thread while it waits. The server starts it with `execute_async()` on the
+     * command executor, so taking locks never stalls a network thread, and suspends the client until the completion is
+     * called, which happens exactly once: by the command itself, by another command on another thread, or by `cancel()`.
+     */
+    class AsyncCommand
+    {
+    public:
+        virtual ~AsyncCommand() = default;
+
+        /**
+         * @brief Starts the command. It may wait for locks, but must not wait for the command to complete.
+         *
+         * @param completion Called once the command completes. It may be called before `execute_async()` returns.
+         */
+        virtual void execute_async(CommandCompletion completion) = 0;
+
+        /**
+         * @brief Returns the time after which the server cancels the command, zero if the command waits indefinitely.
+         */
+        virtual std::chrono::milliseconds timeout() const = 0;
+
+        /**
+         * @brief Gives up waiting, e.g. because the timeout passed or the client disconnected. It must not block.
+         *
+         * Does nothing if the command already completed. It may be called from another thread while `execute_async()` is
+         * still running.
+         */
+        virtual void cancel() = 0;
+    };
+
+    /**
+     * @brief The state of the client connection a command is executed for.
+     */
+    class Session
+    {
+    public:
+        virtual ~Session() = default;
+
+        /**
+         * @brief Subscribes the client to a channel. Messages published to the channel are pushed to the client.
+         *
+         * @param channel The name of the channel.
+         * @return The number of channels the client is subscribed to.
+         */
+        virtual std::size_t subscribe(const std::string &channel) = 0;
+
+        /**
+         * @brief Unsubscribes the client from a channel.
+         *
+         * @param channel The name of the channel.
+         * @return The number of channels the client is still subscribed to.
+         */
+        virtual std::size_t unsubscribe(const std::string &channel) = 0;
+
+        /**
+         * @brief Unsubscribes the client from all channels.
+         */
+        virtual void unsubscribe_all() = 0;
+
+        /**
+         * @brief Turns the connection into a replication stream once the reply of the current request is sent.
+         *
+         * @param offset The offset of the first entry of the replication log to be streamed.
+         */
+        virtual void follow_replication_log(std::uint64_t offset) = 0;
+
+        /**
+         * @brief Turns the connection into a replication stream starting with a new snapshot once the reply of the current
+         * request is sent.
+         *
+         * The snapshot is taken and sent without blocking the connection, see `ReplicaSyncCommand`.
+         */
+        virtual void follow_snapshot() = 0;
+    };
+
+    /**
+     * @brief The SessionCommand interface is implemented by commands that change the state of the client connection.
+     *
+     * The server executes such a command on the connection itself instead of the command executor.
+     */
+    class SessionCommand
+    {
+    public:
+        virtual ~SessionCommand() = default;
+
+        /**
+         * @brief Executes the command for the given session. It must not block.
+         *
+         * @return A string representing the result or output of the command execution.
+         */
+        virtual std::string execute_in(Session &session) = 0;
     };
 
     /**
@@ -90,10 +342,38 @@ namespace db
          *
          * Used for identification and retrieval of the command.
          */
-        std::string key_name_;
+        std::pmr::string key_name_;
+
+    public:
+        KeyedCommand(std::string_view str_name);
+
+        /**
+         * @brief Returns the key the command operates on.
+         */
+        std::string_view key() const;
+
+        std::span<const std::pmr::string> keys() const override;
+    };
+
+    /**
+     * @brief Decorates a command modifying the keyspace, so it is recorded in the replication log when it succeeds.
+     */
+    class ReplicatedCommand : public Command
+    {
+    private:
+        boost::shared_ptr<Command> command_;
+        std::pmr::string key_;
+
+        /** The entry replaying the command on a replica. */
+        std::string entry_;
 
     public:
-        KeyedCommand(const std::string &str_name);
+        ReplicatedCommand(boost::shared_ptr<Command> command, std::string_view key, std::string entry);
+        std::string execute() override;
+        ExecutionLane lane() const override;
+        bool is_read_only() const override;
+        std::span<const std::pmr::string> keys() const override;
+        CommandType type() const override;
     };
 
     // CREATE
@@ -101,32 +381,37 @@ namespace db
     class CreateStringCommand : public KeyedCommand
     {
     private:
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        CreateStringCommand(const std::string &string_name, const std::string &value);
+        CreateStringCommand(std::string_view string_name, std::string_view value);
         std::string execute();
+        CommandType type() const override;
     };
 
     class CreateSetCommand : public KeyedCommand
     {
     public:
         std::string execute();
-        CreateSetCommand(const std::string &set_name);
+        CommandType type() const override;
+        CreateSetCommand(std::string_view set_name);
     };
 
     class CreateHashCommand : public KeyedCommand
     {
     public:
         std::string execute();
-        CreateHashCommand(const std::string &hash_name);
+        CommandType type() const override;
+        CreateHashCommand(std::string_view hash_name);
     };
 
     class CreateQueueCommand : public KeyedCommand
     {
     public:
-        CreateQueueCommand(const std::string &queue_name);
+        CreateQueueCommand(std::string_view queue_name);
         std::string execute();
+        CommandType type() const override;
+        bool is_replicated() const override;
     };
 
     // STRING
@@ -134,22 +419,28 @@ namespace db
     class StringGetCommand : public KeyedCommand
     {
     public:
-        StringGetCommand(const std::string &str_name);
+        StringGetCommand(std::string_view str_name);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class StringExistsCommand : public KeyedCommand
     {
     public:
-        StringExistsCommand(const std::string &str_name);
+        StringExistsCommand(std::string_view str_name);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class StringLenCommand : public KeyedCommand
     {
     public:
-        StringLenCommand(const std::string &str_name);
+        StringLenCommand(std::string_view str_name);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class StringSubCommand : public KeyedCommand
@@ -159,39 +450,44 @@ namespace db
         uint end_pos_;
 
     public:
-        StringSubCommand(const std::string &str_name, uint start_pos, uint end_pos);
+        StringSubCommand(std::string_view str_name, uint start_pos, uint end_pos);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class StringAppendCommand : public KeyedCommand
     {
     private:
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        StringAppendCommand(const std::string &str_name, const std::string &value);
+        StringAppendCommand(std::string_view str_name, std::string_view value);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class StringPrependCommand : public KeyedCommand
     {
     private:
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        StringPrependCommand(const std::string &str_name, const std::string &value);
+        StringPrependCommand(std::string_view str_name, std::string_view value);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class StringInsertCommand : public KeyedCommand
     {
     private:
         uint pos_;
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        StringInsertCommand(const std::string &str_name, uint pos, const std::string &value);
+        StringInsertCommand(std::string_view str_name, uint pos, std::string_view value);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class StringTrimCommand : public KeyedCommand
@@ -201,8 +497,9 @@ namespace db
         uint end_pos_;
 
     public:
-        StringTrimCommand(const std::string &str_name, uint start_pos, uint end_pos);
+        StringTrimCommand(std::string_view str_name, uint start_pos, uint end_pos);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class StringLtrimCommand : public KeyedCommand
@@ -211,8 +508,9 @@ namespace db
         uint char_count_;
 
     public:
-        StringLtrimCommand(const std::string &str_name, uint char_count);
+        StringLtrimCommand(std::string_view str_name, uint char_count);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class StringRtrimCommand : public KeyedCommand
@@ -221,8 +519,9 @@ namespace db
         uint char_count_;
 
     public:
-        StringRtrimCommand(const std::string &str_name, uint char_count);
+        StringRtrimCommand(std::string_view str_name, uint char_count);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     // SETS
@@ -230,76 +529,100 @@ namespace db
     class SetAddCommand : public KeyedCommand
     {
     private:
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        SetAddCommand(const std::string &set_name, const std::string &value);
+        SetAddCommand(std::string_view set_name, std::string_view value);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class SetLenCommand : public KeyedCommand
     {
     public:
-        SetLenCommand(const std::string &set_name);
+        SetLenCommand(std::string_view set_name);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class SetIntersectionCommand : public Command
     {
     private:
-        std::vector<std::string> set_names_;
+        std::pmr::vector<std::pmr::string> set_names_;
 
     public:
-        SetIntersectionCommand(const std::vector<std::string> &set_names);
+        SetIntersectionCommand(std::span<const std::string_view> set_names);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
+        std::span<const std::pmr::string> keys() const override;
     };
 
     class SetDifferenceCommand : public Command
     {
     private:
-        std::string set_name_1_;
-        std::string set_name_2_;
+        std::array<std::pmr::string, 2> set_names_;
 
     public:
-        SetDifferenceCommand(const std::string &set_name_1, const std::string &set_name_2);
+        SetDifferenceCommand(std::string_view set_name_1, std::string_view set_name_2);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
+        std::span<const std::pmr::string> keys() const override;
     };
 
     class SetUnionCommand : public Command
     {
     private:
-        std::vector<std::string> set_names_;
+        std::pmr::vector<std::pmr::string> set_names_;
 
     public:
-        SetUnionCommand(const std::vector<std::string> &set_names);
+        SetUnionCommand(std::span<const std::string_view> set_names);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
+        std::span<const std::pmr::string> keys() const override;
     };
 
     class SetContainsCommand : public KeyedCommand
     {
     private:
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        SetContainsCommand(const std::string &set_name, const std::string &value);
+        SetContainsCommand(std::string_view set_name, std::string_view value);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class SetGetAllCommand : public KeyedCommand
     {
     public:
-        SetGetAllCommand(const std::string &set_name);
+        SetGetAllCommand(std::string_view set_name);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
     };
 
     class SetPopCommand : public KeyedCommand
     {
     private:
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        SetPopCommand(const std::string &set_name, const std::string value);
+        SetPopCommand(std::string_view set_name, std::string_view value);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     // QUEUE
@@ -307,18 +630,57 @@ namespace db
     class QueuePushCommand : public KeyedCommand
     {
     private:
-        std::string value_;
+        std::pmr::string value_;
 
     public:
-        QueuePushCommand(const std::string &queue_name, const std::string &value);
+        QueuePushCommand(std::string_view queue_name, std::string_view value);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_replicated() const override;
     };
 
     class QueuePopCommand : public KeyedCommand
     {
     public:
-        QueuePopCommand(const std::string &queue_name);
+        QueuePopCommand(std::string_view queue_name);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_replicated() const override;
+    };
+
+    /**
+     * @brief Pops the front element of a queue, waiting up to a timeout for an element if the queue is empty.
+     *
+     * Waiting clients of a queue are served in FIFO order. On timeout the command fails with `QUEUE_EMPTY` like `POP`.
+     */
+    class QueueBlockingPopCommand : public KeyedCommand, public AsyncCommand
+    {
+    private:
+        std::chrono::milliseconds timeout_;
+        CommandCompletion completion_;
+        std::shared_ptr<QueueWaiter> waiter_;
+
+        /** Guards `started_` and `cancel_pending_`, it is only held for a few instructions. */
+        std::mutex mutex_;
+
+        /** Whether `execute_async()` returned, so `cancel()` may act on the waiter. */
+        bool started_ = false;
+
+        /** Whether `cancel()` was called while the command was starting, `execute_async()` cancels it once it is done. */
+        bool cancel_pending_ = false;
+
+    public:
+        QueueBlockingPopCommand(std::string_view queue_name, std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Throws, the command can only be executed asynchronously.
+         */
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_replicated() const override;
+        void execute_async(CommandCompletion completion) override;
+        std::chrono::milliseconds timeout() const override;
+        void cancel() override;
     };
 
     // HASHES
@@ -326,73 +688,93 @@ namespace db
     class HashDelCommand : public KeyedCommand
     {
     private:
-        std::string hash_key_;
+        std::pmr::string hash_key_;
 
     public:
-        HashDelCommand(const std::string &hash_name, const std::string &hash_key);
+        HashDelCommand(std::string_view hash_name, std::string_view hash_key);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class HashExistsCommand : public KeyedCommand
     {
     private:
-        std::string hash_key_;
+        std::pmr::string hash_key_;
 
     public:
-        HashExistsCommand(const std::string &hash_name, const std::string &hash_key);
+        HashExistsCommand(std::string_view hash_name, std::string_view hash_key);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class HashGetCommand : public KeyedCommand
     {
     private:
-        std::string hash_key_;
+        std::pmr::string hash_key_;
 
     public:
-        HashGetCommand(const std::string &hash_name, const std::string &hash_key);
+        HashGetCommand(std::string_view hash_name, std::string_view hash_key);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class HashGetAllCommand : public KeyedCommand
     {
     public:
-        HashGetAllCommand(const std::string &hash_name);
+        HashGetAllCommand(std::string_view hash_name);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
     };
 
     class HashKeysCommand : public KeyedCommand
     {
     public:
-        HashKeysCommand(const std::string &hash_name);
+        HashKeysCommand(std::string_view hash_name);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
     };
 
     class HashSetCommand : public KeyedCommand
     {
     private:
-        std::string hash_key_;
-        std::string hash_value_;
+        std::pmr::string hash_key_;
+        std::pmr::string hash_value_;
 
     public:
-        HashSetCommand(const std::string &hash_name, const std::string &hash_key, const std::string &hash_value);
+        HashSetCommand(std::string_view hash_name, std::string_view hash_key, std::string_view hash_value);
         std::string execute() override;
+        CommandType type() const override;
     };
 
     class HashLenCommand : public KeyedCommand
     {
     public:
-        HashLenCommand(const std::string &hash_name);
+        HashLenCommand(std::string_view hash_name);
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
     };
 
     class HashSearchCommand : public KeyedCommand
     {
     private:
-        std::string query_;
+        std::pmr::string query_;
 
     public:
-        HashSearchCommand(const std::string &hash_name, const std::string &query);
+        HashSearchCommand(std::string_view hash_name, std::string_view query);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
     };
 
     // OTHER
@@ -400,18 +782,219 @@ namespace db
     class KeysCommand : public Command
     {
     public:
-        std::optional<std::string> pattern_;
+        std::optional<std::pmr::string> pattern_;
 
     public:
-        KeysCommand(const std::optional<std::string> pattern);
+        KeysCommand(std::optional<std::string_view> pattern);
         std::string execute() override;
+        void execute_into(ResultSink &sink) override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
     };
 
     class DelCommand : public KeyedCommand
     {
     public:
-        DelCommand(const std::string &key);
+        DelCommand(std::string_view key);
+        std::string execute() override;
+        CommandType type() const override;
+    };
+
+    // CHANNELS
+
+    class SubscribeCommand : public Command, public SessionCommand
+    {
+    private:
+        std::vector<std::string> channels_;
+
+    public:
+        SubscribeCommand(std::vector<std::string> channels);
+
+        /**
+         * @brief Throws, the command can only be executed for a session.
+         */
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        std::string execute_in(Session &session) override;
+    };
+
+    class UnsubscribeCommand : public Command, public SessionCommand
+    {
+    private:
+        /** The channels to unsubscribe from, all channels if empty. */
+        std::vector<std::string> channels_;
+
+    public:
+        UnsubscribeCommand(std::vector<std::string> channels);
+
+        /**
+         * @brief Throws, the command can only be executed for a session.
+         */
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        std::string execute_in(Session &session) override;
+    };
+
+    class PublishCommand : public Command
+    {
+    private:
+        std::string channel_;
+        std::string payload_;
+
+    public:
+        PublishCommand(std::string_view channel, std::string_view payload);
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
+    };
+
+    // REPLICATION
+
+    /**
+     * @brief Sent by a replica to its primary to receive the replication log, preceded by a snapshot if needed.
+     *
+     * The reply is `CONTINUE <id> <offset>` if the replica can continue at its offset from the backlog, or `FULL <id>`
+     * otherwise. A full sync is followed by the snapshot in `SNAPSHOT` frames of at most `SnapshotWriter::CHUNK_SIZE` bytes
+     * and a `REPLY_OK` frame holding the offset the snapshot was taken at, or a `REPLY_ERROR` frame if it failed. Then the
+     * connection streams the entries of the log from the offset on.
+     */
+    class ReplicaSyncCommand : public Command, public SessionCommand
+    {
+    private:
+        /** The identifier of the primary run the replica replicated, `-` for a new replica. */
+        std::string primary_id_;
+        std::string offset_;
+
+    public:
+        ReplicaSyncCommand(std::string_view primary_id, std::string_view offset);
+
+        /**
+         * @brief Throws, the command can only be executed for a session.
+         */
+        std::string execute() override;
+        CommandType type() const override;
+        std::string execute_in(Session &session) override;
+        bool is_read_only() const override;
+    };
+
+    // CLUSTER
+
+    /**
+     * @brief Lets the next command of the connection access a slot this node is importing.
+     *
+     * The server recognizes the command before it executes the following one, so executing it only acknowledges it.
+     */
+    class AskingCommand : public Command
+    {
+    public:
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+    };
+
+    class ClusterKeySlotCommand : public Command
+    {
+    private:
+        std::pmr::string key_;
+
+    public:
+        ClusterKeySlotCommand(std::string_view key);
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+    };
+
+    class ClusterSlotsCommand : public Command
+    {
+    public:
         std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+    };
+
+    /**
+     * @brief Changes the state of a slot on this node: `NODE <host:port>` assigns it, `MIGRATING <host:port>` and
+     * `IMPORTING <host:port>` start moving it to or from another node and `STABLE` ends the move.
+     *
+     * The command modifies the cluster state of this node, not the keyspace. It is not replicated, but a replica accepts it
+     * like a read-only command, so the slots of a replica are assigned like the slots of its primary.
+     */
+    class ClusterSetSlotCommand : public Command
+    {
+    private:
+        std::uint16_t slot_;
+        std::string state_;
+        std::string node_;
+
+    public:
+        ClusterSetSlotCommand(std::uint16_t slot, std::string_view state, std::string_view node);
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        bool is_replicated() const override;
+    };
+
+    class ClusterGetKeysInSlotCommand : public Command
+    {
+    private:
+        std::uint16_t slot_;
+        std::size_t count_;
+
+    public:
+        ClusterGetKeysInSlotCommand(std::uint16_t slot, std::size_t count);
+        std::string execute() override;
+        CommandType type() const override;
+        bool is_read_only() const override;
+        ExecutionLane lane() const override;
+    };
+
+    /**
+     * @brief Moves keys to another node of the cluster.
+     *
+     * Every key is recreated on the target with commands preceded by `ASKING`, so the target must be importing the slot of
+     * the key, and deleted here once the target acknowledged all of them. Writes to the key wait meanwhile, see
+     * `ClusterState::lock_migration()`. The command blocks its executor thread until then, at most for `TIMEOUT` per key.
+     */
+    class MigrateCommand : public Command
+    {
+    public:
+        /** The longest the target node may take to accept the connection, or to acknowledge the commands of a key. */
+        static constexpr std::chrono::seconds TIMEOUT{5};
+
+    private:
+        std::string target_;
+        std::pmr::vector<std::pmr::string> keys_;
+
+    public:
+        MigrateCommand(std::string_view target, std::span<const std::string_view> keys);
+        std::string execute() override;
+        CommandType type() const override;
+        ExecutionLane lane() const override;
+        std::span<const std::pmr::string> keys() const override;
+
+        /**
+         * @brief Returns false, the deletion of every migrated key is recorded in the replication log instead.
+         */
+        bool is_replicated() const override;
+    };
+
+    // INFO
+
+    /**
+     * @brief Reports the metrics of the server as a JSON object: connections, bytes received and sent, failed commands by
+     * error code and, for every kind of command executed so far, the number of calls and the 50th, 99th and 99.9th
+     * percentile latencies of parsing, executing and serializing it in microseconds.
+     */
+    class InfoCommand : public Command
+    {
+    public:
+        std::string execute() override;
+        bool is_read_only() const override;
+        CommandType type() const override;
     };
 
     //////FACTORY
@@ -436,10 +1019,11 @@ namespace db
          * - Validates the input data using the `validator_`.
          * - Calls the pure virtual `create_command()` method (implemented in subclasses) to create the specific Command.
          *
-         * @param input The input data to be used for command creation.
+         * @param input The tokens to be used for command creation. They point into the request buffer and group factories may
+         *              reorder them in place, so the command must copy whatever it keeps.
          * @return A shared pointer to the created Command object.
          */
-        boost::shared_ptr<Command> get_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> get_command(std::span<std::string_view> input);
 
     private:
         /**
@@ -450,7 +1034,7 @@ namespace db
          * @param input The input data for command creation.
          * @return A shared pointer to the created Command object.
          */
-        virtual boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) = 0;
+        virtual boost::shared_ptr<Command> create_command(std::span<std::string_view> input) = 0;
     };
 
     // CREATE
@@ -458,7 +1042,7 @@ namespace db
     class CreateStringCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         CreateStringCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -467,7 +1051,7 @@ namespace db
     class CreateSetCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         CreateSetCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -476,7 +1060,7 @@ namespace db
     class CreateHashCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         CreateHashCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -485,49 +1069,18 @@ namespace db
     class CreateQueueCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         CreateQueueCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
-    /**
-     * @brief A specialized CommandFactory responsible for creating commands that create new data structures.
-     *
-     * Extends the CommandFactory class, focusing on commands that initiate various data structures.
-     * Delegates specific creation commands to child factories for better organization and extensibility.
-     */
-    class CreateCommandFactory : public CommandFactory
-    {
-    private:
-        /**
-         * @brief Overridden method to create a Command object based on input data.
-         *
-         * - Analyzes the second word in the input vector (after "CREATE") to determine the appropriate child factory.
-         * - Delegates command creation to the matching child factory.
-         *
-         * @param input The input data for command creation.
-         * @return A shared pointer to the created Command object.
-         */
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
-
-    public:
-        CreateCommandFactory(const boost::shared_ptr<Validator> validator);
-
-    private:
-        std::map<std::string, boost::shared_ptr<CommandFactory>> children_factories_{
-            {"STR", boost::make_shared<CreateStringCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"SET", boost::make_shared<CreateSetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"HASH", boost::make_shared<CreateHashCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"QUEUE", boost::make_shared<CreateQueueCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))}};
-    };
-
     // STRINGS
 
     class StringExistsCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringExistsCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -536,7 +1089,7 @@ namespace db
     class StringGetCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringGetCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -545,7 +1098,7 @@ namespace db
     class StringLenCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringLenCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -554,7 +1107,7 @@ namespace db
     class StringSubCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringSubCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -563,7 +1116,7 @@ namespace db
     class StringAppendCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringAppendCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -572,7 +1125,7 @@ namespace db
     class StringPrependCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringPrependCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -581,7 +1134,7 @@ namespace db
     class StringInsertCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringInsertCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -590,7 +1143,7 @@ namespace db
     class StringTrimCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringTrimCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -599,7 +1152,7 @@ namespace db
     class StringLtrimCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringLtrimCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -608,56 +1161,18 @@ namespace db
     class StringRtrimCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         StringRtrimCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
-    /**
-     * @brief A specialized CommandFactory responsible for creating commands related to string operations.
-     *
-     * Extends the CommandFactory class, focusing on commands that manipulate string values.
-     * Delegates specific string-related commands to child factories for better organization and extensibility.
-     */
-    class StringCommandFactory : public CommandFactory
-    {
-    private:
-        /**
-         * @brief Overridden method to create a Command object based on input data.
-         *
-         * - Analyzes the second word in the input vector (after "STR") to determine the appropriate child factory.
-         * - Delegates command creation to the matching child factory.
-         *
-         * @param input The input data for command creation.
-         * @return A shared pointer to the created Command object.
-         */
-
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
-
-    public:
-        StringCommandFactory(const boost::shared_ptr<Validator> validator);
-
-    private:
-        std::map<std::string, boost::shared_ptr<CommandFactory>> children_factories_{
-            {"EXISTS", boost::make_shared<StringExistsCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"GET", boost::make_shared<StringGetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"LEN", boost::make_shared<StringLenCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"SUB", boost::make_shared<StringSubCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3))},
-            {"APPEND", boost::make_shared<StringAppendCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"PREPEND", boost::make_shared<StringPrependCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"INSERT", boost::make_shared<StringInsertCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3))},
-            {"TRIM", boost::make_shared<StringTrimCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3))},
-            {"LTRIM", boost::make_shared<StringLtrimCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"RTRIM", boost::make_shared<StringRtrimCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))}};
-    };
-
     // SETS
 
     class SetAddCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetAddCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -666,7 +1181,7 @@ namespace db
     class SetLenCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetLenCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -675,7 +1190,7 @@ namespace db
     class SetIntersectionCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetIntersectionCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -684,7 +1199,7 @@ namespace db
     class SetDifferenceCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetDifferenceCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -693,7 +1208,7 @@ namespace db
     class SetUnionCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetUnionCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -702,7 +1217,7 @@ namespace db
     class SetContainsCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetContainsCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -711,7 +1226,7 @@ namespace db
     class SetGetAllCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetGetAllCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -720,53 +1235,18 @@ namespace db
     class SetPopCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
         SetPopCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
-    /**
-     * @brief A specialized CommandFactory dedicated to creating commands for set operations.
-     *
-     * Extends the CommandFactory class, specializing in commands that interact with set data structures.
-     * Employs child factories to handle specific set-related commands for better organization and extensibility.
-     */
-    class SetCommandFactory : public CommandFactory
-    {
-    private:
-        /**
-         * @brief Overridden method to create a Command object based on input data.
-         *
-         * - Analyzes the second word in the input vector (after "SET") to determine the appropriate child factory.
-         * - Delegates command creation to the matching child factory.
-         *
-         * @param input The input data for command creation.
-         * @return A shared pointer to the created Command object.
-         */
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
-
-    public:
-        SetCommandFactory(const boost::shared_ptr<Validator> validator);
-
-    private:
-        std::map<std::string, boost::shared_ptr<CommandFactory>> children_factories_{
-            {"ADD", boost::make_shared<SetAddCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"LEN", boost::make_shared<SetLenCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"INTER", boost::make_shared<SetIntersectionCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"DIFF", boost::make_shared<SetDifferenceCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"UNION", boost::make_shared<SetUnionCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"CONTAINS", boost::make_shared<SetContainsCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"GETALL", boost::make_shared<SetGetAllCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"POP", boost::make_shared<SetPopCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))}};
-    };
-
     // QUEUES
 
     class QueuePushCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         QueuePushCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -775,39 +1255,19 @@ namespace db
     class QueuePopCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         QueuePopCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
-    /**
-     * @brief A specialized CommandFactory responsible for creating commands related to queue operations.
-     *
-     * Extends the CommandFactory class, focusing on commands that manage queue data structures.
-     * Delegates specific queue commands to child factories for better organization and extensibility.
-     */
-    class QueueCommandFactory : public CommandFactory
+    class QueueBlockingPopCommandFactory : public CommandFactory
     {
     private:
-        /**
-         * @brief Overridden method to create a Command object based on input data.
-         *
-         * - Determines the appropriate child factory based on the second word in the input vector (after "QUEUE").
-         * - Delegates command creation to the matching child factory.
-         *
-         * @param input The input data for command creation.
-         * @return A shared pointer to the created Command object.
-         */
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
-        QueueCommandFactory(const boost::shared_ptr<Validator> validator);
-
-    private:
-        std::map<std::string, boost::shared_ptr<CommandFactory>> children_factories_{
-            {"PUSH", boost::make_shared<QueuePushCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"POP", boost::make_shared<QueuePopCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))}};
+        QueueBlockingPopCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
     // HASHES
@@ -815,7 +1275,7 @@ namespace db
     class HashDelCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashDelCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -824,7 +1284,7 @@ namespace db
     class HashExistsCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashExistsCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -833,7 +1293,7 @@ namespace db
     class HashGetCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashGetCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -842,7 +1302,7 @@ namespace db
     class HashGetAllCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashGetAllCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -851,7 +1311,7 @@ namespace db
     class HashGetKeysCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashGetKeysCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -860,7 +1320,7 @@ namespace db
     class HashSetCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashSetCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -869,7 +1329,7 @@ namespace db
     class HashLenCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashLenCommandFactory(const boost::shared_ptr<Validator> validator);
@@ -878,65 +1338,129 @@ namespace db
     class HashSearchCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input) override;
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input) override;
 
     public:
         HashSearchCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
-    /**
-     * @brief A specialized CommandFactory responsible for creating commands related to hash operations.
-     *
-     * Extends the CommandFactory class, focusing on commands for managing hash data structures.
-     * Delegates specific hash commands to child factories for further modularization.
-     */
-    class HashCommandFactory : public CommandFactory
+    // OTHER
+
+    class DeleteCommandFactory : public CommandFactory
     {
     private:
-        /**
-         * @brief Overridden method to create a Command object based on input data.
-         *
-         * - Determines the appropriate child factory based on the second word in the input vector (after "HASH").
-         * - Delegates command creation to the child factory if a match is found.
-         *
-         * @param input The input data for command creation.
-         * @return A shared pointer to the created Command object.
-         */
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
-        HashCommandFactory(const boost::shared_ptr<Validator> validator);
+        DeleteCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
 
+    class KeysCommandFactory : public CommandFactory
+    {
     private:
-        std::map<std::string, boost::shared_ptr<CommandFactory>> children_factories_{
-            {"DEL", boost::make_shared<HashDelCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"EXISTS", boost::make_shared<HashExistsCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"GET", boost::make_shared<HashGetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"GETALL", boost::make_shared<HashGetAllCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"GETKEYS", boost::make_shared<HashGetKeysCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"SET", boost::make_shared<HashSetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(3))},
-            {"LEN", boost::make_shared<HashLenCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"SEARCH", boost::make_shared<HashSearchCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))}};
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        KeysCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
-    // OTHER
+    class SubscribeCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
-    class DeleteCommandFactory : public CommandFactory
+    public:
+        SubscribeCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class UnsubscribeCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
-        DeleteCommandFactory(const boost::shared_ptr<Validator> validator);
+        UnsubscribeCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
-    class KeysCommandFactory : public CommandFactory
+    class PublishCommandFactory : public CommandFactory
     {
     private:
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
     public:
-        KeysCommandFactory(const boost::shared_ptr<Validator> validator);
+        PublishCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class ReplicaSyncCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        ReplicaSyncCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class AskingCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        AskingCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class ClusterKeySlotCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        ClusterKeySlotCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class ClusterSlotsCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        ClusterSlotsCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class ClusterSetSlotCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        ClusterSetSlotCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class ClusterGetKeysInSlotCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        ClusterGetKeysInSlotCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class MigrateCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        MigrateCommandFactory(const boost::shared_ptr<Validator> validator);
+    };
+
+    class InfoCommandFactory : public CommandFactory
+    {
+    private:
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
+
+    public:
+        InfoCommandFactory(const boost::shared_ptr<Validator> validator);
     };
 
     /**
@@ -951,13 +1475,15 @@ namespace db
         /**
          * @brief Overridden method to create a Command object based on input data.
          *
-         * - Determines the appropriate child factory based on the first word in the input vector.
-         * - Delegates command creation to the child factory if a match is found.
+         * - Looks the group, the first word in the input vector, up in a perfect hash table built at compile time, which
+         *   tells where the verb is.
+         * - Looks the group and the verb up in a second such table, which yields the kind of the command.
+         * - Delegates command creation to the factory of that kind, which validates and decodes the arguments.
          *
-         * @param input The input data for command creation.
+         * @param input The input data for command creation. It may be reordered in place.
          * @return A shared pointer to the created Command object.
          */
-        boost::shared_ptr<Command> create_command(const std::vector<std::string> &input);
+        boost::shared_ptr<Command> create_command(std::span<std::string_view> input);
 
         GenericCommandFactory(const boost::shared_ptr<Validator> &validator);
 
@@ -965,14 +1491,8 @@ namespace db
         static CommandFactory &get_instance();
 
     private:
-        std::map<std::string, boost::shared_ptr<CommandFactory>> children_factories_{
-            {"CREATE", boost::make_shared<CreateCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"STR", boost::make_shared<StringCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"SET", boost::make_shared<SetCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"HASH", boost::make_shared<HashCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"QUEUE", boost::make_shared<QueueCommandFactory>(boost::make_shared<ArgumentsCountValidator>(2))},
-            {"DEL", boost::make_shared<DeleteCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))},
-            {"KEYS", boost::make_shared<KeysCommandFactory>(boost::make_shared<ArgumentsCountValidator>(1))}};
+        /** The factory of every kind of command, indexed by `CommandType`. */
+        std::array<boost::shared_ptr<CommandFactory>, static_cast<std::size_t>(CommandType::COUNT)> factories_;
     };
 
 }
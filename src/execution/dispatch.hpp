@@ -0,0 +1,212 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <command.hpp>
+
+namespace db::dispatch
+{
+    /**
+     * @brief How the tokens of a command are laid out, which tells where its verb is.
+     */
+    enum class Layout : std::uint8_t
+    {
+        /** `GROUP args...`, the group is the whole command, e.g. `DEL name`. */
+        SINGLE,
+
+        /** `GROUP VERB args...`, e.g. `CREATE STR name value`. */
+        PREFIX,
+
+        /** `GROUP key VERB args...`, e.g. `STR name GET`. */
+        KEYED
+    };
+
+    /**
+     * @brief A command group, the first token of every command.
+     */
+    struct Group
+    {
+        std::string_view name;
+        Layout layout;
+
+        /** The minimum number of tokens after the group, so the verb is present. */
+        std::uint8_t arity;
+
+        /** The kind of command of a SINGLE group. */
+        CommandType type;
+
+        constexpr std::pair<std::string_view, std::string_view> key() const { return {name, {}}; }
+    };
+
+    /**
+     * @brief A verb of a PREFIX or KEYED group.
+     */
+    struct Route
+    {
+        std::string_view group;
+        std::string_view verb;
+        CommandType type;
+
+        constexpr std::pair<std::string_view, std::string_view> key() const { return {group, verb}; }
+    };
+
+    /**
+     * @brief Hashes a group and a verb with FNV-1a, followed by a final mix so the low bits depend on every character.
+     */
+    constexpr std::uint32_t hash(std::string_view group, std::string_view verb, std::uint32_t seed)
+    {
+        std::uint32_t h = 2166136261u ^ seed;
+        for (char c : group)
+        {
+            h = (h ^ static_cast<std::uint8_t>(c)) * 16777619u;
+        }
+        h = (h ^ static_cast<std::uint8_t>(' ')) * 16777619u;
+        for (char c : verb)
+        {
+            h = (h ^ static_cast<std::uint8_t>(c)) * 16777619u;
+        }
+        h ^= h >> 15;
+        h *= 0x2c1b3c6du;
+        return h ^ (h >> 12);
+    }
+
+    /**
+     * @brief A perfect hash table built at compile time: every entry has its own slot, so a lookup hashes the key once and
+     * compares it with at most one entry.
+     *
+     * The constructor searches a seed for which no two entries share a slot. `SIZE` is a power of two a few times larger
+     * than the number of entries, which keeps the search short.
+     */
+    template <typename Entry, std::size_t N, std::size_t SIZE>
+    class PerfectHashTable
+    {
+        static_assert((SIZE & (SIZE - 1)) == 0 && N < SIZE && N < 255);
+
+    private:
+        std::array<Entry, N> entries_;
+
+        /** The index of the entry in each slot plus one, zero for an empty slot. */
+        std::array<std::uint8_t, SIZE> slots_{};
+
+        std::uint32_t seed_ = 0;
+
+        constexpr std::size_t slot(std::string_view group, std::string_view verb) const
+        {
+            return hash(group, verb, seed_) & (SIZE - 1);
+        }
+
+        constexpr bool try_seed()
+        {
+            slots_.fill(0);
+            for (std::size_t i = 0; i < N; ++i)
+            {
+                auto [group, verb] = entries_[i].key();
+                auto &occupant = slots_[slot(group, verb)];
+                if (occupant != 0)
+                {
+                    // Two equal keys would collide for every seed.
+                    if (entries_[occupant - 1].key() == entries_[i].key())
+                    {
+                        throw "duplicate key";
+                    }
+                    return false;
+                }
+                occupant = static_cast<std::uint8_t>(i + 1);
+            }
+            return true;
+        }
+
+    public:
+        consteval PerfectHashTable(const std::array<Entry, N> &entries) : entries_{entries}
+        {
+            while (!try_seed())
+            {
+                ++seed_;
+            }
+        }
+
+        /**
+         * @brief Returns the entry of a key, or null if there is none.
+         */
+        constexpr const Entry *find(std::string_view group, std::string_view verb = {}) const
+        {
+            std::uint8_t occupant = slots_[slot(group, verb)];
+            if (occupant == 0)
+            {
+                return nullptr;
+            }
+            const Entry &entry = entries_[occupant - 1];
+            return entry.key() == std::pair{group, verb} ? &entry : nullptr;
+        }
+    };
+
+    /**
+     * @brief Builds a PerfectHashTable with `SIZE` slots, the number of entries is deduced.
+     */
+    template <std::size_t SIZE, typename Entry, std::size_t N>
+    consteval PerfectHashTable<Entry, N, SIZE> make_table(const std::array<Entry, N> &entries)
+    {
+        return PerfectHashTable<Entry, N, SIZE>{entries};
+    }
+
+    inline constexpr auto GROUPS = make_table<64>(std::to_array<Group>({
+        {"CREATE", Layout::PREFIX, 1, CommandType::OTHER},
+        {"STR", Layout::KEYED, 2, CommandType::OTHER},
+        {"SET", Layout::KEYED, 2, CommandType::OTHER},
+        {"HASH", Layout::KEYED, 2, CommandType::OTHER},
+        {"QUEUE", Layout::KEYED, 2, CommandType::OTHER},
+        {"CLUSTER", Layout::PREFIX, 1, CommandType::OTHER},
+        // The arguments of a SINGLE command are checked by its factory.
+        {"DEL", Layout::SINGLE, 0, CommandType::DEL},
+        {"KEYS", Layout::SINGLE, 0, CommandType::KEYS},
+        {"SUBSCRIBE", Layout::SINGLE, 0, CommandType::SUBSCRIBE},
+        {"UNSUBSCRIBE", Layout::SINGLE, 0, CommandType::UNSUBSCRIBE},
+        {"PUBLISH", Layout::SINGLE, 0, CommandType::PUBLISH},
+        {"REPLSYNC", Layout::SINGLE, 0, CommandType::REPLSYNC},
+        {"ASKING", Layout::SINGLE, 0, CommandType::ASKING},
+        {"MIGRATE", Layout::SINGLE, 0, CommandType::MIGRATE},
+        {"INFO", Layout::SINGLE, 0, CommandType::INFO},
+    }));
+
+    inline constexpr auto ROUTES = make_table<256>(std::to_array<Route>({
+        {"CREATE", "STR", CommandType::CREATE_STRING},
+        {"CREATE", "SET", CommandType::CREATE_SET},
+        {"CREATE", "HASH", CommandType::CREATE_HASH},
+        {"CREATE", "QUEUE", CommandType::CREATE_QUEUE},
+        {"STR", "EXISTS", CommandType::STRING_EXISTS},
+        {"STR", "GET", CommandType::STRING_GET},
+        {"STR", "LEN", CommandType::STRING_LEN},
+        {"STR", "SUB", CommandType::STRING_SUB},
+        {"STR", "APPEND", CommandType::STRING_APPEND},
+        {"STR", "PREPEND", CommandType::STRING_PREPEND},
+        {"STR", "INSERT", CommandType::STRING_INSERT},
+        {"STR", "TRIM", CommandType::STRING_TRIM},
+        {"STR", "LTRIM", CommandType::STRING_LTRIM},
+        {"STR", "RTRIM", CommandType::STRING_RTRIM},
+        {"SET", "ADD", CommandType::SET_ADD},
+        {"SET", "LEN", CommandType::SET_LEN},
+        {"SET", "INTER", CommandType::SET_INTER},
+        {"SET", "DIFF", CommandType::SET_DIFF},
+        {"SET", "UNION", CommandType::SET_UNION},
+        {"SET", "CONTAINS", CommandType::SET_CONTAINS},
+        {"SET", "GETALL", CommandType::SET_GETALL},
+        {"SET", "POP", CommandType::SET_POP},
+        {"QUEUE", "PUSH", CommandType::QUEUE_PUSH},
+        {"QUEUE", "POP", CommandType::QUEUE_POP},
+        {"QUEUE", "BPOP", CommandType::QUEUE_BPOP},
+        {"HASH", "DEL", CommandType::HASH_DEL},
+        {"HASH", "EXISTS", CommandType::HASH_EXISTS},
+        {"HASH", "GET", CommandType::HASH_GET},
+        {"HASH", "GETALL", CommandType::HASH_GETALL},
+        {"HASH", "GETKEYS", CommandType::HASH_GETKEYS},
+        {"HASH", "SET", CommandType::HASH_SET},
+        {"HASH", "LEN", CommandType::HASH_LEN},
+        {"HASH", "SEARCH", CommandType::HASH_SEARCH},
+        {"CLUSTER", "KEYSLOT", CommandType::CLUSTER_KEYSLOT},
+        {"CLUSTER", "SLOTS", CommandType::CLUSTER_SLOTS},
+        {"CLUSTER", "SETSLOT", CommandType::CLUSTER_SETSLOT},
+        {"CLUSTER", "GETKEYSINSLOT", CommandType::CLUSTER_GETKEYSINSLOT},
+    }));
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <parser.hpp>
+#include <executor.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 
@@ -16,14 +17,19 @@ namespace db
     {
     private:
         PType parser;
+        boost::shared_ptr<CommandExecutor> executor;
 
     public:
         /// Constructs an instance of the ExecutionIoC class with a specific parser
         /// @param parser The parser to be used by the interface
-        ExecutionIoC(PType parser) : parser(parser) {}
+        /// @param executor The executor running the parsed commands
+        ExecutionIoC(PType parser, boost::shared_ptr<CommandExecutor> executor) : parser(parser), executor(executor) {}
 
         /// Returns a reference to the internal parser
         PType &getParser() { return parser; }
+
+        /// Returns a reference to the executor running the parsed commands
+        CommandExecutor &getExecutor() { return *executor; }
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include <executor.hpp>
+#include <algorithm>
+#include <thread>
+
+namespace db
+{
+    int resolve_lane_threads(int threads, int fallback)
+    {
+        return threads > 0 ? threads : fallback;
+    }
+
+    CommandExecutor::CommandExecutor(int fast_lane_threads, int slow_lane_threads)
+        : parallelism_{tbb::global_control::max_allowed_parallelism,
+                       static_cast<std::size_t>(resolve_lane_threads(fast_lane_threads, std::max(1u, std::thread::hardware_concurrency())) +
+                                                resolve_lane_threads(slow_lane_threads, 1) + 1)},
+          // No slots are reserved for external threads: nobody joins the arenas, all work is enqueued.
+          fast_lane_{resolve_lane_threads(fast_lane_threads, std::max(1u, std::thread::hardware_concurrency())), 0},
+          slow_lane_{resolve_lane_threads(slow_lane_threads, 1), 0}
+    {
+    }
+
+    void CommandExecutor::submit(ExecutionLane lane, std::function<void()> task)
+    {
+        if (lane == ExecutionLane::SLOW)
+        {
+            slow_lane_.enqueue(std::move(task));
+            return;
+        }
+        fast_lane_.enqueue(std::move(task));
+    }
+}
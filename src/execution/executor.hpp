@@ -0,0 +1,58 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <tbb/task_arena.h>
+#include <tbb/global_control.h>
+
+namespace db
+{
+    /**
+     * @brief The lane a command is executed on.
+     */
+    enum class ExecutionLane
+    {
+        /** Point reads and writes that finish in constant or logarithmic time. */
+        FAST,
+
+        /** Commands whose cost grows with the size of a collection or of the keyspace, e.g. set algebra or `KEYS`. */
+        SLOW
+    };
+
+    /**
+     * @brief Executes commands on TBB task arenas instead of the network threads.
+     *
+     * Each lane has its own arena, so slow commands can only occupy the threads of the slow lane and point lookups keep
+     * their latency while heavy set algebra runs.
+     */
+    class CommandExecutor
+    {
+    private:
+        /** Makes sure TBB starts enough worker threads to fill both arenas. */
+        tbb::global_control parallelism_;
+
+        /** The arena of the fast lane. */
+        tbb::task_arena fast_lane_;
+
+        /** The arena of the slow lane. */
+        tbb::task_arena slow_lane_;
+
+    public:
+        /**
+         * Constructs a CommandExecutor.
+         *
+         * @param fast_lane_threads The number of threads of the fast lane. Non-positive values mean one thread per hardware core.
+         * @param slow_lane_threads The number of threads of the slow lane. Non-positive values mean one thread.
+         */
+        CommandExecutor(int fast_lane_threads, int slow_lane_threads);
+
+        /**
+         * Enqueues a task on the arena of the given lane and returns immediately.
+         *
+         * The task runs on a TBB worker thread. It must post its results back to whoever waits for them.
+         *
+         * @param lane The lane to run the task on.
+         * @param task The task to be run.
+         */
+        void submit(ExecutionLane lane, std::function<void()> task);
+    };
+}
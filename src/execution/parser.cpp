@@ -1,77 +1,113 @@
 #include <parser.hpp>
 #include <boost/make_shared.hpp>
+#include <protocol.hpp>
+#include <replication_log.hpp>
+#include <metrics.hpp>
+#include <arena.hpp>
+#include <algorithm>
+#include <chrono>
 #include <sstream>
-#include <boost/algorithm/string.hpp>
-#include <boost/iterator/iterator_facade.hpp>
-#include <boost/algorithm/string.hpp>
 #include <iostream>
 
 namespace db
 {
-    std::vector<std::string> cleanup(std::vector<std::string> vec, std::string element)
-    {
-        vec.erase(std::remove_if(vec.begin(), vec.end(), [&element](const std::string &str)
-                                 { return str == element || str.empty(); }),
-                  vec.end());
-        return vec;
-    }
-
-    bool is_all_whitespace(const std::string &str)
-    {
-        return std::all_of(str.begin(), str.end(), [](char c)
-                           { return std::isspace(c); });
-    }
-
-    DefaultParser::DefaultParser(Tokenizer &main_tokenizer,
-                                 Tokenizer &sub_tokenizer,
-                                 CommandFactory &command_factory) : main_tokenizer_(main_tokenizer),
-                                                                    sub_tokenizer_(sub_tokenizer),
+    DefaultParser::DefaultParser(Tokenizer &tokenizer,
+                                 CommandFactory &command_factory) : tokenizer_(tokenizer),
                                                                     command_factory_(command_factory) {}
 
-    std::vector<boost::shared_ptr<Command>> DefaultParser::extract_commands(const std::string &input)
+    std::vector<boost::shared_ptr<Command>> DefaultParser::extract_commands(std::string_view input, std::size_t max_commands)
     {
         std::vector<boost::shared_ptr<Command>> result{};
 
-        auto commandTokens = this->main_tokenizer_.tokenize(input);
-
-        for (auto &&commandToken : commandTokens)
+        Tokens tokens;
+        auto start = std::chrono::steady_clock::now();
+        while (this->tokenizer_.next_command(input, tokens))
         {
-            if (!is_all_whitespace(commandToken))
+            if (result.size() == max_commands)
             {
-                auto subcommandTokens = this->sub_tokenizer_.tokenize(commandToken);
-                auto cmd = this->command_factory_.get_command(subcommandTokens);
-                result.push_back(cmd);
+                throw DatabaseException("Request has more than " + std::to_string(max_commands) + " commands", "TOO_MANY_COMMANDS");
             }
+            auto cmd = make_command(std::span<std::string_view>(tokens.data(), tokens.size()));
+            auto end = std::chrono::steady_clock::now();
+            Metrics::get_instance().record(static_cast<std::size_t>(cmd->type()), Phase::PARSE, end - start);
+            start = end;
+            result.push_back(cmd);
         }
 
         return result;
     }
 
-    std::vector<std::string> BigTokenizer::tokenize(const std::string &input)
+    boost::shared_ptr<Command> DefaultParser::extract_command(std::span<std::string_view> tokens)
     {
-        std::vector<std::string> tokens;
-        boost::split(tokens, input, boost::is_any_of(this->delimeter));
-        return tokens;
+        auto start = std::chrono::steady_clock::now();
+        auto command = make_command(tokens);
+        Metrics::get_instance().record(static_cast<std::size_t>(command->type()), Phase::PARSE, std::chrono::steady_clock::now() - start);
+        return command;
     }
 
-    Tokenizer &BigTokenizer::get_instance()
+    boost::shared_ptr<Command> DefaultParser::make_command(std::span<std::string_view> tokens)
     {
-        static BigTokenizer tokenizer;
-        return tokenizer;
+        if (!ReplicationLog::get_instance().enabled())
+        {
+            return this->command_factory_.get_command(tokens);
+        }
+
+        // Group factories reorder the tokens in place, the log needs them in the order the client sent them.
+        Tokens original(tokens.begin(), tokens.end());
+        auto command = this->command_factory_.get_command(tokens);
+        if (!command->is_replicated())
+        {
+            return command;
+        }
+
+        std::string entry;
+        protocol::encode_frame(entry, protocol::Opcode::COMMAND, std::span<const std::string_view>(original.data(), original.size()));
+        auto keyed = dynamic_cast<KeyedCommand *>(command.get());
+        return CommandArena::make<ReplicatedCommand>(command, keyed ? keyed->key() : std::string_view{}, std::move(entry));
     }
 
-    std::vector<std::string> SmallTokenizer::tokenize(const std::string &input)
+    bool RequestTokenizer::next_command(std::string_view &input, Tokens &tokens)
     {
-        std::vector<std::string> tokens;
-        boost::split(tokens, input, boost::is_any_of(this->delimeter));
-        tokens = cleanup(tokens, " ");
-        return tokens;
+        tokens.clear();
+        while (!input.empty())
+        {
+            // Line breaks left between keep-alive requests separate tokens like spaces, so they never become part of one.
+            std::size_t position = 0;
+            std::size_t token_begin = std::string_view::npos;
+            for (; position < input.size() && input[position] != ';'; ++position)
+            {
+                char c = input[position];
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+                {
+                    if (token_begin != std::string_view::npos)
+                    {
+                        tokens.push_back(input.substr(token_begin, position - token_begin));
+                        token_begin = std::string_view::npos;
+                    }
+                }
+                else if (token_begin == std::string_view::npos)
+                {
+                    token_begin = position;
+                }
+            }
+            if (token_begin != std::string_view::npos)
+            {
+                tokens.push_back(input.substr(token_begin, position - token_begin));
+            }
+
+            input.remove_prefix(std::min(position + 1, input.size()));
+            if (!tokens.empty())
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
-    Tokenizer &SmallTokenizer::get_instance()
+    Tokenizer &RequestTokenizer::get_instance()
     {
-        static SmallTokenizer instance;
-        return instance;
+        static RequestTokenizer tokenizer;
+        return tokenizer;
     }
 
 }
\ No newline at end of file
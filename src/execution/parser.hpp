@@ -2,6 +2,7 @@
 #include <command.hpp>
 #include <vector>
 #include <boost/shared_ptr.hpp>
+#include <boost/container/small_vector.hpp>
 
 namespace db
 {
@@ -14,82 +15,69 @@ namespace db
         /**
          * @brief Extracts a list of commands from the given input string.
          *
-         * @param input The input string to be parsed.
+         * @param input The input string to be parsed. It is typically a view into the receive buffer of a connection.
+         * @param max_commands The maximum number of commands the input may hold.
          * @return A vector of shared pointers to Command objects representing the extracted commands.
          * @return An empty vector if no commands are found in the input.
+         * @throws DatabaseException with the `TOO_MANY_COMMANDS` code if the input holds more than `max_commands` commands.
          */
-        virtual std::vector<boost::shared_ptr<Command>> extract_commands(const std::string &input) = 0;
-    };
+        virtual std::vector<boost::shared_ptr<Command>> extract_commands(std::string_view input, std::size_t max_commands) = 0;
 
-    /**
-     * @brief The Tokenizer interface provides a contract for splitting a string into individual tokens.
-     */
-    class Tokenizer
-    {
-    public:
         /**
-         * @brief Splits the given input string into a vector of tokens.
+         * @brief Builds a single command from input that is already split into tokens.
+         *
+         * Used by the binary protocol, where the tokens arrive length-prefixed and may contain any character.
          *
-         * @param input The input string to be tokenized.
-         * @return A vector of strings, where each element represents a token extracted from the input.
+         * @param tokens The tokens of the command, e.g. `STR`, `name`, `GET`. They may be reordered in place.
+         * @return A shared pointer to the Command object.
          */
-        virtual std::vector<std::string> tokenize(const std::string &input) = 0;
+        virtual boost::shared_ptr<Command> extract_command(std::span<std::string_view> tokens) = 0;
     };
 
     /**
-     * The BigTokenizer class inherits from the Tokenizer interface and splits a string into tokens separated by a semicolon (;).
+     * @brief The tokens of a single command. Commands rarely have more than a handful, so they are kept inline.
      */
-    class BigTokenizer : public Tokenizer
-    {
-    private:
-        /**
-         * The character used as a separator for tokenization.
-         */
-        const std::string delimeter = ";";
-
-    public:
-        /**
-         * Splits the given input string `input` into tokens using the semicolon (`;`) as a separator.
-         *
-         * \param input The string to be split into tokens.
-         * \return A vector of strings, where each element represents a token identified in the original string.
-         */
-        std::vector<std::string> tokenize(const std::string &input) override;
+    using Tokens = boost::container::small_vector<std::string_view, 8>;
 
+    /**
+     * @brief The Tokenizer interface provides a contract for splitting a request into commands and their tokens.
+     */
+    class Tokenizer
+    {
     public:
         /**
-         * Gets a reference to the single instance of the BigTokenizer class.
+         * @brief Extracts the tokens of the next command of the request.
          *
-         * \return A reference to the BigTokenizer instance.
+         * @param input The rest of the request. The extracted command and its separator are removed from the front.
+         * @param tokens Cleared, then filled with views into `input`, one per token of the command.
+         * @return False if the request has no more commands.
          */
-        static Tokenizer &get_instance();
+        virtual bool next_command(std::string_view &input, Tokens &tokens) = 0;
     };
 
     /**
-     * The SmallTokenizer class inherits from the Tokenizer interface and splits a string into tokens separated by spaces (" ").
+     * The RequestTokenizer class inherits from the Tokenizer interface and scans a text protocol request in a single pass.
+     *
+     * Commands are separated by semicolons (`;`), tokens by any run of spaces, tabs and line breaks. Commands without any
+     * token are skipped.
      */
-    class SmallTokenizer : public Tokenizer
+    class RequestTokenizer : public Tokenizer
     {
-    private:
-        /**
-         * The character used as a separator for tokenization.
-         */
-        const std::string delimeter = " ";
-
     public:
         /**
-         * Splits the given input string `input` into tokens using spaces (" ") as separators.
+         * Implementation of the `next_command` method inherited from the Tokenizer interface.
          *
-         * \param input The string to be split into tokens.
-         * \return A vector of strings, where each element represents a token identified in the original string.
+         * \param input The rest of the request.
+         * \param tokens Filled with the tokens of the next command.
+         * \return False if the request has no more commands.
          */
-        std::vector<std::string> tokenize(const std::string &input) override;
+        bool next_command(std::string_view &input, Tokens &tokens) override;
 
     public:
         /**
-         * Gets a reference to the single instance of the SmallTokenizer class.
+         * Gets a reference to the single instance of the RequestTokenizer class.
          *
-         * \return A reference to the SmallTokenizer instance.
+         * \return A reference to the RequestTokenizer instance.
          */
         static Tokenizer &get_instance();
     };
@@ -101,14 +89,9 @@ namespace db
     {
     private:
         /**
-         * Reference to the main tokenizer used for initial splitting of the input string.
+         * Reference to the tokenizer splitting the input string into commands and their tokens.
          */
-        Tokenizer &main_tokenizer_;
-
-        /**
-         * Reference to the sub-tokenizer used for further splitting of command tokens.
-         */
-        Tokenizer &sub_tokenizer_;
+        Tokenizer &tokenizer_;
 
         /**
          * Reference to the command factory used to create concrete Command objects based on parsed tokens.
@@ -117,31 +100,53 @@ namespace db
 
     public:
         /**
-         * Constructor that takes references to the main tokenizer, sub-tokenizer, and command factory.
+         * Constructor that takes references to the tokenizer and the command factory.
          *
-         * \param main_tokenizer Reference to the main tokenizer object.
-         * \param sub_tokenizer Reference to the sub-tokenizer object.
+         * \param tokenizer Reference to the tokenizer object.
          * \param command_factory Reference to the command factory object.
          */
-        DefaultParser(Tokenizer &main_tokenizer, Tokenizer &sub_tokenizer, CommandFactory &command_factory);
+        DefaultParser(Tokenizer &tokenizer, CommandFactory &command_factory);
 
         /**
          * Implementation of the `extract_commands` method inherited from the Parser interface.
          *
          * This method parses the input string into commands:
          *
-         * 1. Splits the input string using the main tokenizer.
-         * 2. Iterates through the resulting tokens.
-         * 3. Skips tokens containing only whitespace characters.
-         * 4. For non-empty tokens, further splits them using the sub-tokenizer.
-         * 5. Uses the command factory to create a Command object based on the sub-tokens.
-         * 6. Adds the created Command object to the result vector.
+         * 1. Takes the tokens of the next command from the tokenizer, which skips commands without tokens.
+         * 2. Uses the command factory to create a Command object based on the tokens.
+         * 3. Adds the created Command object to the result vector.
+         * 4. Repeats until the input is exhausted, reusing the storage of the tokens.
+         *
+         * The request is rejected as soon as the tokenizer yields one command more than allowed, so no command is built for a
+         * request which is rejected anyway.
          *
          * \param input The input string to be parsed.
+         * \param max_commands The maximum number of commands the input may hold.
          * \return A vector of shared pointers to Command objects representing the extracted commands.
          * \return An empty vector if no commands are found in the input.
          */
-        std::vector<boost::shared_ptr<Command>> extract_commands(const std::string &input) override;
+        std::vector<boost::shared_ptr<Command>> extract_commands(std::string_view input, std::size_t max_commands) override;
+
+        /**
+         * Implementation of the `extract_command` method inherited from the Parser interface.
+         *
+         * Passes the tokens straight to the command factory. The binary protocol already delimits every token, so the
+         * RequestTokenizer is not involved.
+         *
+         * \param tokens The tokens of the command.
+         * \return A shared pointer to the Command object.
+         */
+        boost::shared_ptr<Command> extract_command(std::span<std::string_view> tokens) override;
+
+    private:
+        /**
+         * Builds a command with the command factory. If replication is enabled, a command modifying the keyspace is
+         * decorated to be recorded in the replication log as a binary protocol `COMMAND` frame of its tokens.
+         *
+         * \param tokens The tokens of the command.
+         * \return A shared pointer to the Command object.
+         */
+        boost::shared_ptr<Command> make_command(std::span<std::string_view> tokens);
     };
 
 }
\ No newline at end of file
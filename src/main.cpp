@@ -8,13 +8,15 @@ int main(int argc, char *argv[])
 {
     try
     {
+        db::ConfigParser config_parser;
+        db::Config config = config_parser.parse(argv[1]);
         db::DefaultParser p{
-            db::BigTokenizer::get_instance(),
-            db::SmallTokenizer::get_instance(),
+            db::RequestTokenizer::get_instance(),
             db::GenericCommandFactory::get_instance()};
-        boost::shared_ptr<db::DefaultExecutionIoC> exection_ioc = boost::make_shared<db::DefaultExecutionIoC>(p);
-        db::ConfigParser config_parser;
-        boost::shared_ptr<db::TcpServer> server = boost::make_shared<db::DefaultTcpServer>(config_parser.parse(argv[1]), exection_ioc);
+        boost::shared_ptr<db::CommandExecutor> executor = boost::make_shared<db::CommandExecutor>(config.get_fast_lane_threads(),
+                                                                                                    config.get_slow_lane_threads());
+        boost::shared_ptr<db::DefaultExecutionIoC> exection_ioc = boost::make_shared<db::DefaultExecutionIoC>(p, executor);
+        boost::shared_ptr<db::TcpServer> server = boost::make_shared<db::DefaultTcpServer>(config, exection_ioc);
         server->run();
     }
     catch (std::exception &e)
@@ -0,0 +1,76 @@
+#include "channels.hpp"
+
+namespace db
+{
+    void ChannelRegistry::subscribe(const std::string &channel, const std::shared_ptr<Subscriber> &subscriber)
+    {
+        tbb::concurrent_hash_map<std::string, std::shared_ptr<const Subscribers>>::accessor a;
+        channels_.insert(a, channel);
+
+        auto subscribers = std::make_shared<Subscribers>();
+        if (a->second)
+        {
+            subscribers->reserve(a->second->size() + 1);
+            for (auto &&current : *a->second)
+            {
+                if (!current.expired())
+                {
+                    subscribers->push_back(current);
+                }
+            }
+        }
+        subscribers->push_back(subscriber);
+        a->second = std::move(subscribers);
+    }
+
+    void ChannelRegistry::unsubscribe(const std::string &channel, const Subscriber *subscriber)
+    {
+        tbb::concurrent_hash_map<std::string, std::shared_ptr<const Subscribers>>::accessor a;
+        if (!channels_.find(a, channel))
+        {
+            return;
+        }
+
+        auto subscribers = std::make_shared<Subscribers>();
+        subscribers->reserve(a->second->size());
+        for (auto &&current : *a->second)
+        {
+            auto locked = current.lock();
+            if (locked && locked.get() != subscriber)
+            {
+                subscribers->push_back(current);
+            }
+        }
+
+        if (subscribers->empty())
+        {
+            channels_.erase(a);
+            return;
+        }
+        a->second = std::move(subscribers);
+    }
+
+    std::size_t ChannelRegistry::publish(const std::string &channel, std::string payload)
+    {
+        std::shared_ptr<const Subscribers> subscribers;
+        {
+            tbb::concurrent_hash_map<std::string, std::shared_ptr<const Subscribers>>::const_accessor a;
+            if (!channels_.find(a, channel))
+            {
+                return 0;
+            }
+            subscribers = a->second;
+        }
+
+        auto message = std::make_shared<const Message>(Message{channel, std::move(payload)});
+        std::size_t receivers = 0;
+        for (auto &&weak_subscriber : *subscribers)
+        {
+            if (auto subscriber = weak_subscriber.lock(); subscriber && subscriber->deliver(message))
+            {
+                ++receivers;
+            }
+        }
+        return receivers;
+    }
+}
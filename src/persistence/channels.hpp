@@ -0,0 +1,91 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <tbb/concurrent_hash_map.h>
+
+namespace db
+{
+    /**
+     * \struct Message
+     * \brief A message published to a channel.
+     *
+     * A message is created once per PUBLISH and shared by all subscribers, so its payload is never copied per subscriber.
+     */
+    struct Message
+    {
+        std::string channel;
+        std::string payload;
+    };
+
+    /**
+     * \class Subscriber
+     * \brief Receives the messages of the channels it is subscribed to.
+     */
+    class Subscriber
+    {
+    public:
+        virtual ~Subscriber() = default;
+
+        /**
+         * Hands a message to the subscriber. It must not block, it runs on the thread of the publishing command.
+         *
+         * \param message The published message.
+         * \return True if the message was accepted, false if the subscriber dropped it.
+         */
+        virtual bool deliver(const std::shared_ptr<const Message> &message) = 0;
+    };
+
+    /**
+     * \class ChannelRegistry
+     * \brief Thread-safe registry of the subscribers of every channel.
+     *
+     * The subscribers of a channel are kept in an immutable list which is replaced on every subscription change. A publish
+     * only copies the pointer to the current list under the lock and delivers without holding it, so a slow fan-out never
+     * blocks subscriptions or other publishers.
+     */
+    class ChannelRegistry
+    {
+    private:
+        using Subscribers = std::vector<std::weak_ptr<Subscriber>>;
+
+        tbb::concurrent_hash_map<std::string, std::shared_ptr<const Subscribers>> channels_;
+
+    public:
+        /**
+         * Subscribes a subscriber to a channel. The registry holds only a weak reference to the subscriber.
+         *
+         * \param channel The name of the channel.
+         * \param subscriber The subscriber.
+         */
+        void subscribe(const std::string &channel, const std::shared_ptr<Subscriber> &subscriber);
+
+        /**
+         * Unsubscribes a subscriber from a channel. Does nothing if it is not subscribed.
+         *
+         * \param channel The name of the channel.
+         * \param subscriber The subscriber.
+         */
+        void unsubscribe(const std::string &channel, const Subscriber *subscriber);
+
+        /**
+         * Publishes a message to all current subscribers of a channel.
+         *
+         * \param channel The name of the channel.
+         * \param payload The payload of the message.
+         * \return The number of subscribers which accepted the message.
+         */
+        std::size_t publish(const std::string &channel, std::string payload);
+
+        /**
+         * Singleton access method returning a reference to the single instance of ChannelRegistry.
+         *
+         * @return A reference to the single instance of ChannelRegistry.
+         */
+        static ChannelRegistry &get_instance()
+        {
+            static ChannelRegistry instance;
+            return instance;
+        }
+    };
+}
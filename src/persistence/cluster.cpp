@@ -0,0 +1,277 @@
+#include "cluster.hpp"
+#include "repository.hpp"
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace db
+{
+    namespace
+    {
+        /**
+         * The table of the CRC-16/XMODEM checksum (polynomial 0x1021), computed at compile time.
+         */
+        constexpr std::array<std::uint16_t, 256> make_crc16_table()
+        {
+            std::array<std::uint16_t, 256> table{};
+            for (std::uint16_t byte = 0; byte < 256; ++byte)
+            {
+                std::uint16_t crc = byte << 8;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+                }
+                table[byte] = crc;
+            }
+            return table;
+        }
+
+        constexpr std::array<std::uint16_t, 256> CRC16_TABLE = make_crc16_table();
+
+        std::uint16_t crc16(std::string_view data)
+        {
+            std::uint16_t crc = 0;
+            for (unsigned char byte : data)
+            {
+                crc = (crc << 8) ^ CRC16_TABLE[((crc >> 8) ^ byte) & 0xFF];
+            }
+            return crc;
+        }
+
+        std::uint16_t parse_slot(const std::string &slot)
+        {
+            auto value = boost::lexical_cast<unsigned int>(slot);
+            if (value >= ClusterState::SLOT_COUNT)
+            {
+                throw DatabaseException("Slot out of range: " + slot, "CLUSTER_CONFIG");
+            }
+            return static_cast<std::uint16_t>(value);
+        }
+    }
+
+    ClusterState::ClusterState()
+    {
+        for (std::size_t slot = 0; slot < SLOT_COUNT; ++slot)
+        {
+            owners_[slot].store(NO_NODE, std::memory_order_relaxed);
+            migrating_[slot].store(NO_NODE, std::memory_order_relaxed);
+            importing_[slot].store(NO_NODE, std::memory_order_relaxed);
+        }
+    }
+
+    void ClusterState::configure(const std::string &address, const std::string &nodes)
+    {
+        node_index(address);
+
+        std::vector<std::string> assignments;
+        boost::split(assignments, nodes, boost::is_any_of(","), boost::token_compress_on);
+        for (auto &&assignment : assignments)
+        {
+            boost::trim(assignment);
+            if (assignment.empty())
+            {
+                continue;
+            }
+            auto at = assignment.rfind('@');
+            if (at == std::string::npos)
+            {
+                throw DatabaseException("Missing slots of node: " + assignment, "CLUSTER_CONFIG");
+            }
+            std::int32_t node = node_index(assignment.substr(0, at));
+
+            std::string slots = assignment.substr(at + 1);
+            std::vector<std::string> ranges;
+            boost::split(ranges, slots, boost::is_any_of("+"));
+            try
+            {
+                for (auto &&range : ranges)
+                {
+                    auto dash = range.find('-');
+                    std::uint16_t first = parse_slot(range.substr(0, dash));
+                    std::uint16_t last = dash == std::string::npos ? first : parse_slot(range.substr(dash + 1));
+                    for (std::uint32_t slot = first; slot <= last; ++slot)
+                    {
+                        owners_[slot].store(node, std::memory_order_relaxed);
+                    }
+                }
+            }
+            catch (const boost::bad_lexical_cast &)
+            {
+                throw DatabaseException("Malformed slots of node: " + assignment, "CLUSTER_CONFIG");
+            }
+        }
+        enabled_ = true;
+    }
+
+    std::uint16_t ClusterState::slot(std::string_view key)
+    {
+        auto open = key.find('{');
+        if (open != std::string_view::npos)
+        {
+            auto close = key.find('}', open + 1);
+            if (close != std::string_view::npos && close != open + 1)
+            {
+                key = key.substr(open + 1, close - open - 1);
+            }
+        }
+        return crc16(key) % SLOT_COUNT;
+    }
+
+    std::optional<DatabaseException> ClusterState::route(std::span<const std::pmr::string> keys, bool asking)
+    {
+        if (keys.empty())
+        {
+            return std::nullopt;
+        }
+
+        std::uint16_t slot = ClusterState::slot(keys.front());
+        for (auto &&key : keys.subspan(1))
+        {
+            if (ClusterState::slot(key) != slot)
+            {
+                return DatabaseException("Keys of the command map to different slots", "CROSSSLOT");
+            }
+        }
+
+        std::int32_t owner = owners_[slot].load(std::memory_order_acquire);
+        if (owner == SELF)
+        {
+            // Keys already migrated, or never created, are looked up on the target.
+            std::int32_t target = migrating_[slot].load(std::memory_order_acquire);
+            if (target != NO_NODE && std::any_of(keys.begin(), keys.end(), [](std::string_view key)
+                                                 { return !KeysStorage::get_instance().contains(key); }))
+            {
+                return redirect("ASK", slot, target);
+            }
+            return std::nullopt;
+        }
+        if (asking && importing_[slot].load(std::memory_order_acquire) != NO_NODE)
+        {
+            return std::nullopt;
+        }
+        if (owner == NO_NODE)
+        {
+            return DatabaseException("Slot " + std::to_string(slot) + " is not served", "CLUSTER_DOWN");
+        }
+        return redirect("MOVED", slot, owner);
+    }
+
+    std::shared_lock<std::shared_mutex> ClusterState::lock_write(std::span<const std::pmr::string> keys)
+    {
+        if (!enabled_ || keys.empty())
+        {
+            return {};
+        }
+
+        // A write to a slot of another node was imported with ASKING, the slot is not migrated from here.
+        std::uint16_t slot = ClusterState::slot(keys.front());
+        if (owners_[slot].load(std::memory_order_acquire) != SELF)
+        {
+            return {};
+        }
+
+        std::shared_lock<std::shared_mutex> lock(migration_locks_[slot % MIGRATION_LOCK_COUNT]);
+        std::int32_t target = migrating_[slot].load(std::memory_order_acquire);
+        if (target != NO_NODE && std::any_of(keys.begin(), keys.end(), [](std::string_view key)
+                                             { return !KeysStorage::get_instance().contains(key); }))
+        {
+            throw redirect("ASK", slot, target);
+        }
+        return lock;
+    }
+
+    std::unique_lock<std::shared_mutex> ClusterState::lock_migration(std::string_view key)
+    {
+        return std::unique_lock<std::shared_mutex>(migration_locks_[slot(key) % MIGRATION_LOCK_COUNT]);
+    }
+
+    void ClusterState::assign(std::uint16_t slot, const std::string &node)
+    {
+        owners_[slot].store(node_index(node), std::memory_order_release);
+        stabilize(slot);
+    }
+
+    void ClusterState::migrate(std::uint16_t slot, const std::string &node)
+    {
+        if (owners_[slot].load(std::memory_order_acquire) != SELF)
+        {
+            throw DatabaseException("Slot " + std::to_string(slot) + " is not served by this node", "CLUSTER_SLOT");
+        }
+        migrating_[slot].store(node_index(node), std::memory_order_release);
+    }
+
+    void ClusterState::import(std::uint16_t slot, const std::string &node)
+    {
+        if (owners_[slot].load(std::memory_order_acquire) == SELF)
+        {
+            throw DatabaseException("Slot " + std::to_string(slot) + " is already served by this node", "CLUSTER_SLOT");
+        }
+        importing_[slot].store(node_index(node), std::memory_order_release);
+    }
+
+    void ClusterState::stabilize(std::uint16_t slot)
+    {
+        migrating_[slot].store(NO_NODE, std::memory_order_release);
+        importing_[slot].store(NO_NODE, std::memory_order_release);
+    }
+
+    std::vector<std::string> ClusterState::describe()
+    {
+        std::vector<std::string> ranges;
+        std::size_t first = 0;
+        for (std::size_t slot = 1; slot <= SLOT_COUNT; ++slot)
+        {
+            std::int32_t owner = owners_[first].load(std::memory_order_acquire);
+            if (slot < SLOT_COUNT && owners_[slot].load(std::memory_order_acquire) == owner)
+            {
+                continue;
+            }
+            if (owner != NO_NODE)
+            {
+                ranges.push_back(node_address(owner) + "@" + std::to_string(first) + "-" + std::to_string(slot - 1));
+            }
+            first = slot;
+        }
+        return ranges;
+    }
+
+    std::vector<std::string> ClusterState::keys_in_slot(std::uint16_t slot, std::size_t count)
+    {
+        std::vector<std::string> keys;
+        for (auto &&key : KeysStorage::get_instance().get_keys())
+        {
+            if (keys.size() == count)
+            {
+                break;
+            }
+            if (ClusterState::slot(key) == slot)
+            {
+                keys.push_back(key);
+            }
+        }
+        return keys;
+    }
+
+    std::int32_t ClusterState::node_index(const std::string &node)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(nodes_.begin(), nodes_.end(), node);
+        if (it != nodes_.end())
+        {
+            return static_cast<std::int32_t>(it - nodes_.begin());
+        }
+        nodes_.push_back(node);
+        return static_cast<std::int32_t>(nodes_.size() - 1);
+    }
+
+    std::string ClusterState::node_address(std::int32_t index)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nodes_[index];
+    }
+
+    DatabaseException ClusterState::redirect(const char *code, std::uint16_t slot, std::int32_t node)
+    {
+        return DatabaseException(std::to_string(slot) + " " + node_address(node), code);
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utils.hpp>
+
+namespace db
+{
+    /**
+     * \class ClusterState
+     * \brief The assignment of hash slots to the nodes of a cluster, as seen by this node.
+     *
+     * Every key maps to one of `SLOT_COUNT` hash slots and every slot is served by exactly one node. A node executes the
+     * commands on keys of its own slots and redirects the others with a `MOVED` error naming the owner. A slot is moved to
+     * another node while the cluster stays online: the target is told it is importing the slot, the source that it is
+     * migrating it, then the keys are migrated one by one. Meanwhile the source keeps serving the keys it still has and
+     * redirects the others with an `ASK` error, which the target honours only after the client sent `ASKING`. Finally every
+     * node is told the new owner of the slot.
+     *
+     * Slot lookups are lock-free, the nodes are only looked up to report a redirection. A write holds the migration lock of
+     * its slot shared while it executes, and a key is migrated holding the lock exclusively, so no write to the key is
+     * applied between its dump and its deletion.
+     */
+    class ClusterState
+    {
+    public:
+        /** The number of hash slots. */
+        static constexpr std::uint16_t SLOT_COUNT = 16384;
+
+    private:
+        /** The number of migration locks, the slots are spread over them. */
+        static constexpr std::size_t MIGRATION_LOCK_COUNT = 64;
+
+        /** Marks a slot without an owner or a migration. */
+        static constexpr std::int32_t NO_NODE = -1;
+
+        /** The index of this node in `nodes_`. */
+        static constexpr std::int32_t SELF = 0;
+
+        /** Whether the server runs in cluster mode. */
+        bool enabled_ = false;
+
+        /** Guards `nodes_`. */
+        std::mutex mutex_;
+
+        /** The `host:port` of every known node, this node first. Nodes are never removed, so their indices stay valid. */
+        std::vector<std::string> nodes_;
+
+        /** The index of the node serving each slot. */
+        std::array<std::atomic<std::int32_t>, SLOT_COUNT> owners_;
+
+        /** The index of the node each slot of this node is migrated to. */
+        std::array<std::atomic<std::int32_t>, SLOT_COUNT> migrating_;
+
+        /** The index of the node each slot is imported from. */
+        std::array<std::atomic<std::int32_t>, SLOT_COUNT> importing_;
+
+        /** Held shared by writes to the keys of the slots hashed to them and exclusively while such a key is migrated. */
+        std::array<std::shared_mutex, MIGRATION_LOCK_COUNT> migration_locks_;
+
+        ClusterState();
+
+    public:
+        /**
+         * Enables cluster mode. Must be called before any command is executed.
+         *
+         * Throws a `DatabaseException` with the `CLUSTER_CONFIG` code if the slot assignment is malformed.
+         *
+         * \param address The `host:port` of this node.
+         * \param nodes The initial slot assignment, a comma separated list of `host:port@ranges` where ranges is a `+`
+         *              separated list of slots and `first-last` slot ranges.
+         */
+        void configure(const std::string &address, const std::string &nodes);
+
+        /**
+         * Returns whether the server runs in cluster mode.
+         */
+        bool enabled() const { return enabled_; }
+
+        /**
+         * Returns the hash slot of a key.
+         *
+         * Only the part between the first `{` and the following `}` is hashed if it is not empty, so keys sharing such a
+         * hash tag are kept in the same slot.
+         *
+         * \param key The key.
+         */
+        static std::uint16_t slot(std::string_view key);
+
+        /**
+         * Decides whether this node serves a command on the given keys.
+         *
+         * \param keys The keys of the command.
+         * \param asking Whether the client sent `ASKING` before the command.
+         * \return The error to reply with instead of executing the command, nothing if the command is executed here.
+         */
+        std::optional<DatabaseException> route(std::span<const std::pmr::string> keys, bool asking);
+
+        /**
+         * Holds off the migration of the keys of a write while the write executes.
+         *
+         * Throws the `ASK` redirection to the target if the slot is being migrated and one of the keys was migrated, or never
+         * existed, by the time the lock is acquired.
+         *
+         * \param keys The keys of the write.
+         * \return The lock, which does not own a mutex outside of cluster mode or for keys of a slot of another node.
+         */
+        std::shared_lock<std::shared_mutex> lock_write(std::span<const std::pmr::string> keys);
+
+        /**
+         * Holds off the writes to a key while it is migrated.
+         *
+         * \param key The key.
+         */
+        std::unique_lock<std::shared_mutex> lock_migration(std::string_view key);
+
+        /**
+         * Assigns a slot to a node and ends any migration of the slot.
+         *
+         * \param slot The slot.
+         * \param node The `host:port` of the node.
+         */
+        void assign(std::uint16_t slot, const std::string &node);
+
+        /**
+         * Starts migrating a slot of this node to another node.
+         *
+         * \param slot The slot.
+         * \param node The `host:port` of the target node.
+         */
+        void migrate(std::uint16_t slot, const std::string &node);
+
+        /**
+         * Starts importing a slot from another node.
+         *
+         * \param slot The slot.
+         * \param node The `host:port` of the source node.
+         */
+        void import(std::uint16_t slot, const std::string &node);
+
+        /**
+         * Ends any migration of a slot without changing its owner.
+         *
+         * \param slot The slot.
+         */
+        void stabilize(std::uint16_t slot);
+
+        /**
+         * Describes the slot assignment as a list of `host:port@first-last` ranges, in the format of the initial assignment.
+         */
+        std::vector<std::string> describe();
+
+        /**
+         * Returns the keys of this node in a slot.
+         *
+         * \param slot The slot.
+         * \param count The maximum number of keys returned.
+         */
+        std::vector<std::string> keys_in_slot(std::uint16_t slot, std::size_t count);
+
+        /**
+         * Singleton access method returning a reference to the single instance of ClusterState.
+         *
+         * @return A reference to the single instance of ClusterState.
+         */
+        static ClusterState &get_instance()
+        {
+            static ClusterState instance;
+            return instance;
+        }
+
+    private:
+        /**
+         * Returns the index of a node, registering it if it is not known yet.
+         */
+        std::int32_t node_index(const std::string &node);
+
+        /**
+         * Returns the `host:port` of a node.
+         */
+        std::string node_address(std::int32_t index);
+
+        /**
+         * Builds the error redirecting a command on a slot to a node.
+         */
+        DatabaseException redirect(const char *code, std::uint16_t slot, std::int32_t node);
+    };
+}
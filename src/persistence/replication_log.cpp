@@ -0,0 +1,117 @@
+#include "replication_log.hpp"
+#include "repository.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace db
+{
+    ReplicationLog::ReplicationLog()
+    {
+        std::random_device device;
+        std::uniform_int_distribution<std::uint64_t> distribution;
+        std::stringstream ss;
+        ss << std::hex << std::setfill('0') << std::setw(16) << distribution(device);
+        id_ = ss.str();
+    }
+
+    void ReplicationLog::enable(std::size_t capacity)
+    {
+        capacity_ = capacity;
+    }
+
+    std::string ReplicationLog::record(std::string_view key, std::string entry, const std::function<std::string()> &mutation)
+    {
+        std::lock_guard<std::mutex> stripe(stripes_[std::hash<std::string_view>{}(key) % STRIPE_COUNT]);
+        std::string result = mutation();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_ += entry.size();
+        entries_.push_back(std::make_shared<const std::string>(std::move(entry)));
+        // The newest entry is always kept, even if it is larger than the whole backlog.
+        while (size_ > capacity_ && entries_.size() > 1)
+        {
+            size_ -= entries_.front()->size();
+            entries_.pop_front();
+            ++first_offset_;
+        }
+        for (auto &&[id, wake] : watchers_)
+        {
+            wake();
+        }
+        return result;
+    }
+
+    ReplicationLog::ForkedSnapshot ReplicationLog::fork_snapshot()
+    {
+        int pipe_fds[2];
+        if (::pipe2(pipe_fds, O_CLOEXEC) != 0)
+        {
+            throw DatabaseException("Snapshot failed: " + std::string{std::strerror(errno)}, "REPL_SNAPSHOT");
+        }
+
+        ForkedSnapshot snapshot;
+        snapshot.pid = DataExporter::fork_save([&]
+                                               {
+                                                   ::close(pipe_fds[0]);
+                                                   PosixSnapshotWriter writer{pipe_fds[1]};
+                                                   return DataExporter::save(writer); },
+                                               [&]
+                                               {
+                                                   std::lock_guard<std::mutex> guard(mutex_);
+                                                   snapshot.offset = first_offset_ + entries_.size(); });
+        int error = errno;
+
+        ::close(pipe_fds[1]);
+        if (snapshot.pid < 0)
+        {
+            ::close(pipe_fds[0]);
+            throw DatabaseException("Snapshot failed: " + std::string{std::strerror(error)}, "REPL_SNAPSHOT");
+        }
+        snapshot.fd = pipe_fds[0];
+        return snapshot;
+    }
+
+    bool ReplicationLog::can_continue(const std::string &id, std::uint64_t offset)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return id == id_ && offset >= first_offset_ && offset <= first_offset_ + entries_.size();
+    }
+
+    bool ReplicationLog::read(std::uint64_t offset, std::vector<Entry> &entries, std::size_t max_bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (offset < first_offset_)
+        {
+            return false;
+        }
+
+        std::size_t bytes = 0;
+        for (auto it = entries_.begin() + std::min<std::uint64_t>(offset - first_offset_, entries_.size());
+             it != entries_.end() && bytes < max_bytes; ++it)
+        {
+            bytes += (*it)->size();
+            entries.push_back(*it);
+        }
+        return true;
+    }
+
+    std::uint64_t ReplicationLog::watch(std::function<void()> wake)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        watchers_.emplace_back(next_watcher_, std::move(wake));
+        return next_watcher_++;
+    }
+
+    void ReplicationLog::unwatch(std::uint64_t watcher)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::erase_if(watchers_, [watcher](const auto &registration)
+                      { return registration.first == watcher; });
+    }
+}
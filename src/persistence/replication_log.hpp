@@ -0,0 +1,163 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+namespace db
+{
+    /**
+     * \class ReplicationLog
+     * \brief The log of mutations a primary streams to its replicas.
+     *
+     * Every command modifying the keyspace is recorded as an opaque entry, numbered by its offset in the log. A replica
+     * starts from a snapshot taken at some offset and applies the entries from that offset on. The most recent entries are
+     * kept in a bounded backlog, so a replica reconnecting with an offset still in the backlog continues without a new
+     * snapshot.
+     *
+     * Mutations of the same key are recorded in the order they are applied, mutations of different keys commute. A snapshot
+     * waits for the mutations in progress and holds off new ones while the server forks, so it contains exactly the entries
+     * before its offset. The child process serializes the keyspace as of the fork, its pages are shared with the server
+     * copy-on-write, so mutations go on while the snapshot is written.
+     */
+    class ReplicationLog
+    {
+    public:
+        /** A recorded entry, shared by every replica streaming it. */
+        using Entry = std::shared_ptr<const std::string>;
+
+        /**
+         * \brief A snapshot being serialized by a child process.
+         */
+        struct ForkedSnapshot
+        {
+            /** The child process, it exits once the snapshot is written. It is reaped with `DataExporter::wait_save()`. */
+            pid_t pid = -1;
+
+            /** The read end of the pipe the child writes the snapshot to, owned by the caller. */
+            int fd = -1;
+
+            /** The offset of the first entry not contained in the snapshot. */
+            std::uint64_t offset = 0;
+        };
+
+    private:
+        /** The number of locks serializing the mutations of the keys hashed to them. */
+        static constexpr std::size_t STRIPE_COUNT = 64;
+
+        /** The maximum number of bytes kept in the backlog, zero if replication is disabled. */
+        std::size_t capacity_ = 0;
+
+        /** Identifies this run of the primary, offsets of another run are meaningless. */
+        std::string id_;
+
+
+        /** Serialize mutations of the same key, so they are recorded in the order they are applied. */
+        std::array<std::mutex, STRIPE_COUNT> stripes_;
+
+        /** Guards the backlog and the watchers. */
+        std::mutex mutex_;
+
+        /** The backlog, the front entry is at `first_offset_`. */
+        std::deque<Entry> entries_;
+
+        std::uint64_t first_offset_ = 0;
+
+        /** The number of bytes in the backlog. */
+        std::size_t size_ = 0;
+
+        /** Called after every recorded entry. */
+        std::vector<std::pair<std::uint64_t, std::function<void()>>> watchers_;
+
+        std::uint64_t next_watcher_ = 0;
+
+        ReplicationLog();
+
+    public:
+        /**
+         * Enables recording. Must be called before any command is executed.
+         *
+         * \param capacity The maximum number of bytes kept in the backlog.
+         */
+        void enable(std::size_t capacity);
+
+        /**
+         * Returns whether mutations are recorded.
+         */
+        bool enabled() const { return capacity_ > 0; }
+
+        /**
+         * Returns the identifier of this run of the primary.
+         */
+        const std::string &id() const { return id_; }
+
+        /**
+         * Applies a mutation and records its entry, unless the mutation throws. The caller holds
+         * `GlobalRepository::lock_write()`, which holds off snapshots.
+         *
+         * \param key The key modified by the mutation.
+         * \param entry The entry replaying the mutation on a replica.
+         * \param mutation The mutation to be applied.
+         * \return The result of the mutation.
+         */
+        std::string record(std::string_view key, std::string entry, const std::function<std::string()> &mutation);
+
+        /**
+         * Forks a child process writing a snapshot to a pipe with `DataExporter::fork_save()`.
+         *
+         * \return The child and the pipe it writes to.
+         * \throws DatabaseException with the `REPL_SNAPSHOT` code if the pipe or the process cannot be created.
+         */
+        ForkedSnapshot fork_snapshot();
+
+        /**
+         * Returns whether a replica of the given run can continue at the given offset from the backlog.
+         *
+         * \param id The identifier of the run the replica replicated.
+         * \param offset The offset of the first entry the replica has not applied.
+         */
+        bool can_continue(const std::string &id, std::uint64_t offset);
+
+        /**
+         * Reads the entries following an offset.
+         *
+         * \param offset The offset of the first entry to be read.
+         * \param entries Receives the entries.
+         * \param max_bytes The number of bytes after which no further entry is read.
+         * \return False if the entry at the offset was already dropped from the backlog.
+         */
+        bool read(std::uint64_t offset, std::vector<Entry> &entries, std::size_t max_bytes);
+
+        /**
+         * Registers a function called after every recorded entry. It must not block.
+         *
+         * \param wake The function to be called.
+         * \return The identifier of the registration.
+         */
+        std::uint64_t watch(std::function<void()> wake);
+
+        /**
+         * Removes a registration.
+         *
+         * \param watcher The identifier returned by `watch()`.
+         */
+        void unwatch(std::uint64_t watcher);
+
+        /**
+         * Singleton access method returning a reference to the single instance of ReplicationLog.
+         *
+         * @return A reference to the single instance of ReplicationLog.
+         */
+        static ReplicationLog &get_instance()
+        {
+            static ReplicationLog instance;
+            return instance;
+        }
+    };
+}
@@ -1,56 +1,60 @@
 #include "repository.hpp"
 #include <iostream>
 #include <set>
+#include <algorithm>
 #include <utils.hpp>
+#include <cerrno>
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
 
 namespace db
 {
 
     // STRING
-    void StringRepository::create(const std::string &name, const std::string &value)
+    void StringRepository::create(std::string_view name, std::string_view value)
     {
         KeysStorage &storage = KeysStorage::get_instance();
         if (storage.contains(name))
         {
-            throw DatabaseException(name + " already exists", "KEY_EXISTS");
+            throw DatabaseException(std::string(name) + " already exists", "KEY_EXISTS");
         }
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::accessor a;
         data_.insert(a, name);
         a->second = value;
         storage.add(name);
     }
 
-    std::string StringRepository::get(const std::string &name)
+    std::string StringRepository::get(std::string_view name)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::const_accessor a;
         if (data_.find(a, name))
         {
             return a->second;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    bool StringRepository::exists(const std::string &name)
+    bool StringRepository::exists(std::string_view name)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
-        return data_.find(a, name);
+        return data_.count(name) > 0;
     }
 
-    unsigned int StringRepository::length(const std::string &name)
+    unsigned int StringRepository::length(std::string_view name)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::const_accessor a;
         if (data_.find(a, name))
         {
             return a->second.length();
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::string StringRepository::substring(const std::string &name, const unsigned int start, const unsigned int end)
+    std::string StringRepository::substring(std::string_view name, const unsigned int start, const unsigned int end)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::const_accessor a;
 
         if (start > end)
         {
@@ -66,36 +70,36 @@ namespace db
             return a->second.substr(start, end - start);
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    void StringRepository::append(const std::string &name, const std::string &postfix)
+    void StringRepository::append(std::string_view name, std::string_view postfix)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::accessor a;
         if (data_.find(a, name))
         {
             a->second.append(postfix);
             return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    void StringRepository::prepend(const std::string &name, const std::string &prefix)
+    void StringRepository::prepend(std::string_view name, std::string_view prefix)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::accessor a;
         if (data_.find(a, name))
         {
-            a->second = prefix + a->second;
+            a->second.insert(0, prefix);
             return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    void StringRepository::insert(const std::string &name, const std::string &value, unsigned int index)
+    void StringRepository::insert(std::string_view name, std::string_view value, unsigned int index)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::accessor a;
         if (data_.find(a, name))
         {
             if (index <= a->second.length())
@@ -107,12 +111,12 @@ namespace db
             throw DatabaseException("Index is out of range", "INVALID_ARGUMENTS");
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    void StringRepository::trim(const std::string &name, const unsigned int start, const unsigned int end)
+    void StringRepository::trim(std::string_view name, const unsigned int start, const unsigned int end)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::accessor a;
         if (data_.find(a, name))
         {
             if (start <= end && end <= a->second.length())
@@ -125,12 +129,12 @@ namespace db
             throw DatabaseException("Invalid range", "INVALID_ARGUMENTS");
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    void StringRepository::ltrim(const std::string &name, const unsigned int count)
+    void StringRepository::ltrim(std::string_view name, const unsigned int count)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::accessor a;
         if (data_.find(a, name))
         {
             if (count <= a->second.length())
@@ -142,12 +146,12 @@ namespace db
             throw DatabaseException("Invalid range", "INVALID_ARGUMENTS");
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    void StringRepository::rtrim(const std::string &name, const unsigned int count)
+    void StringRepository::rtrim(std::string_view name, const unsigned int count)
     {
-        tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+        StringMap<std::string>::accessor a;
         if (data_.find(a, name))
         {
             if (count <= a->second.length())
@@ -158,211 +162,304 @@ namespace db
 
             throw DatabaseException("Invalid range", "INVALID_ARGUMENTS");
         }
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
     // SETS
 
-    void SetRepository::create(const std::string &name)
+    void SetRepository::create(std::string_view name)
     {
         KeysStorage &storage = KeysStorage::get_instance();
         if (storage.contains(name))
         {
-            throw DatabaseException(name + " already exists", "KEY_EXISTS");
+            throw DatabaseException(std::string(name) + " already exists", "KEY_EXISTS");
         }
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
+        StringMap<StringSet>::accessor a;
         data_.insert(a, name);
-        a->second = tbb::concurrent_set<std::string>{};
+        a->second = StringSet{};
         storage.add(name);
     }
 
-    void SetRepository::add(const std::string &name, const std::string &value)
+    void SetRepository::add(std::string_view name, std::string_view value)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
+        StringMap<StringSet>::accessor a;
         if (data_.find(a, name))
         {
-            a->second.insert(value);
+            a->second.emplace(value);
             return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    unsigned int SetRepository::len(const std::string &name)
+    unsigned int SetRepository::len(std::string_view name)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
+        StringMap<StringSet>::const_accessor a;
         if (data_.find(a, name))
         {
             return a->second.size();
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::vector<std::string> SetRepository::intersection(const std::vector<std::string> &names)
+    std::vector<const StringSet *> SetRepository::lock_sets(std::span<const std::pmr::string> names,
+                                                            std::vector<StringMap<StringSet>::const_accessor> &accessors)
     {
-        if (names.empty())
-        {
-            return {};
-        }
-
-        auto unique_names = std::set<std::string>(names.begin(), names.end());
+        // Sets are locked in the order of their names, so commands locking the same sets never wait for each other.
+        std::set<std::string_view> unique_names(names.begin(), names.end());
+        accessors = std::vector<StringMap<StringSet>::const_accessor>(unique_names.size());
 
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
-        auto is_first_set_found = data_.find(a, names[0]);
-
-        if (!is_first_set_found)
+        std::vector<const StringSet *> sets;
+        for (std::string_view name : unique_names)
         {
-
-            throw DatabaseException(names[0] + " does not exist", "KEY_NOT_FOUND");
+            if (!data_.find(accessors[sets.size()], name))
+            {
+                throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
+            }
+            sets.push_back(&accessors[sets.size()]->second);
         }
+        return sets;
+    }
 
-        std::set<std::string> intersection;
-        for (auto &&e : a->second)
+    void SetRepository::intersection(std::span<const std::pmr::string> names, const ElementVisitor &visit)
+    {
+        if (names.empty())
         {
-            intersection.insert(e);
+            return;
         }
-        a.release();
 
-        for (auto &&name : unique_names)
+        std::vector<StringMap<StringSet>::const_accessor> accessors;
+        auto sets = lock_sets(names, accessors);
+
+        // The members of the smallest set are visited in ascending order if every other set contains them as well.
+        auto smallest = *std::min_element(sets.begin(), sets.end(), [](const StringSet *a, const StringSet *b)
+                                          { return a->size() < b->size(); });
+        for (auto &&element : *smallest)
         {
-            tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor b;
-            if (data_.find(b, name))
-            {
-                std::set<std::string> result;
-                std::set_intersection(intersection.begin(), intersection.end(),
-                                      b->second.begin(), b->second.end(),
-                                      std::inserter(result, result.end()));
-                intersection = result;
-            }
-            else
+            if (std::all_of(sets.begin(), sets.end(), [&](const StringSet *set)
+                            { return set == smallest || set->contains(element); }))
             {
-                throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+                visit(element);
             }
         }
-
-        return std::vector<std::string>(intersection.begin(), intersection.end());
     }
 
-    std::vector<std::string> SetRepository::difference(const std::string &name_1, const std::string &name_2)
+    void SetRepository::difference(std::string_view name_1, std::string_view name_2, const ElementVisitor &visit)
     {
         if (name_1 == name_2)
         {
             throw DatabaseException("Cannot make difference between two objects with the same name", "INVALID_ARGUMENTS");
         }
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a, b;
-        if (!data_.find(a, name_1) || !data_.find(b, name_2))
+
+        // Both sets are locked in the order of their names, like in lock_sets().
+        StringMap<StringSet>::const_accessor a, b;
+        bool found = name_1 < name_2 ? data_.find(a, name_1) && data_.find(b, name_2)
+                                     : data_.find(b, name_2) && data_.find(a, name_1);
+        if (!found)
         {
             throw DatabaseException("One of key does not exist", "KEY_NOT_FOUND");
         }
 
-        std::set<std::string> difference;
-        std::set_difference(a->second.begin(), a->second.end(),
-                            b->second.begin(), b->second.end(),
-                            std::inserter(difference, difference.end()));
-
-        return std::vector<std::string>(difference.begin(), difference.end());
+        for (auto &&element : a->second)
+        {
+            if (!b->second.contains(element))
+            {
+                visit(element);
+            }
+        }
     }
 
-    std::vector<std::string> SetRepository::union_(const std::vector<std::string> &names)
+    void SetRepository::union_(std::span<const std::pmr::string> names, const ElementVisitor &visit)
     {
         if (names.empty())
         {
-            return {};
+            return;
         }
 
-        auto unique_names = std::set<std::string>(names.begin(), names.end());
+        std::vector<StringMap<StringSet>::const_accessor> accessors;
+        auto sets = lock_sets(names, accessors);
 
-        std::set<std::string> union_set;
-
-        for (const std::string &name : names)
+        // The sets are merged: the smallest of their next members is visited once and every set holding it moves past it.
+        std::vector<std::pair<StringSet::const_iterator, StringSet::const_iterator>> ranges;
+        for (auto &&set : sets)
+        {
+            ranges.emplace_back(set->begin(), set->end());
+        }
+        while (true)
         {
-            tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
-            if (data_.find(a, name))
+            const std::string *next = nullptr;
+            for (auto &&[it, end] : ranges)
             {
-                union_set.insert(a->second.begin(), a->second.end());
+                if (it != end && (!next || *it < *next))
+                {
+                    next = &*it;
+                }
             }
-            else
+            if (!next)
             {
-                throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+                return;
             }
-        }
 
-        return std::vector<std::string>(union_set.begin(), union_set.end());
+            visit(*next);
+            for (auto &&[it, end] : ranges)
+            {
+                if (it != end && *it == *next)
+                {
+                    ++it;
+                }
+            }
+        }
     }
 
-    bool SetRepository::contains(const std::string &name, const std::string &value)
+    bool SetRepository::contains(std::string_view name, std::string_view value)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
+        StringMap<StringSet>::const_accessor a;
         if (data_.find(a, name))
         {
             return a->second.count(value) > 0;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::vector<std::string> SetRepository::get_all(const std::string &name)
+    void SetRepository::get_all(std::string_view name, const ElementVisitor &visit)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
+        StringMap<StringSet>::const_accessor a;
         if (data_.find(a, name))
         {
-            return std::vector<std::string>(a->second.begin(), a->second.end());
+            std::for_each(a->second.begin(), a->second.end(), visit);
+            return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::string SetRepository::pop(const std::string &name, const std::string &value)
+    std::string SetRepository::pop(std::string_view name, std::string_view value)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
+        StringMap<StringSet>::accessor a;
         if (data_.find(a, name))
         {
             if (a->second.count(value) > 0)
             {
                 a->second.unsafe_erase(value);
-                return value;
+                return std::string(value);
             }
 
             throw DatabaseException("Value not found in set", "VALUE_NOT_FOUND");
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
     // QUEUES
 
-    void QueueRepository::create(const std::string &name)
+    QueueWaiter::QueueWaiter(std::function<void(std::optional<std::string>)> deliver) : deliver_{std::move(deliver)} {}
+
+    bool QueueWaiter::try_claim()
+    {
+        return !claimed_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    void QueueWaiter::deliver(std::optional<std::string> value)
+    {
+        deliver_(std::move(value));
+    }
+
+    void QueueRepository::create(std::string_view name)
     {
         KeysStorage &storage = KeysStorage::get_instance();
         if (storage.contains(name))
         {
-            throw DatabaseException(name + " already exists", "KEY_EXISTS");
+            throw DatabaseException(std::string(name) + " already exists", "KEY_EXISTS");
         }
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_queue<std::string>>::accessor a;
+        StringMap<Queue>::accessor a;
         data_.insert(a, name);
         storage.add(name);
     }
 
-    void QueueRepository::push(const std::string &name, const std::string &value)
+    void QueueRepository::push(std::string_view name, std::string_view value)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_queue<std::string>>::accessor a;
+        StringMap<Queue>::accessor a;
         if (data_.find(a, name))
         {
-            a->second.push(value);
+            // Waiters which gave up are claimed already and are skipped.
+            auto &waiters = a->second.waiters;
+            while (!waiters.empty())
+            {
+                std::shared_ptr<QueueWaiter> waiter = std::move(waiters.front());
+                waiters.pop_front();
+                if (waiter->try_claim())
+                {
+                    a.release();
+                    waiter->deliver(std::string(value));
+                    return;
+                }
+            }
+            a->second.items.emplace(value);
             return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
+    }
+
+    std::optional<std::string> QueueRepository::pop_or_wait(std::string_view name, const std::shared_ptr<QueueWaiter> &waiter)
+    {
+        StringMap<Queue>::accessor a;
+        if (!data_.find(a, name))
+        {
+            throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
+        }
+
+        std::string value;
+        if (a->second.items.try_pop(value))
+        {
+            return value;
+        }
+        a->second.waiters.push_back(waiter);
+        return std::nullopt;
     }
 
-    std::string QueueRepository::pop(const std::string &name)
+    void QueueRepository::cancel_wait(std::string_view name, const std::shared_ptr<QueueWaiter> &waiter)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_queue<std::string>>::accessor a;
+        StringMap<Queue>::accessor a;
+        if (data_.find(a, name))
+        {
+            auto &waiters = a->second.waiters;
+            waiters.erase(std::remove(waiters.begin(), waiters.end(), waiter), waiters.end());
+        }
+    }
+
+    bool QueueRepository::remove(std::string_view name)
+    {
+        std::deque<std::shared_ptr<QueueWaiter>> waiters;
+        {
+            StringMap<Queue>::accessor a;
+            if (!data_.find(a, name))
+            {
+                return false;
+            }
+            waiters.swap(a->second.waiters);
+            data_.erase(a);
+        }
+
+        for (auto &&waiter : waiters)
+        {
+            if (waiter->try_claim())
+            {
+                waiter->deliver(std::nullopt);
+            }
+        }
+        return true;
+    }
+
+    std::string QueueRepository::pop(std::string_view name)
+    {
+        StringMap<Queue>::accessor a;
         if (data_.find(a, name))
         {
             std::string value;
-            if (!a->second.try_pop(value))
+            if (!a->second.items.try_pop(value))
             {
                 throw DatabaseException("Queue is empty", "QUEUE_EMPTY");
             }
@@ -370,26 +467,26 @@ namespace db
             return value;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
     // HASHES
 
-    void HashRepository::create(const std::string &name)
+    void HashRepository::create(std::string_view name)
     {
         KeysStorage &storage = KeysStorage::get_instance();
         if (storage.contains(name))
         {
-            throw DatabaseException(name + " already exists", "KEY_EXISTS");
+            throw DatabaseException(std::string(name) + " already exists", "KEY_EXISTS");
         }
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::accessor a;
         data_.insert(a, name);
         storage.add(name);
     }
 
-    void HashRepository::del(const std::string &name, const std::string &key)
+    void HashRepository::del(std::string_view name, std::string_view key)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::accessor a;
         if (data_.find(a, name))
         {
             if (!a->second.erase(key))
@@ -398,126 +495,138 @@ namespace db
             }
             return;
         }
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    bool HashRepository::exists(const std::string &name, const std::string &key)
+    bool HashRepository::exists(std::string_view name, std::string_view key)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::const_accessor a;
         if (data_.find(a, name))
         {
             return a->second.count(key) > 0;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::string HashRepository::get(const std::string &name, const std::string &key)
+    std::string HashRepository::get(std::string_view name, std::string_view key)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::const_accessor a;
         if (data_.find(a, name))
         {
-            if (a->second.count(key) > 0)
+            // Only the non-const find() looks up a string_view, finding does not modify the concurrent map.
+            StringMap<std::string>::const_accessor b;
+            if (const_cast<StringMap<std::string> &>(a->second).find(b, key))
             {
-                tbb::concurrent_hash_map<std::string, std::string>::accessor b;
-                a->second.find(b, key);
                 return b->second;
             }
 
             throw DatabaseException("Key not found in hash", "KEY_NOT_FOUND");
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::vector<std::pair<std::string, std::string>> HashRepository::get_all(const std::string &name)
+    void HashRepository::get_all(std::string_view name, const PairVisitor &visit)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::const_accessor a;
         if (data_.find(a, name))
         {
-            std::vector<std::pair<std::string, std::string>> all_data;
             for (auto it = a->second.begin(); it != a->second.end(); ++it)
             {
-                all_data.push_back(*it);
+                visit(it->first, it->second);
             }
-            return all_data;
+            return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::vector<std::string> HashRepository::get_keys(const std::string &name)
+    void HashRepository::get_keys(std::string_view name, const ElementVisitor &visit)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::const_accessor a;
         if (data_.find(a, name))
         {
-            std::vector<std::string> all_keys;
             for (auto it = a->second.begin(); it != a->second.end(); ++it)
             {
-                all_keys.push_back(it->first);
+                visit(it->first);
             }
-            return all_keys;
+            return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    void HashRepository::set(const std::string &name, const std::string &key, const std::string &value)
+    void HashRepository::set(std::string_view name, std::string_view key, std::string_view value)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::accessor a;
         if (data_.find(a, name))
         {
-            a->second.insert(std::make_pair(key, value));
+            a->second.emplace(key, value);
             return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    uint HashRepository::len(const std::string &name)
+    uint HashRepository::len(std::string_view name)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::const_accessor a;
         if (data_.find(a, name))
         {
             return a->second.size();
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::vector<std::string> HashRepository::search(const std::string &name, const std::string &query)
+    void HashRepository::search(std::string_view name, std::string_view query, const ElementVisitor &visit)
     {
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+        StringMap<StringMap<std::string>>::const_accessor a;
         if (data_.find(a, name))
         {
-            std::vector<std::string> result;
             for (auto it = a->second.begin(); it != a->second.end(); ++it)
             {
-                result.push_back(it->first);
+                if (it->first.find(query) != std::string::npos)
+                {
+                    visit(it->first);
+                }
             }
-            result;
-            std::erase_if(result, [&](const std::string &key)
-                          { return key.find(query) == std::string::npos; });
-            return result;
+            return;
         }
 
-        throw DatabaseException(name + " does not exist", "KEY_NOT_FOUND");
+        throw DatabaseException(std::string(name) + " does not exist", "KEY_NOT_FOUND");
     }
 
-    std::vector<std::string> GlobalRepository::keys(std::string &pattern)
+    void GlobalRepository::keys(std::string_view pattern, const ElementVisitor &visit)
     {
-        auto &&result = keys_storage_.get_keys();
+        keys_storage_.for_each([&](const std::string &key)
+                               {
+                                   if (pattern == "*" || key.find(pattern) != std::string::npos)
+                                   {
+                                       visit(key);
+                                   } });
+    }
+
+    std::shared_lock<std::shared_mutex> GlobalRepository::lock_write()
+    {
+        return std::shared_lock<std::shared_mutex>(snapshot_mutex_);
+    }
+
+    std::unique_lock<std::shared_mutex> GlobalRepository::lock_snapshot()
+    {
+        return std::unique_lock<std::shared_mutex>(snapshot_mutex_);
+    }
 
-        if (pattern != "*")
+    void GlobalRepository::clear()
+    {
+        for (auto key : keys_storage_.get_keys())
         {
-            std::erase_if(result, [&](const std::string &key)
-                          { return key.find(pattern) == std::string::npos; });
+            del(key);
         }
-
-        return std::vector<std::string>{result.begin(), result.end()};
     }
 
-    void GlobalRepository::del(std::string &key)
+    void GlobalRepository::del(std::string_view key)
     {
         if (keys_storage_.contains(key))
         {
@@ -531,7 +640,7 @@ namespace db
                 keys_storage_.remove(key);
                 return;
             }
-            if (queue_repository_.data_.erase(key))
+            if (queue_repository_.remove(key))
             {
                 keys_storage_.remove(key);
                 return;
@@ -545,15 +654,25 @@ namespace db
     }
 
 
-        bool DataExporter::save(const std::string &filename)
+        bool DataExporter::save(const std::string &filename, IoBackend backend)
         {
-            std::fstream file(filename, std::ios::binary | std::ios::out);
-            if (!file.is_open())
+            auto writer = SnapshotWriter::open(filename, backend);
+            if (!writer)
             {
                 std::cerr << "Error opening file: " << filename << std::endl;
                 return false;
             }
-            file.clear();
+            if (!save(*writer))
+            {
+                std::cerr << "Error writing file: " << filename << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        bool DataExporter::save(SnapshotWriter &writer)
+        {
+            SnapshotStream file(writer);
 
             file.write("[HEADER]\0", 9);
 
@@ -565,11 +684,43 @@ namespace db
 
             file.write("[FOOTER]\3", 9);
 
-            file.close();
-            return true;
+            return file.close();
         }
 
-        void DataExporter::save_string_data(std::fstream &file)
+        pid_t DataExporter::fork_save(const std::function<bool()> &save, const std::function<void()> &forked)
+        {
+            auto lock = GlobalRepository::get_instance().lock_snapshot();
+            pid_t pid = ::fork();
+            if (pid == 0)
+            {
+                // The child only serializes its copy of the keyspace, no other thread of the server exists in it.
+                ::_exit(save() ? 0 : 1);
+            }
+            if (pid > 0 && forked)
+            {
+                forked();
+            }
+            return pid;
+        }
+
+        bool DataExporter::wait_save(pid_t pid, bool abort)
+        {
+            if (abort)
+            {
+                ::kill(pid, SIGKILL);
+            }
+            int status = 0;
+            while (::waitpid(pid, &status, 0) < 0)
+            {
+                if (errno != EINTR)
+                {
+                    return false;
+                }
+            }
+            return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+
+        void DataExporter::save_string_data(SnapshotStream &file)
         {
             auto &string_repository = StringRepository::get_instance();
             uint32_t string_count = string_repository.data_.size();
@@ -587,7 +738,7 @@ namespace db
             }
         }
 
-        void DataExporter::save_set_data(std::fstream &file)
+        void DataExporter::save_set_data(SnapshotStream &file)
         {
             auto &set_repository = SetRepository::get_instance();
             uint32_t set_count = set_repository.data_.size();
@@ -611,7 +762,7 @@ namespace db
             }
         }
 
-        void DataExporter::save_hash_data(std::fstream &file)
+        void DataExporter::save_hash_data(SnapshotStream &file)
         {
             auto &hash_repository = HashRepository::get_instance();
             uint32_t map_count = hash_repository.data_.size();
@@ -648,7 +799,11 @@ namespace db
             std::cerr << "Error opening file: " << filename << std::endl;
             return false;
         }
+        return load(file);
+    }
 
+    bool DataImporter::load(std::istream &file)
+    {
         char header[9];
         file.read(header, sizeof(header));
         if (std::string(header) != "[HEADER]\0")
@@ -662,12 +817,10 @@ namespace db
         load_set_data(file);
 
         load_hash_data(file);
-
-        file.close();
         return true;
     }
 
-    void DataImporter::load_string_data(std::ifstream &file)
+    void DataImporter::load_string_data(std::istream &file)
     {
         uint32_t string_count;
         file.read(reinterpret_cast<char *>(&string_count), sizeof(string_count));
@@ -685,14 +838,14 @@ namespace db
             file.read(&value[0], value_length);
             file.get(); // Discard null terminator
 
-            tbb::concurrent_hash_map<std::string, std::string>::accessor a;
+            StringMap<std::string>::accessor a;
             StringRepository::get_instance().data_.insert(a, key);
             a->second = value;
             KeysStorage::get_instance().add(key);
         }
     }
 
-    void DataImporter::load_set_data(std::ifstream &file)
+    void DataImporter::load_set_data(std::istream &file)
     {
         uint32_t set_count;
         file.read(reinterpret_cast<char *>(&set_count), sizeof(set_count));
@@ -716,14 +869,14 @@ namespace db
                 file.get(); // Discard null terminator
                 value_set.insert(value);
             }
-            tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>>::accessor a;
+            StringMap<StringSet>::accessor a;
             SetRepository::get_instance().data_.insert(a, key);
-            a->second = tbb::concurrent_set<std::string>{value_set.begin(), value_set.end()};
+            a->second = StringSet{value_set.begin(), value_set.end()};
             KeysStorage::get_instance().add(key);
         }
     }
 
-    void DataImporter::load_hash_data(std::ifstream &file)
+    void DataImporter::load_hash_data(std::istream &file)
     {
         uint32_t map_count;
         file.read(reinterpret_cast<char *>(&map_count), sizeof(map_count));
@@ -753,9 +906,9 @@ namespace db
                 file.get(); // Discard null terminator
                 inner_map[inner_key] = value;
             }
-            tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>>::accessor a;
+            StringMap<StringMap<std::string>>::accessor a;
             HashRepository::get_instance().data_.insert(a, key);
-            a->second = tbb::concurrent_hash_map<std::string, std::string>{inner_map.begin(), inner_map.end()};
+            a->second = StringMap<std::string>{inner_map.begin(), inner_map.end()};
             KeysStorage::get_instance().add(key);
         }
     }
@@ -1,16 +1,66 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <span>
+#include <memory_resource>
 #include <vector>
 #include <tbb/concurrent_hash_map.h>
 #include <tbb/concurrent_set.h>
 #include <tbb/concurrent_queue.h>
 #include <set>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <snapshot_writer.hpp>
+#include <sys/types.h>
 
 namespace db
 {
+    /**
+     * A function called for every element a repository streams, e.g. the members of a set.
+     */
+    using ElementVisitor = std::function<void(const std::string &)>;
+
+    /**
+     * A function called for every key-value pair a repository streams.
+     */
+    using PairVisitor = std::function<void(const std::string &, const std::string &)>;
+
+    /**
+     * Hashes and compares the string keys of the repositories. It is transparent, so keys are looked up with the
+     * `std::string_view`s of a command without being copied into a `std::string`.
+     */
+    struct StringHashCompare
+    {
+        using is_transparent = void;
+
+        static std::size_t hash(std::string_view key)
+        {
+            return std::hash<std::string_view>{}(key);
+        }
+
+        static bool equal(std::string_view left, std::string_view right)
+        {
+            return left == right;
+        }
+    };
+
+    /**
+     * A concurrent map from strings, looked up without copying the key.
+     */
+    template <typename T>
+    using StringMap = tbb::concurrent_hash_map<std::string, T, StringHashCompare>;
+
+    /**
+     * A concurrent sorted set of strings, looked up without copying the value.
+     */
+    using StringSet = tbb::concurrent_set<std::string, std::less<>>;
 
     class GlobalRepository;
     class DataExporter;
@@ -21,11 +71,16 @@ namespace db
      * \brief Class for storing and managing all keys registered in the database.
      *
      * This class provides thread-safe methods for adding, checking existence, removing, and retrieving all stored keys.
+     * The concurrent set supports concurrent inserts, lookups and traversals, but not erasing, so removing a key locks
+     * the storage exclusively and every other method locks it shared.
      */
     class KeysStorage
     {
     private:
-        tbb::concurrent_set<std::string> keys_;
+        StringSet keys_;
+
+        /** Held exclusively only while a key is erased. */
+        std::shared_mutex mutex_;
 
     public:
         /**
@@ -35,9 +90,10 @@ namespace db
          *
          * @param key The key to be added.
          */
-        void add(const std::string &key)
+        void add(std::string_view key)
         {
-            keys_.insert(key);
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            keys_.emplace(key);
         }
 
         /**
@@ -48,29 +104,46 @@ namespace db
          * @param key The key to be checked.
          * @return True if the key exists, false otherwise.
          */
-        bool contains(const std::string &key)
+        bool contains(std::string_view key)
         {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
             return keys_.find(key) != keys_.end();
         }
 
         /**
          * Removes a key from the storage.
          *
-         * This method uses the concurrent set's unsafe_erase operation to remove the specified key.
-         * **Note:** unsafe_erase should be used with caution in multi-threaded environments. Ensure proper synchronization if necessary.
+         * This method uses the concurrent set's unsafe_erase operation to remove the specified key, so it waits until no
+         * other method of the storage is in progress.
          *
          * @param key The key to be removed.
          */
-        void remove(const std::string &key)
+        void remove(std::string_view key)
         {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
             keys_.unsafe_erase(key);
         }
 
         std::set<std::string> get_keys()
         {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
             return std::set<std::string>(keys_.begin(), keys_.end());
         }
 
+        /**
+         * Visits every key in ascending order without copying the keys. Keys are not removed meanwhile.
+         *
+         * @param visit Called for every key. It must not remove keys.
+         */
+        void for_each(const ElementVisitor &visit)
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            for (auto &&key : keys_)
+            {
+                visit(key);
+            }
+        }
+
         /**
          * Singleton access method returning a reference to the single instance of KeysStorage.
          *
@@ -89,6 +162,8 @@ namespace db
      * \brief A class providing thread-safe storage and manipulation of string values.
      *
      * The class offers various methods for managing and modifying string data identified by unique names.
+     * Reads lock a string shared, so concurrent reads of a popular key do not wait for each other; modifications lock it
+     * exclusively.
      */
     class StringRepository
     {
@@ -103,7 +178,7 @@ namespace db
          * @param name The name of the string.
          * @param value The initial value of the string.
          */
-        void create(const std::string &name, const std::string &value);
+        void create(std::string_view name, std::string_view value);
 
         /**
          * Returns the value of the string with the given name.
@@ -111,7 +186,7 @@ namespace db
          * @param name The name of the string.
          * @return The value of the string, or an empty string if the string does not exist.
          */
-        std::string get(const std::string &name);
+        std::string get(std::string_view name);
 
         /**
          * Checks if a string with the given name exists.
@@ -119,7 +194,7 @@ namespace db
          * @param name The name of the string.
          * @return True if a string with the given name exists, false otherwise.
          */
-        bool exists(const std::string &name);
+        bool exists(std::string_view name);
 
         /**
          * Returns the length of the string with the given name.
@@ -127,7 +202,7 @@ namespace db
          * @param name The name of the string.
          * @return The length of the string, or 0 if the string does not exist.
          */
-        unsigned int length(const std::string &name);
+        unsigned int length(std::string_view name);
 
         /**
          * Returns a substring of the string with the given name.
@@ -137,7 +212,7 @@ namespace db
          * @param end The index of the last character in the substring.
          * @return The substring, or an exception is thrown if the string does not exist or the specified range is out of bounds.
          */
-        std::string substring(const std::string &name, const unsigned int start, const unsigned int end);
+        std::string substring(std::string_view name, const unsigned int start, const unsigned int end);
 
         /**
          * Appends the given string to the end of the string with the given name.
@@ -145,7 +220,7 @@ namespace db
          * @param name The name of the string.
          * @param postifx The string to be appended.
          */
-        void append(const std::string &name, const std::string &postifx);
+        void append(std::string_view name, std::string_view postifx);
 
         /**
          * Prepends the given string to the beginning of the string with the given name.
@@ -153,7 +228,7 @@ namespace db
          * @param name The name of the string.
          * @param preifx The string to be prepended.
          */
-        void prepend(const std::string &name, const std::string &preifx);
+        void prepend(std::string_view name, std::string_view preifx);
 
         /**
          * Inserts the given string at the specified index in the string with the given name.
@@ -162,7 +237,7 @@ namespace db
          * @param value The string to be inserted.
          * @param index The index at which to insert the string.
          */
-        void insert(const std::string &name, const std::string &value, unsigned int index);
+        void insert(std::string_view name, std::string_view value, unsigned int index);
 
         /**
          * Trims the string with the given name by removing characters from the beginning or end.
@@ -171,7 +246,7 @@ namespace db
          * @param start The index of the first character to be removed.
          * @param end The index of the last character to be removed.
          */
-        void trim(const std::string &name, const unsigned int start, const unsigned int end);
+        void trim(std::string_view name, const unsigned int start, const unsigned int end);
 
         /**
          * Trims the string with the given name by removing characters from the beginning.
@@ -179,7 +254,7 @@ namespace db
          * @param name The name of the string.
          * @param count The number of characters to be removed from the beginning.
          */
-        void ltrim(const std::string &name, const unsigned int count);
+        void ltrim(std::string_view name, const unsigned int count);
 
         /**
          * Trims the string with the given name by removing characters from the end.
@@ -187,7 +262,7 @@ namespace db
          * @param name The name of the string.
          * @param count The number of characters to be removed from the end.
          */
-        void rtrim(const std::string &name, const unsigned int count);
+        void rtrim(std::string_view name, const unsigned int count);
 
         static StringRepository &get_instance()
         {
@@ -196,7 +271,7 @@ namespace db
         }
 
     private:
-        tbb::concurrent_hash_map<std::string, std::string> data_;
+        StringMap<std::string> data_;
     };
 
     /**
@@ -204,6 +279,7 @@ namespace db
      * \brief A class providing thread-safe storage and manipulation of sets of strings.
      *
      * The class offers methods for managing and modifying sets identified by unique names. Each set can contain unique string values.
+     * Reads lock a set shared and modifications exclusively, like in StringRepository.
      */
     class SetRepository
     {
@@ -212,7 +288,17 @@ namespace db
         friend class DataImporter;
 
     private:
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_set<std::string>> data_;
+        StringMap<StringSet> data_;
+
+        /**
+         * Locks the sets with the given names shared, in the order of their names.
+         *
+         * \param names The names of the sets, a name may repeat.
+         * \param accessors Receives the accessors holding the locks, one per distinct name.
+         * \return The locked sets.
+         */
+        std::vector<const StringSet *> lock_sets(std::span<const std::pmr::string> names,
+                                                 std::vector<StringMap<StringSet>::const_accessor> &accessors);
 
     public:
         /**
@@ -220,7 +306,7 @@ namespace db
          *
          * \param name The name of the set to be created.
          */
-        void create(const std::string &name);
+        void create(std::string_view name);
 
         /**
          * Adds a new string value to the set identified by the given name.
@@ -228,7 +314,7 @@ namespace db
          * \param name The name of the set.
          * \param value The string value to be added to the set.
          */
-        void add(const std::string &name, const std::string &value);
+        void add(std::string_view name, std::string_view value);
 
         /**
          * Returns the number of elements in the set identified by the given name.
@@ -236,16 +322,19 @@ namespace db
          * \param name The name of the set.
          * \return The number of elements (strings) in the set.
          */
-        unsigned int len(const std::string &name);
+        unsigned int len(std::string_view name);
 
         /**
-         * Calculates the intersection of elements from multiple sets identified by names in the provided vector.
+         * Calculates the intersection of elements from multiple sets identified by the given names.
          * The intersection includes elements present in all specified sets.
          *
-         * \param names A vector containing names of the sets to be used for intersection.
-         * \return A vector containing the elements that are present in all the sets.
+         * The members of the smallest set are streamed straight from it while all the sets are locked, nothing is copied.
+         *
+         * \param names The names of the sets to be used for intersection.
+         * \param visit Called for every element present in all the sets, in ascending order. It must not access the set
+         *              repository.
          */
-        std::vector<std::string> intersection(const std::vector<std::string> &names);
+        void intersection(std::span<const std::pmr::string> names, const ElementVisitor &visit);
 
         /**
          * Calculates the difference between two sets identified by the provided names.
@@ -253,18 +342,22 @@ namespace db
          *
          * \param name_1 The name of the first set.
          * \param name_2 The name of the second set.
-         * \return A vector containing the elements that are present in the first set but not in the second.
+         * \param visit Called for every element present in the first set but not in the second, in ascending order, while both
+         *              sets are locked. It must not access the set repository.
          */
-        std::vector<std::string> difference(const std::string &name_1, const std::string &name_2);
+        void difference(std::string_view name_1, std::string_view name_2, const ElementVisitor &visit);
 
         /**
-         * Calculates the union of elements from multiple sets identified by names in the provided vector.
+         * Calculates the union of elements from multiple sets identified by the given names.
          * The union includes all unique elements present in any of the specified sets.
          *
-         * \param names A vector containing names of the sets to be used for union.
-         * \return A vector containing the elements that are present in any of the sets.
+         * The sets are merged while they are locked, nothing is copied.
+         *
+         * \param names The names of the sets to be used for union.
+         * \param visit Called once for every element present in any of the sets, in ascending order. It must not access the
+         *              set repository.
          */
-        std::vector<std::string> union_(const std::vector<std::string> &names); // underscore used to avoid conflict with C++ union keyword
+        void union_(std::span<const std::pmr::string> names, const ElementVisitor &visit); // underscore used to avoid conflict with C++ union keyword
 
         /**
          * Checks if a specific string value exists within the set identified by the given name.
@@ -273,15 +366,15 @@ namespace db
          * \param value The string value to be searched for.
          * \return True if the value exists in the set, false otherwise.
          */
-        bool contains(const std::string &name, const std::string &value);
+        bool contains(std::string_view name, std::string_view value);
 
         /**
-         * Retrieves all string values from the set identified by the given name.
+         * Visits all string values of the set identified by the given name while the set is locked, without copying them.
          *
          * \param name The name of the set.
-         * \return A vector containing all string elements in the set, or an empty vector if the set does not exist.
+         * \param visit Called for every element of the set. It must not access the set repository.
          */
-        std::vector<std::string> get_all(const std::string &name);
+        void get_all(std::string_view name, const ElementVisitor &visit);
 
         /**
          * Removes and returns a single string value from the set identified by the given name.
@@ -291,7 +384,7 @@ namespace db
          * \param value The string value to be removed.
          * \return The removed string value. If the set does not exists or the value does not exist then exception is thrown.
          */
-        std::string pop(const std::string &name, const std::string &value);
+        std::string pop(std::string_view name, std::string_view value);
 
         /**
          * Singleton access method returning a reference to the single instance of SetRepository.
@@ -305,18 +398,71 @@ namespace db
         }
     };
 
+    /**
+     * \class QueueWaiter
+     * \brief A client parked on an empty queue until an item is pushed.
+     *
+     * A waiter is completed exactly once: by a push delivering an item, by the removal of the queue, or by its owner giving up
+     * (e.g. on a timeout). Whoever wins `try_claim()` completes it.
+     */
+    class QueueWaiter
+    {
+    private:
+        std::atomic<bool> claimed_{false};
+        std::function<void(std::optional<std::string>)> deliver_;
+
+    public:
+        /**
+         * \param deliver Called with the popped item, or with no value if the queue was removed. It must not block, it runs
+         *                on the thread of the pushing command.
+         */
+        explicit QueueWaiter(std::function<void(std::optional<std::string>)> deliver);
+
+        /**
+         * Claims the right to complete the waiter.
+         *
+         * \return True for the first caller only.
+         */
+        bool try_claim();
+
+        /**
+         * Completes a claimed waiter.
+         *
+         * \param value The popped item, or no value if the queue was removed.
+         */
+        void deliver(std::optional<std::string> value);
+    };
+
     /**
      * \class QueueRepository
      * \brief A class providing thread-safe storage and manipulation of queues of strings.
      *
      * The class offers methods for managing and modifying queues identified by unique names. Each queue follows the First-In-First-Out (FIFO) principle, where elements are added at the back and removed from the front.
+     * Clients waiting for an item of an empty queue are kept in FIFO order as well and a pushed item goes to the longest waiting client.
      */
     class QueueRepository
     {
         friend class GlobalRepository;
 
     private:
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_queue<std::string>> data_;
+        /**
+         * A queue together with the clients waiting for its items. There are never items and live waiters at the same time.
+         */
+        struct Queue
+        {
+            tbb::concurrent_queue<std::string> items;
+            std::deque<std::shared_ptr<QueueWaiter>> waiters;
+        };
+
+        StringMap<Queue> data_;
+
+        /**
+         * Removes the queue with the given name and completes all its waiters with no value.
+         *
+         * \param name The name of the queue.
+         * \return True if the queue existed.
+         */
+        bool remove(std::string_view name);
 
     public:
         /**
@@ -324,7 +470,7 @@ namespace db
          *
          * \param name The name of the queue to be created.
          */
-        void create(const std::string &name);
+        void create(std::string_view name);
 
         /**
          * Adds a new string value to the back of the queue identified by the given name.
@@ -332,7 +478,7 @@ namespace db
          * \param name The name of the queue.
          * \param value The string value to be added to the queue.
          */
-        void push(const std::string &name, const std::string &value);
+        void push(std::string_view name, std::string_view value);
 
         /**
          * Removes and returns the front element (the one added first) from the queue identified by the given name.
@@ -341,7 +487,24 @@ namespace db
          * \param name The name of the queue.
          * \return The string value removed from the front of the queue. If queue is empty, then exception is thrown.
          */
-        std::string pop(const std::string &name);
+        std::string pop(std::string_view name);
+
+        /**
+         * Removes and returns the front element of the queue, or registers the waiter behind all other waiters of the queue if it is empty.
+         *
+         * \param name The name of the queue.
+         * \param waiter The waiter completed by a later push. It is not registered if an element is returned.
+         * \return The string value removed from the front of the queue, or no value if the waiter was registered.
+         */
+        std::optional<std::string> pop_or_wait(std::string_view name, const std::shared_ptr<QueueWaiter> &waiter);
+
+        /**
+         * Unregisters a waiter which gave up waiting. Does nothing if the waiter or the queue no longer exists.
+         *
+         * \param name The name of the queue.
+         * \param waiter The waiter to be removed.
+         */
+        void cancel_wait(std::string_view name, const std::shared_ptr<QueueWaiter> &waiter);
 
         /**
          * Singleton access method returning a reference to the single instance of QueueRepository.
@@ -360,6 +523,7 @@ namespace db
      * \brief A class providing thread-safe storage and manipulation of hashes..
      *
      * The class offers methods for managing and modifying hashes identified by unique names. Each hash  stores key-value pairs of strings.
+     * Reads lock a hash shared and modifications exclusively, like in StringRepository.
      */
     class HashRepository
     {
@@ -368,7 +532,7 @@ namespace db
         friend class DataImporter;
 
     private:
-        tbb::concurrent_hash_map<std::string, tbb::concurrent_hash_map<std::string, std::string>> data_;
+        StringMap<StringMap<std::string>> data_;
 
     public:
         /**
@@ -376,7 +540,7 @@ namespace db
          *
          * \param name The name of the hash  to be created.
          */
-        void create(const std::string &name);
+        void create(std::string_view name);
 
         /**
          * Deletes a key-value pair from the hash  identified by the given name.
@@ -384,7 +548,7 @@ namespace db
          * \param name The name of the hash .
          * \param key The key of the key-value pair to be deleted.
          */
-        void del(const std::string &name, const std::string &key);
+        void del(std::string_view name, std::string_view key);
 
         /**
          * Checks if a specific key exists within the hash  identified by the given name.
@@ -393,7 +557,7 @@ namespace db
          * \param key The key to be searched for.
          * \return True if the key exists in the hash, false otherwise.
          */
-        bool exists(const std::string &name, const std::string &key);
+        bool exists(std::string_view name, std::string_view key);
 
         /**
          * Retrieves the value associated with a specific key from the hash identified by the given name.
@@ -403,23 +567,23 @@ namespace db
          * \param key The key of the key-value pair to be retrieved.
          * \return The value associated with the key.
          */
-        std::string get(const std::string &name, const std::string &key);
+        std::string get(std::string_view name, std::string_view key);
 
         /**
-         * Retrieves all key-value pairs from the hash identified by the given name.
+         * Visits all key-value pairs of the hash identified by the given name while the hash is locked, without copying them.
          *
-         * \param name The name of the hash .
-         * \return A vector containing all key-value pairs (std::pair<std::string, std::string>).
+         * \param name The name of the hash.
+         * \param visit Called for every key-value pair. It must not access the hash repository.
          */
-        std::vector<std::pair<std::string, std::string>> get_all(const std::string &name);
+        void get_all(std::string_view name, const PairVisitor &visit);
 
         /**
-         * Retrieves all keys from the hash  identified by the given name.
+         * Visits all keys of the hash identified by the given name while the hash is locked.
          *
          * \param name The name of the hash .
-         * \return A vector containing all unique keys (strings) present in the hash , or an empty vector if the hash  does not exist.
+         * \param visit Called for every key of the hash. It must not access the hash repository.
          */
-        std::vector<std::string> get_keys(const std::string &name);
+        void get_keys(std::string_view name, const ElementVisitor &visit);
 
         /**
          * Sets the value for a specific key in the hash  identified by the given name.
@@ -429,7 +593,7 @@ namespace db
          * \param key The key of the key-value pair
          * \param value The value to be associated with the key.
          */
-        void set(const std::string &name, const std::string &key, const std::string &value);
+        void set(std::string_view name, std::string_view key, std::string_view value);
 
         /**
          * Returns the number of key-value pairs in the hash  identified by the given name.
@@ -437,16 +601,17 @@ namespace db
          * \param name The name of the hash .
          * \return The number of key-value pairs (size) in the hash , or 0 if the hash  does not exist.
          */
-        uint len(const std::string &name);
+        uint len(std::string_view name);
 
         /**
          * Searches for key-value pairs where the key contains a specific query string.
          *
          * \param name The name of the hash .
          * \param query The query string to search for within values.
-         * \return A vector containing key-value pairs (std::pair<std::string, std::string>) where the key contains the query string.
+         * \param visit Called for every key containing the query string while the hash is locked. It must not access the hash
+         *              repository.
          */
-        std::vector<std::string> search(const std::string &name, const std::string &query);
+        void search(std::string_view name, std::string_view query, const ElementVisitor &visit);
 
         static HashRepository &get_instance()
         {
@@ -470,6 +635,9 @@ namespace db
         HashRepository &hash_repository_;
         KeysStorage &keys_storage_;
 
+        /** Held shared by every modification of the repositories and exclusively while a snapshot is taken. */
+        std::shared_mutex snapshot_mutex_;
+
         GlobalRepository(StringRepository &string_repository,
                          SetRepository &set_repository,
                          QueueRepository &queue_repository,
@@ -487,10 +655,9 @@ namespace db
          * It utilizes the KeysStorage to search for keys across different repositories based on a provided pattern (string).
          *
          * \param pattern The pattern (string) to be used for searching keys.
-         * \return A vector containing all matching keys (strings) found across different repositories.
-         *         Note: An empty vector might be returned if no matches are found.
+         * \param visit Called for every matching key found across different repositories, in ascending order.
          */
-        std::vector<std::string> keys(std::string &pattern);
+        void keys(std::string_view pattern, const ElementVisitor &visit);
 
         /**
          * Deletes a key from the global storage (if it exists).
@@ -499,7 +666,29 @@ namespace db
          *
          * \param key The key (string) to be deleted.
          */
-        void del(std::string &key);
+        void del(std::string_view key);
+
+        /**
+         * Deletes all keys, e.g. before a replica loads a new snapshot of its primary.
+         */
+        void clear();
+
+        /**
+         * Holds off snapshots while the caller modifies the repositories. Traversing a repository is not safe while keys are
+         * inserted or erased, and a snapshot must not miss half of a modification.
+         *
+         * The lock is taken after `ClusterState::lock_write()` and must not be taken again by the same thread.
+         *
+         * \return The lock, held shared.
+         */
+        std::shared_lock<std::shared_mutex> lock_write();
+
+        /**
+         * Waits for the modifications in progress and holds off new ones while the caller takes a snapshot.
+         *
+         * \return The lock, held exclusively.
+         */
+        std::unique_lock<std::shared_mutex> lock_snapshot();
 
         /**
          * Singleton access method returning a reference to the single instance of GlobalRepository.
@@ -522,32 +711,65 @@ namespace db
         /**
          * Saves data from all data repositories to a file specified by the `filename` parameter.
          *
+         * The data is serialized into large chunks which are written with the given IO backend. The caller holds
+         * `GlobalRepository::lock_snapshot()`, or runs in a child created by `fork_save()`.
+         *
          * \param filename The name of the file to save data to.
+         * \param backend The IO backend to write the file with.
          * \return True on success, False on failure (e.g., file opening error).
          */
-        static bool save(const std::string &filename);
+        static bool save(const std::string &filename, IoBackend backend = IoBackend::POSIX);
+
+        /**
+         * Saves data from all data repositories with the given writer. The caller holds `GlobalRepository::lock_snapshot()`,
+         * or runs in a child created by `fork_save()`.
+         *
+         * \param writer The writer of the snapshot.
+         * \return True on success, False on failure (e.g., write error).
+         */
+        static bool save(SnapshotWriter &writer);
+
+        /**
+         * Forks a child process which runs `save` on its copy of the keyspace and exits with its result. The pages of the
+         * keyspace are shared with the server copy-on-write, so only the fork holds `GlobalRepository::lock_snapshot()` and
+         * writes go on while the child saves.
+         *
+         * \param save Saves the snapshot in the child, e.g. with one of the `save()` overloads.
+         * \param forked Called in the server while the snapshot lock is still held, e.g. to note what the snapshot contains.
+         * \return The process identifier of the child, or -1 with `errno` set if it cannot be created.
+         */
+        static pid_t fork_save(const std::function<bool()> &save, const std::function<void()> &forked = {});
+
+        /**
+         * Waits until a child created by `fork_save()` exits. It blocks, so it must not run on a network thread.
+         *
+         * \param pid The process identifier of the child.
+         * \param abort Whether to kill the child first, e.g. because its snapshot is no longer needed.
+         * \return True if the child saved the snapshot.
+         */
+        static bool wait_save(pid_t pid, bool abort);
 
     private:
         /**
          * Saves string data from the `StringRepository` to the file stream.
          *
-         * \param file The file stream to save data to.
+         * \param file The snapshot stream to save data to.
          */
-        static void save_string_data(std::fstream &file);
+        static void save_string_data(SnapshotStream &file);
 
         /**
          * Saves set data from the `SetRepository` to the file stream.
          *
-         * \param file The file stream to save data to.
+         * \param file The snapshot stream to save data to.
          */
-        static void save_set_data(std::fstream &file);
+        static void save_set_data(SnapshotStream &file);
 
         /**
          * Saves hash data from the `HashRepository` to the file stream.
          *
-         * \param file The file stream to save data to.
+         * \param file The snapshot stream to save data to.
          */
-        static void save_hash_data(std::fstream &file);
+        static void save_hash_data(SnapshotStream &file);
     };
 
     /**
@@ -564,26 +786,34 @@ namespace db
          */
         static bool load(const std::string &filename);
 
+        /**
+         * Loads data from the given stream, which holds a snapshot in the format written by DataExporter.
+         *
+         * \param file The input stream to read data from.
+         * \return True on success, False on failure (e.g., invalid format).
+         */
+        static bool load(std::istream &file);
+
     private:
         /**
          * Loads string data from the file and inserts it into the `StringRepository`.
          *
-         * \param file The input file stream to read data from.
+         * \param file The input stream to read data from.
          */
-        static void load_string_data(std::ifstream &file);
+        static void load_string_data(std::istream &file);
 
         /**
          * Loads set data from the file and inserts it into the `SetRepository`.
          *
-         * \param file The input file stream to read data from.
+         * \param file The input stream to read data from.
          */
-        static void load_set_data(std::ifstream &file);
+        static void load_set_data(std::istream &file);
 
         /**
          * Loads hash data from the file and inserts it into the `HashRepository`.
          *
-         * \param file The input file stream to read data from.
+         * \param file The input stream to read data from.
          */
-        static void load_hash_data(std::ifstream &file);
+        static void load_hash_data(std::istream &file);
     };
 }
\ No newline at end of file
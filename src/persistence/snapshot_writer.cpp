@@ -0,0 +1,332 @@
+#include <snapshot_writer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef DB_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace db
+{
+    std::unique_ptr<SnapshotWriter> SnapshotWriter::open(const std::string &filename, IoBackend backend)
+    {
+        int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            return nullptr;
+        }
+
+        if (backend == IoBackend::IO_URING)
+        {
+#ifdef DB_HAS_IO_URING
+            if (auto writer = UringSnapshotWriter::create(fd))
+            {
+                return writer;
+            }
+#endif
+            static std::once_flag warned;
+            std::call_once(warned, []
+                           { std::cerr << "io_uring is not available, snapshots are written with write(2)" << std::endl; });
+        }
+        return std::make_unique<PosixSnapshotWriter>(fd);
+    }
+
+    PosixSnapshotWriter::PosixSnapshotWriter(int fd) : fd_{fd}, chunk_(CHUNK_SIZE)
+    {
+    }
+
+    PosixSnapshotWriter::~PosixSnapshotWriter()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    std::span<char> PosixSnapshotWriter::acquire()
+    {
+        if (failed_)
+        {
+            return {};
+        }
+        return {chunk_.data(), chunk_.size()};
+    }
+
+    void PosixSnapshotWriter::commit(std::size_t size)
+    {
+        const char *data = chunk_.data();
+        while (size > 0 && !failed_)
+        {
+            ssize_t written = ::write(fd_, data, size);
+            if (written < 0)
+            {
+                failed_ = errno != EINTR;
+                continue;
+            }
+            data += written;
+            size -= written;
+        }
+    }
+
+    bool PosixSnapshotWriter::finish()
+    {
+        failed_ = ::close(fd_) != 0 || failed_;
+        fd_ = -1;
+        return !failed_;
+    }
+
+#ifdef DB_HAS_IO_URING
+    UringSnapshotWriter::UringSnapshotWriter(int fd) : fd_{fd}, memory_(CHUNK_SIZE * CHUNK_COUNT), chunk_sizes_(CHUNK_COUNT)
+    {
+        for (unsigned int i = CHUNK_COUNT; i > 0; --i)
+        {
+            free_chunks_.push_back(i - 1);
+        }
+    }
+
+    UringSnapshotWriter::~UringSnapshotWriter()
+    {
+        if (sqes_)
+        {
+            munmap(sqes_, sqes_size_);
+        }
+        if (cq_ring_ && cq_ring_ != sq_ring_)
+        {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_)
+        {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        if (ring_fd_ >= 0)
+        {
+            ::close(ring_fd_);
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    std::unique_ptr<UringSnapshotWriter> UringSnapshotWriter::create(int fd)
+    {
+        std::unique_ptr<UringSnapshotWriter> writer{new UringSnapshotWriter(fd)};
+        if (!writer->setup())
+        {
+            // The caller keeps the file for the fallback writer.
+            writer->fd_ = -1;
+            return nullptr;
+        }
+        return writer;
+    }
+
+    bool UringSnapshotWriter::setup()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = syscall(__NR_io_uring_setup, CHUNK_COUNT, &params);
+        if (ring_fd_ < 0)
+        {
+            return false;
+        }
+
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+        }
+
+        sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        if (sq_ring_ == MAP_FAILED)
+        {
+            sq_ring_ = nullptr;
+            return false;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            cq_ring_ = sq_ring_;
+        }
+        else
+        {
+            cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+            if (cq_ring_ == MAP_FAILED)
+            {
+                cq_ring_ = nullptr;
+                return false;
+            }
+        }
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sqes_ == MAP_FAILED)
+        {
+            sqes_ = nullptr;
+            return false;
+        }
+
+        char *sq = static_cast<char *>(sq_ring_);
+        sq_head_ = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+        char *cq = static_cast<char *>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+        cqes_ = cq + params.cq_off.cqes;
+
+        iovec chunks[CHUNK_COUNT];
+        for (unsigned int i = 0; i < CHUNK_COUNT; ++i)
+        {
+            chunks[i].iov_base = memory_.data() + i * CHUNK_SIZE;
+            chunks[i].iov_len = CHUNK_SIZE;
+        }
+        return syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, chunks, CHUNK_COUNT) == 0;
+    }
+
+    std::span<char> UringSnapshotWriter::acquire()
+    {
+        while (free_chunks_.empty() && !failed_)
+        {
+            submit_and_wait(1);
+        }
+        if (failed_)
+        {
+            return {};
+        }
+        current_chunk_ = free_chunks_.back();
+        free_chunks_.pop_back();
+        return {memory_.data() + current_chunk_ * CHUNK_SIZE, CHUNK_SIZE};
+    }
+
+    void UringSnapshotWriter::commit(std::size_t size)
+    {
+        if (size == 0)
+        {
+            free_chunks_.push_back(current_chunk_);
+            return;
+        }
+
+        unsigned int tail = *sq_tail_;
+        unsigned int index = tail & sq_mask_;
+        io_uring_sqe *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = fd_;
+        sqe->addr = reinterpret_cast<std::uint64_t>(memory_.data() + current_chunk_ * CHUNK_SIZE);
+        sqe->len = size;
+        sqe->off = offset_;
+        sqe->buf_index = current_chunk_;
+        sqe->user_data = current_chunk_;
+        sq_array_[index] = index;
+        std::atomic_ref<unsigned int>(*sq_tail_).store(tail + 1, std::memory_order_release);
+
+        chunk_sizes_[current_chunk_] = size;
+        offset_ += size;
+        ++queued_;
+    }
+
+    void UringSnapshotWriter::submit_and_wait(unsigned int min_complete)
+    {
+        int submitted = syscall(__NR_io_uring_enter, ring_fd_, queued_, min_complete, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (submitted < 0)
+        {
+            failed_ = errno != EINTR;
+        }
+        else
+        {
+            queued_ -= submitted;
+            in_flight_ += submitted;
+        }
+        reap();
+    }
+
+    void UringSnapshotWriter::reap()
+    {
+        unsigned int head = *cq_head_;
+        unsigned int tail = std::atomic_ref<unsigned int>(*cq_tail_).load(std::memory_order_acquire);
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe &cqe = static_cast<io_uring_cqe *>(cqes_)[head & cq_mask_];
+            unsigned int chunk = cqe.user_data;
+            // Regular files are written completely unless the device fails or is full.
+            if (cqe.res < 0 || static_cast<std::size_t>(cqe.res) != chunk_sizes_[chunk])
+            {
+                failed_ = true;
+            }
+            free_chunks_.push_back(chunk);
+            --in_flight_;
+        }
+        std::atomic_ref<unsigned int>(*cq_head_).store(head, std::memory_order_release);
+    }
+
+    bool UringSnapshotWriter::finish()
+    {
+        while ((queued_ > 0 || in_flight_ > 0) && !failed_)
+        {
+            submit_and_wait(queued_ + in_flight_);
+        }
+        failed_ = ::close(fd_) != 0 || failed_;
+        fd_ = -1;
+        return !failed_;
+    }
+#endif
+
+    SnapshotStream::SnapshotStream(SnapshotWriter &writer) : writer_{writer}
+    {
+    }
+
+    void SnapshotStream::write(const char *data, std::size_t size)
+    {
+        while (size > 0)
+        {
+            if (chunk_.empty())
+            {
+                chunk_ = writer_.acquire();
+                if (chunk_.empty())
+                {
+                    // The writer failed, the snapshot is reported as failed by close().
+                    return;
+                }
+            }
+
+            std::size_t count = std::min(size, chunk_.size() - used_);
+            std::memcpy(chunk_.data() + used_, data, count);
+            used_ += count;
+            data += count;
+            size -= count;
+
+            if (used_ == chunk_.size())
+            {
+                writer_.commit(used_);
+                chunk_ = {};
+                used_ = 0;
+            }
+        }
+    }
+
+    void SnapshotStream::put(char c)
+    {
+        write(&c, 1);
+    }
+
+    bool SnapshotStream::close()
+    {
+        if (!chunk_.empty())
+        {
+            writer_.commit(used_);
+            chunk_ = {};
+            used_ = 0;
+        }
+        return writer_.finish();
+    }
+}
@@ -0,0 +1,195 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <utils.hpp>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define DB_HAS_IO_URING 1
+#endif
+
+namespace db
+{
+    /**
+     * \class SnapshotWriter
+     * \brief Writes a snapshot file in large chunks.
+     *
+     * The exporter serializes directly into chunks owned by the writer and hands every full chunk back, so the file is written
+     * with one request per chunk instead of one call per field.
+     */
+    class SnapshotWriter
+    {
+    public:
+        /** The size of a single chunk in bytes. */
+        static constexpr std::size_t CHUNK_SIZE = 1 << 20;
+
+        virtual ~SnapshotWriter() = default;
+
+        /**
+         * Returns a free chunk of `CHUNK_SIZE` bytes to serialize into. It may wait until an earlier write completes.
+         *
+         * \return The free chunk, or an empty span if an earlier write failed.
+         */
+        virtual std::span<char> acquire() = 0;
+
+        /**
+         * Queues the first `size` bytes of the last acquired chunk to be written after the previously committed chunks.
+         *
+         * \param size The number of bytes to be written.
+         */
+        virtual void commit(std::size_t size) = 0;
+
+        /**
+         * Waits until all committed chunks are written and closes the file.
+         *
+         * \return True if every chunk was written, false otherwise.
+         */
+        virtual bool finish() = 0;
+
+        /**
+         * Opens the snapshot file for writing with the given backend.
+         *
+         * Falls back to the POSIX backend if io_uring is not available on this system.
+         *
+         * \param filename The name of the file to write.
+         * \param backend The IO backend to write the file with.
+         * \return The writer, or nullptr if the file cannot be opened.
+         */
+        static std::unique_ptr<SnapshotWriter> open(const std::string &filename, IoBackend backend);
+    };
+
+    /**
+     * \class PosixSnapshotWriter
+     * \brief Writes every chunk with blocking `write(2)` calls.
+     */
+    class PosixSnapshotWriter : public SnapshotWriter
+    {
+    private:
+        int fd_;
+        std::vector<char> chunk_;
+        bool failed_ = false;
+
+    public:
+        explicit PosixSnapshotWriter(int fd);
+        ~PosixSnapshotWriter();
+
+        std::span<char> acquire() override;
+        void commit(std::size_t size) override;
+        bool finish() override;
+    };
+
+#ifdef DB_HAS_IO_URING
+    /**
+     * \class UringSnapshotWriter
+     * \brief Writes chunks through an io_uring submission queue.
+     *
+     * All chunks are registered with the ring once, so writes use `IORING_OP_WRITE_FIXED` and the kernel does not map the
+     * pages for every request. Committed chunks are only queued, they are submitted in one batch when the exporter needs a
+     * free chunk or finishes, so serializing the next chunk overlaps with writing the previous ones.
+     */
+    class UringSnapshotWriter : public SnapshotWriter
+    {
+    private:
+        /** The number of chunks, and so the maximum number of writes in flight. */
+        static constexpr unsigned int CHUNK_COUNT = 4;
+
+        int fd_;
+        int ring_fd_ = -1;
+
+        void *sq_ring_ = nullptr;
+        std::size_t sq_ring_size_ = 0;
+        void *cq_ring_ = nullptr;
+        std::size_t cq_ring_size_ = 0;
+        void *sqes_ = nullptr;
+        std::size_t sqes_size_ = 0;
+
+        unsigned int *sq_head_ = nullptr;
+        unsigned int *sq_tail_ = nullptr;
+        unsigned int sq_mask_ = 0;
+        unsigned int *sq_array_ = nullptr;
+        unsigned int *cq_head_ = nullptr;
+        unsigned int *cq_tail_ = nullptr;
+        unsigned int cq_mask_ = 0;
+        void *cqes_ = nullptr;
+
+        std::vector<char> memory_;
+        std::vector<unsigned int> free_chunks_;
+        std::vector<std::size_t> chunk_sizes_;
+        unsigned int current_chunk_ = 0;
+        unsigned int queued_ = 0;
+        unsigned int in_flight_ = 0;
+        std::size_t offset_ = 0;
+        bool failed_ = false;
+
+        UringSnapshotWriter(int fd);
+
+        /**
+         * Maps the rings of the io_uring instance and registers the chunks.
+         *
+         * \return True on success, false if io_uring is not usable, e.g. blocked by a seccomp policy.
+         */
+        bool setup();
+
+        /**
+         * Submits the queued writes and waits until at least `min_complete` writes complete.
+         */
+        void submit_and_wait(unsigned int min_complete);
+
+        /**
+         * Frees the chunks of all completed writes.
+         */
+        void reap();
+
+    public:
+        ~UringSnapshotWriter();
+
+        /**
+         * Creates a writer for the given file.
+         *
+         * \param fd The file to write, the writer takes its ownership.
+         * \return The writer, or nullptr if io_uring is not usable. The file is not closed in that case.
+         */
+        static std::unique_ptr<UringSnapshotWriter> create(int fd);
+
+        std::span<char> acquire() override;
+        void commit(std::size_t size) override;
+        bool finish() override;
+    };
+#endif
+
+    /**
+     * \class SnapshotStream
+     * \brief Serializes the snapshot into the chunks of a SnapshotWriter.
+     *
+     * Offers the `write` and `put` calls of `std::ostream` used by the exporter.
+     */
+    class SnapshotStream
+    {
+    private:
+        SnapshotWriter &writer_;
+        std::span<char> chunk_;
+        std::size_t used_ = 0;
+
+    public:
+        explicit SnapshotStream(SnapshotWriter &writer);
+
+        /**
+         * Appends the given bytes to the snapshot.
+         */
+        void write(const char *data, std::size_t size);
+
+        /**
+         * Appends a single byte to the snapshot.
+         */
+        void put(char c);
+
+        /**
+         * Commits the partially filled chunk and waits until the whole snapshot is written.
+         *
+         * \return True if the whole snapshot was written, false otherwise.
+         */
+        bool close();
+    };
+}
@@ -0,0 +1,197 @@
+#include <replica.hpp>
+#include <iostream>
+#include <sstream>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <repository.hpp>
+
+namespace db
+{
+    ReplicaClient::ReplicaClient(boost::asio::io_context &io_service, const std::string &primary,
+                                 boost::shared_ptr<ExecutionIoC<DefaultParser>> execution_ioc)
+        : io_service_{io_service},
+          execution_ioc_{execution_ioc},
+          primary_id_{"-"},
+          offset_{0},
+          failed_{false}
+    {
+        auto separator = primary.rfind(':');
+        if (separator == std::string::npos)
+        {
+            throw DatabaseException("replica_of must be host:port, got " + primary, "BAD_CONFIG");
+        }
+        host_ = primary.substr(0, separator);
+        port_ = primary.substr(separator + 1);
+    }
+
+    void ReplicaClient::start()
+    {
+        boost::asio::co_spawn(io_service_, [this]
+                              { return run(); },
+                              boost::asio::detached);
+    }
+
+    boost::asio::awaitable<void> ReplicaClient::run()
+    {
+        while (true)
+        {
+            std::string error;
+            boost::asio::ip::tcp::socket socket{io_service_};
+            try
+            {
+                boost::asio::ip::tcp::resolver resolver{io_service_};
+                auto endpoints = co_await resolver.async_resolve(host_, port_, boost::asio::use_awaitable);
+                co_await boost::asio::async_connect(socket, endpoints, boost::asio::use_awaitable);
+                co_await replicate(socket);
+            }
+            catch (const boost::system::system_error &e)
+            {
+                error = e.what();
+            }
+            catch (const DatabaseException &e)
+            {
+                error = e.get_message();
+            }
+
+            if (!this->failed_)
+            {
+                std::cerr << "Replication of " << this->host_ << ":" << this->port_ << " interrupted: " << error << std::endl;
+                this->failed_ = true;
+            }
+            boost::asio::steady_timer timer{io_service_, std::chrono::seconds(1)};
+            co_await timer.async_wait(boost::asio::use_awaitable);
+        }
+    }
+
+    boost::asio::awaitable<void> ReplicaClient::replicate(boost::asio::ip::tcp::socket &socket)
+    {
+        std::string request(1, static_cast<char>(protocol::MAGIC));
+        std::string offset = std::to_string(this->offset_);
+        protocol::encode_frame(request, protocol::Opcode::COMMAND, {"REPLSYNC", this->primary_id_, offset});
+        co_await boost::asio::async_write(socket, boost::asio::buffer(request), boost::asio::use_awaitable);
+
+        boost::asio::streambuf buffer;
+        protocol::FrameHeader header = co_await read_frame(socket, buffer);
+        auto arguments = protocol::decode_arguments(header, boost::asio::buffer_cast<const char *>(buffer.data()) + protocol::HEADER_SIZE);
+        if (header.opcode == protocol::Opcode::REPLY_ERROR && arguments.size() == 2)
+        {
+            throw DatabaseException(std::string{arguments[0]}, std::string{arguments[1]});
+        }
+        if (header.opcode != protocol::Opcode::REPLY_OK || arguments.size() != 1)
+        {
+            throw DatabaseException("Unexpected reply to REPLSYNC", "BAD_FRAME");
+        }
+
+        // `FULL <id>` followed by the snapshot, or `CONTINUE <id> <offset>`.
+        std::vector<std::string> tokens;
+        boost::split(tokens, arguments[0], boost::is_any_of(" "));
+        buffer.consume(protocol::HEADER_SIZE + header.length);
+        if (tokens.size() == 2 && tokens[0] == "FULL")
+        {
+            // The snapshot is only loaded once the primary confirmed it is complete.
+            std::string snapshot = co_await read_snapshot(socket, buffer);
+            tokens.push_back(co_await read_snapshot_offset(socket, buffer));
+            load_snapshot(std::move(snapshot));
+        }
+        if (tokens.size() != 3 || (tokens[0] != "FULL" && tokens[0] != "CONTINUE"))
+        {
+            throw DatabaseException("Unexpected reply to REPLSYNC", "BAD_FRAME");
+        }
+        this->primary_id_ = tokens[1];
+        this->offset_ = boost::lexical_cast<std::uint64_t>(tokens[2]);
+
+        std::cout << (tokens[0] == "FULL" ? "Loaded a snapshot of " : "Continuing replication of ") << this->host_ << ":"
+                  << this->port_ << " at offset " << this->offset_ << std::endl;
+        this->failed_ = false;
+
+        while (true)
+        {
+            header = co_await read_frame(socket, buffer);
+            if (header.opcode != protocol::Opcode::COMMAND)
+            {
+                throw DatabaseException("Unexpected frame in the replication log", "BAD_FRAME");
+            }
+            apply(protocol::decode_arguments(header, boost::asio::buffer_cast<const char *>(buffer.data()) + protocol::HEADER_SIZE));
+            buffer.consume(protocol::HEADER_SIZE + header.length);
+            ++this->offset_;
+        }
+    }
+
+    boost::asio::awaitable<std::string> ReplicaClient::read_snapshot(boost::asio::ip::tcp::socket &socket, boost::asio::streambuf &buffer)
+    {
+        std::string snapshot;
+        while (true)
+        {
+            protocol::FrameHeader header = co_await read_frame(socket, buffer);
+            if (header.opcode != protocol::Opcode::SNAPSHOT)
+            {
+                co_return snapshot;
+            }
+            auto arguments = protocol::decode_arguments(header, boost::asio::buffer_cast<const char *>(buffer.data()) + protocol::HEADER_SIZE);
+            if (arguments.size() != 1)
+            {
+                throw DatabaseException("Unexpected frame in the snapshot", "BAD_FRAME");
+            }
+            snapshot.append(arguments[0]);
+            buffer.consume(protocol::HEADER_SIZE + header.length);
+        }
+    }
+
+    boost::asio::awaitable<std::string> ReplicaClient::read_snapshot_offset(boost::asio::ip::tcp::socket &socket, boost::asio::streambuf &buffer)
+    {
+        protocol::FrameHeader header = co_await read_frame(socket, buffer);
+        auto arguments = protocol::decode_arguments(header, boost::asio::buffer_cast<const char *>(buffer.data()) + protocol::HEADER_SIZE);
+        if (header.opcode == protocol::Opcode::REPLY_ERROR && arguments.size() == 2)
+        {
+            throw DatabaseException(std::string{arguments[0]}, std::string{arguments[1]});
+        }
+        if (header.opcode != protocol::Opcode::REPLY_OK || arguments.size() != 1)
+        {
+            throw DatabaseException("Unexpected frame after the snapshot", "BAD_FRAME");
+        }
+        std::string offset{arguments[0]};
+        buffer.consume(protocol::HEADER_SIZE + header.length);
+        co_return offset;
+    }
+
+    boost::asio::awaitable<protocol::FrameHeader> ReplicaClient::read_frame(boost::asio::ip::tcp::socket &socket, boost::asio::streambuf &buffer)
+    {
+        if (buffer.size() < protocol::HEADER_SIZE)
+        {
+            co_await boost::asio::async_read(socket, buffer, boost::asio::transfer_at_least(protocol::HEADER_SIZE - buffer.size()),
+                                             boost::asio::use_awaitable);
+        }
+        protocol::FrameHeader header = protocol::decode_header(boost::asio::buffer_cast<const char *>(buffer.data()));
+        if (buffer.size() < protocol::HEADER_SIZE + header.length)
+        {
+            co_await boost::asio::async_read(socket, buffer, boost::asio::transfer_at_least(protocol::HEADER_SIZE + header.length - buffer.size()),
+                                             boost::asio::use_awaitable);
+        }
+        co_return header;
+    }
+
+    void ReplicaClient::load_snapshot(std::string snapshot)
+    {
+        auto write = GlobalRepository::get_instance().lock_write();
+        GlobalRepository::get_instance().clear();
+        std::istringstream input{std::move(snapshot)};
+        if (!DataImporter::load(input))
+        {
+            throw DatabaseException("Invalid snapshot", "REPL_SNAPSHOT");
+        }
+    }
+
+    void ReplicaClient::apply(std::vector<std::string_view> arguments)
+    {
+        try
+        {
+            auto write = GlobalRepository::get_instance().lock_write();
+            this->execution_ioc_->getParser().extract_command(arguments)->execute();
+        }
+        catch (const std::exception &)
+        {
+            // Entries are recorded only if they succeeded on the primary. They still fail here for keys the replica does
+            // not hold, e.g. a deleted queue, as queues are not replicated.
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/shared_ptr.hpp>
+#include <parser.hpp>
+#include <execution_ioc.hpp>
+#include <protocol.hpp>
+
+namespace db
+{
+    /**
+     * @brief Keeps a replica in sync with its primary.
+     *
+     * The client connects to the primary with the binary protocol and sends `REPLSYNC` with the offset it has applied so
+     * far. The primary either continues from that offset or sends a snapshot in chunks first, then it streams every mutation as a
+     * `COMMAND` frame. The client applies the frames in the order they arrive. When the connection breaks the client
+     * reconnects and continues from its offset, so a short outage does not require a new snapshot.
+     */
+    class ReplicaClient
+    {
+    private:
+        /** The IO service the client runs on. */
+        boost::asio::io_context &io_service_;
+
+        /** The host of the primary. */
+        std::string host_;
+
+        /** The port of the primary. */
+        std::string port_;
+
+        /** The execution IO context whose parser builds the replicated commands. */
+        boost::shared_ptr<ExecutionIoC<DefaultParser>> execution_ioc_;
+
+        /** The identifier of the primary run the replica replicates, `-` before the first snapshot. */
+        std::string primary_id_;
+
+        /** The offset of the first entry of the replication log not applied yet. */
+        std::uint64_t offset_;
+
+        /** Whether the last attempt to replicate failed, so repeated failures are reported only once. */
+        bool failed_;
+
+    public:
+        /**
+         * @brief Constructs a ReplicaClient object.
+         *
+         * @param io_service The IO service the client runs on.
+         * @param primary The `host:port` of the primary.
+         * @param execution_ioc The execution IO context whose parser builds the replicated commands.
+         */
+        ReplicaClient(boost::asio::io_context &io_service, const std::string &primary,
+                      boost::shared_ptr<ExecutionIoC<DefaultParser>> execution_ioc);
+
+        /**
+         * @brief Starts replicating. The client must outlive the IO service.
+         */
+        void start();
+
+    private:
+        /**
+         * @brief Replicates the primary, reconnecting whenever the connection breaks.
+         */
+        boost::asio::awaitable<void> run();
+
+        /**
+         * @brief Synchronizes with the primary and applies the replication log until the connection breaks.
+         *
+         * @param socket The socket connected to the primary.
+         */
+        boost::asio::awaitable<void> replicate(boost::asio::ip::tcp::socket &socket);
+
+        /**
+         * @brief Reads the next frame.
+         *
+         * @param socket The socket connected to the primary.
+         * @param buffer The buffer holding the received bytes, the frame is at its front when the operation completes.
+         * @return The header of the frame.
+         */
+        boost::asio::awaitable<protocol::FrameHeader> read_frame(boost::asio::ip::tcp::socket &socket, boost::asio::streambuf &buffer);
+
+        /**
+         * @brief Reads the `SNAPSHOT` frames following a `FULL` reply.
+         *
+         * @param socket The socket connected to the primary.
+         * @param buffer The buffer holding the received bytes, the frame closing the snapshot is at its front afterwards.
+         * @return The snapshot in the format written by DataExporter.
+         */
+        boost::asio::awaitable<std::string> read_snapshot(boost::asio::ip::tcp::socket &socket, boost::asio::streambuf &buffer);
+
+        /**
+         * @brief Reads the reply closing a snapshot.
+         *
+         * @param socket The socket connected to the primary.
+         * @param buffer The buffer holding the received bytes.
+         * @return The offset the snapshot was taken at.
+         * @throws DatabaseException with the code sent by the primary if the snapshot failed.
+         */
+        boost::asio::awaitable<std::string> read_snapshot_offset(boost::asio::ip::tcp::socket &socket, boost::asio::streambuf &buffer);
+
+        /**
+         * @brief Replaces the whole keyspace with a snapshot of the primary.
+         *
+         * @param snapshot The snapshot in the format written by DataExporter.
+         */
+        void load_snapshot(std::string snapshot);
+
+        /**
+         * @brief Applies a single entry of the replication log.
+         *
+         * @param arguments The tokens of the replicated command.
+         */
+        void apply(std::vector<std::string_view> arguments);
+    };
+}
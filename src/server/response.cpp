@@ -0,0 +1,93 @@
+#include <response.hpp>
+
+namespace db
+{
+    void ResponseBuilder::append_static(std::string_view literal)
+    {
+        if (literal.size() <= INLINE_LIMIT)
+        {
+            append_copy(literal);
+            return;
+        }
+        segments_.push_back(Segment{Segment::Source::STATIC, literal.data(), 0, literal.size()});
+    }
+
+    void ResponseBuilder::append_copy(std::string_view bytes)
+    {
+        storage_.append(bytes);
+        commit_storage();
+    }
+
+    std::string &ResponseBuilder::storage()
+    {
+        return storage_;
+    }
+
+    void ResponseBuilder::commit_storage()
+    {
+        if (storage_.size() > committed_storage_)
+        {
+            if (!segments_.empty() && segments_.back().source == Segment::Source::STORAGE)
+            {
+                segments_.back().size += storage_.size() - committed_storage_;
+            }
+            else
+            {
+                segments_.push_back(Segment{Segment::Source::STORAGE, nullptr, committed_storage_, storage_.size() - committed_storage_});
+            }
+            committed_storage_ = storage_.size();
+        }
+    }
+
+    void ResponseBuilder::append_payload(std::string &&payload)
+    {
+        if (payload.size() <= INLINE_LIMIT)
+        {
+            append_copy(payload);
+            return;
+        }
+        payloads_.push_back(std::move(payload));
+        segments_.push_back(Segment{Segment::Source::PAYLOAD, nullptr, payloads_.size() - 1, payloads_.back().size()});
+    }
+
+    const std::vector<boost::asio::const_buffer> &ResponseBuilder::buffers()
+    {
+        // Storage and payloads may reallocate while the reply is built, so addresses are resolved only now.
+        buffers_.clear();
+        for (auto &&segment : segments_)
+        {
+            switch (segment.source)
+            {
+            case Segment::Source::STATIC:
+                buffers_.emplace_back(segment.data, segment.size);
+                break;
+            case Segment::Source::STORAGE:
+                buffers_.emplace_back(storage_.data() + segment.position, segment.size);
+                break;
+            case Segment::Source::PAYLOAD:
+                buffers_.emplace_back(payloads_[segment.position].data(), segment.size);
+                break;
+            }
+        }
+        return buffers_;
+    }
+
+    std::size_t ResponseBuilder::size() const
+    {
+        std::size_t size = 0;
+        for (auto &&segment : segments_)
+        {
+            size += segment.size;
+        }
+        return size;
+    }
+
+    void ResponseBuilder::clear()
+    {
+        segments_.clear();
+        storage_.clear();
+        committed_storage_ = 0;
+        payloads_.clear();
+        buffers_.clear();
+    }
+}
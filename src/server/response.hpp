@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/asio/buffer.hpp>
+
+namespace db
+{
+    /**
+     * @brief Builds a reply as a sequence of buffers that can be handed to a single gather write.
+     *
+     * A reply is made of segments: bytes copied into a reused storage, and large strings that are referenced or moved in
+     * instead. Everything up to `INLINE_LIMIT` bytes, e.g. the envelope, error codes, frame headers and short payloads, is
+     * copied, so adjacent small pieces form a single buffer. Asio gathers at most 16 buffers per `writev`, this keeps a
+     * pipelined reply to a few system calls. The builder is owned by a connection and cleared after every reply, so its
+     * containers keep their capacity and a reply usually costs no heap allocation besides the payload produced by the
+     * command itself.
+     */
+    class ResponseBuilder
+    {
+    public:
+        /** The size up to which appended strings are copied into the storage instead of getting a buffer of their own. */
+        static constexpr std::size_t INLINE_LIMIT = 1024;
+
+    private:
+        /**
+         * @brief A part of the reply.
+         */
+        struct Segment
+        {
+            /** Where the bytes of the segment live. */
+            enum class Source
+            {
+                STATIC,
+                STORAGE,
+                PAYLOAD
+            };
+
+            Source source;
+
+            /** The data of a static segment, unused otherwise. */
+            const char *data;
+
+            /** The offset into the storage, or the index of the payload. */
+            std::size_t position;
+
+            std::size_t size;
+        };
+
+        /** The segments of the reply, in order. */
+        std::vector<Segment> segments_;
+
+        /** The storage for copied segments. */
+        std::string storage_;
+
+        /** The number of bytes of `storage_` already covered by segments. */
+        std::size_t committed_storage_ = 0;
+
+        /** The payloads moved into the reply. */
+        std::vector<std::string> payloads_;
+
+        /** The buffer sequence handed out by `buffers()`. */
+        std::vector<boost::asio::const_buffer> buffers_;
+
+    public:
+        /**
+         * Appends a string which is referenced, not copied, unless it is at most `INLINE_LIMIT` bytes long. The string must
+         * outlive the write of the reply.
+         *
+         * @param literal The string to be referenced by the reply.
+         */
+        void append_static(std::string_view literal);
+
+        /**
+         * Appends a copy of the given bytes.
+         *
+         * @param bytes The bytes to be copied into the reply.
+         */
+        void append_copy(std::string_view bytes);
+
+        /**
+         * Returns the storage for copied segments, so encoders can write into it directly. Bytes appended to it must be
+         * followed by a call to `commit_storage()`.
+         *
+         * @return The storage for copied segments.
+         */
+        std::string &storage();
+
+        /**
+         * Adds the bytes appended to `storage()` since the last segment to the reply, extending the last segment if it is a
+         * part of the storage as well.
+         */
+        void commit_storage();
+
+        /**
+         * Appends a payload produced by a command. The payload is moved, not copied, unless it is at most `INLINE_LIMIT`
+         * bytes long.
+         *
+         * @param payload The payload to be sent.
+         */
+        void append_payload(std::string &&payload);
+
+        /**
+         * Returns the reply as a buffer sequence. The sequence stays valid until the builder is modified or cleared.
+         *
+         * @return The buffers to be written, in order.
+         */
+        const std::vector<boost::asio::const_buffer> &buffers();
+
+        /**
+         * Returns the total size of the reply in bytes.
+         */
+        std::size_t size() const;
+
+        /**
+         * Removes all segments, keeping the allocated capacity for the next reply.
+         */
+        void clear();
+    };
+}
@@ -2,132 +2,1363 @@
 #include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <vector>
+#include <algorithm>
 #include <command.hpp>
-#include <boost/algorithm/string/trim.hpp>
-#include <boost/algorithm/string/find.hpp>
 #include <repository.hpp>
+#include <metrics.hpp>
+#include <arena.hpp>
 #include <boost/lexical_cast.hpp>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/syscall.h>
 
 namespace db
 {
-    DefaultReadWithResponseConnection::DefaultReadWithResponseConnection(boost::asio::io_service &io_service,
-                                                                         boost::shared_ptr<DefaultExecutionIoC> execution_ioc)
+    /**
+     * Runs the given function and maps its result or the exception it throws to a Reply.
+     */
+    template <typename Function>
+    Reply execute_guarded(Function &&function)
+    {
+        try
+        {
+            return Reply{true, function(), ""};
+        }
+        catch (const DatabaseException &e)
+        {
+            return Reply{false, e.get_message(), e.get_code()};
+        }
+        catch (const boost::bad_lexical_cast &e)
+        {
+            return Reply{false, e.what(), "BAD_CAST"};
+        }
+        catch (...)
+        {
+            return Reply{false, "Unknown error", "UNKNOWN"};
+        }
+    }
+
+    /**
+     * Stands in for a command the server refuses to execute, so the refusal is replied in the order of the commands.
+     */
+    class RejectedCommand : public Command
+    {
+    private:
+        DatabaseException error_;
+
+    public:
+        explicit RejectedCommand(DatabaseException error) : error_{std::move(error)} {}
+
+        std::string execute() override
+        {
+            throw error_;
+        }
+    };
+
+    /**
+     * Appends a reply triple in the text protocol format `[status][payload][code]`.
+     */
+    void append_text_reply(ResponseBuilder &response, Reply &&reply)
+    {
+        response.append_static(reply.success ? "[1][" : "[0][");
+        response.append_payload(std::move(reply.payload));
+        response.append_static("][");
+        response.append_copy(reply.code);
+        response.append_static("]");
+    }
+
+    /**
+     * Appends a reply as a binary protocol frame.
+     */
+    void append_frame_reply(ResponseBuilder &response, Reply &&reply)
+    {
+        protocol::FrameHeader header;
+        header.opcode = reply.success ? protocol::Opcode::REPLY_OK : protocol::Opcode::REPLY_ERROR;
+        header.argc = reply.success ? 1 : 2;
+        header.length = protocol::ARGUMENT_PREFIX_SIZE + reply.payload.size();
+        if (!reply.success)
+        {
+            header.length += protocol::ARGUMENT_PREFIX_SIZE + reply.code.size();
+        }
+
+        protocol::encode_header(response.storage(), header);
+        protocol::encode_argument_size(response.storage(), reply.payload.size());
+        response.commit_storage();
+        response.append_payload(std::move(reply.payload));
+        if (!reply.success)
+        {
+            protocol::encode_argument(response.storage(), reply.code);
+            response.commit_storage();
+        }
+    }
+
+    /**
+     * Appends a published message, as a `[M][channel][payload]` line in the text protocol or a `MESSAGE` frame.
+     *
+     * The bytes of the message are referenced, not copied, so the message must outlive the write.
+     */
+    void append_message(ResponseBuilder &response, WireProtocol protocol, const Message &message)
+    {
+        if (protocol == WireProtocol::BINARY)
+        {
+            protocol::FrameHeader header;
+            header.opcode = protocol::Opcode::MESSAGE;
+            header.argc = 2;
+            header.length = 2 * protocol::ARGUMENT_PREFIX_SIZE + message.channel.size() + message.payload.size();
+
+            protocol::encode_header(response.storage(), header);
+            protocol::encode_argument(response.storage(), message.channel);
+            protocol::encode_argument_size(response.storage(), message.payload.size());
+            response.commit_storage();
+            response.append_static(message.payload);
+            return;
+        }
+
+        response.append_static("[M][");
+        response.append_static(message.channel);
+        response.append_static("][");
+        response.append_static(message.payload);
+        response.append_static("]\n");
+    }
+
+    /**
+     * Executes the commands on the given lane of the command executor and completes with their replies on the given strand.
+     *
+     * The commands run on a TBB thread, the coroutine awaiting the operation is suspended meanwhile and does not hold any
+     * network thread.
+     */
+    template <typename CompletionToken>
+    auto async_execute(CommandExecutor &executor, ExecutionLane lane, std::vector<boost::shared_ptr<Command>> commands,
+                       ConnectionStrand strand, CompletionToken &&token)
+    {
+        auto initiation = [&executor, lane, strand](auto handler, std::vector<boost::shared_ptr<Command>> commands)
+        {
+            using Handler = decltype(handler);
+            struct PendingExecution
+            {
+                Handler completion;
+                boost::asio::executor_work_guard<ConnectionStrand> work;
+            };
+            auto pending = std::make_shared<PendingExecution>(PendingExecution{std::move(handler), boost::asio::make_work_guard(strand)});
+
+            executor.submit(lane, [pending, strand, commands = std::move(commands)]
+                            {
+                                // Every command is executed and gets its own reply, even if an earlier command failed.
+                                std::vector<Reply> replies;
+                                replies.reserve(commands.size());
+                                auto &metrics = Metrics::get_instance();
+                                auto &cluster = ClusterState::get_instance();
+                                auto &repository = GlobalRepository::get_instance();
+                                auto start = std::chrono::steady_clock::now();
+                                for (auto &&command : commands)
+                                {
+                                    replies.push_back(execute_guarded([&]
+                                                                      {
+                                                                          // A write holds off the migration of its keys and snapshots until it is applied.
+                                                                          // MIGRATE takes both locks itself for every key it moves.
+                                                                          std::shared_lock<std::shared_mutex> migration;
+                                                                          std::shared_lock<std::shared_mutex> write;
+                                                                          if (!command->is_read_only() && command->type() != CommandType::MIGRATE)
+                                                                          {
+                                                                              migration = cluster.lock_write(command->keys());
+                                                                              write = repository.lock_write();
+                                                                          }
+                                                                          // The command writes straight into the payload of its reply.
+                                                                          std::string payload;
+                                                                          StringSink sink{payload};
+                                                                          command->execute_into(sink);
+                                                                          return payload; }));
+                                    auto end = std::chrono::steady_clock::now();
+                                    metrics.record(static_cast<std::size_t>(command->type()), Phase::EXECUTE, end - start);
+                                    start = end;
+                                }
+                                boost::asio::post(strand, [pending, replies = std::move(replies)]() mutable
+                                                  { pending->completion(std::move(replies)); }); });
+        };
+        return boost::asio::async_initiate<CompletionToken, void(std::vector<Reply>)>(initiation, token, std::move(commands));
+    }
+
+    /**
+     * Runs a task on the given lane of the command executor and completes on the given strand once it returned.
+     *
+     * The task may refer to the frame of the coroutine awaiting the operation, which stays suspended until then.
+     */
+    template <typename CompletionToken>
+    auto async_submit(CommandExecutor &executor, ExecutionLane lane, std::function<void()> task, ConnectionStrand strand, CompletionToken &&token)
+    {
+        auto initiation = [&executor, lane, strand](auto handler, std::function<void()> task)
+        {
+            using Handler = decltype(handler);
+            struct PendingTask
+            {
+                Handler completion;
+                boost::asio::executor_work_guard<ConnectionStrand> work;
+            };
+            auto pending = std::make_shared<PendingTask>(PendingTask{std::move(handler), boost::asio::make_work_guard(strand)});
+
+            executor.submit(lane, [pending, strand, task = std::move(task)]
+                            {
+                                task();
+                                boost::asio::post(strand, [pending]
+                                                  { pending->completion(); }); });
+        };
+        return boost::asio::async_initiate<CompletionToken, void()>(initiation, token, std::move(task));
+    }
+
+    ConnectionLimits::ConnectionLimits(const Config &config)
+    {
+        if (config.get_max_request_bytes() > 0)
+        {
+            // A frame header must always fit, otherwise no request could ever be read.
+            max_request_bytes = std::max<std::size_t>(config.get_max_request_bytes(), protocol::HEADER_SIZE);
+        }
+        if (config.get_max_commands_per_request() > 0)
+        {
+            max_commands = config.get_max_commands_per_request();
+        }
+        idle_timeout = std::chrono::seconds(std::max(0, config.get_idle_timeout()));
+        read_timeout = std::chrono::seconds(std::max(0, config.get_read_timeout()));
+        write_timeout = std::chrono::seconds(std::max(0, config.get_write_timeout()));
+        if (config.get_max_pending_messages() > 0)
+        {
+            max_pending_messages = config.get_max_pending_messages();
+        }
+        read_only = !config.get_replica_of().empty();
+    }
+
+    std::chrono::seconds ConnectionLimits::shortest_timeout() const
+    {
+        std::chrono::seconds shortest{0};
+        for (auto timeout : {idle_timeout, read_timeout, write_timeout})
+        {
+            if (timeout.count() > 0 && (shortest.count() == 0 || timeout < shortest))
+            {
+                shortest = timeout;
+            }
+        }
+        return shortest;
+    }
+
+    AdmissionControl::AdmissionControl(int max_connections) : max_connections_{max_connections}
+    {
+    }
+
+    bool AdmissionControl::try_admit()
+    {
+        int active = active_.fetch_add(1, std::memory_order_relaxed);
+        if (max_connections_ > 0 && active >= max_connections_)
+        {
+            active_.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void AdmissionControl::release()
+    {
+        active_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    Mailbox::Mailbox(std::size_t capacity, std::function<void()> wake, std::function<void()> overflow)
+        : capacity_{capacity},
+          wake_{std::move(wake)},
+          overflow_{std::move(overflow)}
+    {
+    }
+
+    bool Mailbox::deliver(const std::shared_ptr<const Message> &message)
+    {
+        bool wake = false;
+        bool overflow = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (overflowed_)
+            {
+                return false;
+            }
+            if (messages_.size() >= capacity_)
+            {
+                overflowed_ = overflow = true;
+                messages_.clear();
+            }
+            else
+            {
+                messages_.push_back(message);
+                wake = !wake_pending_;
+                wake_pending_ = true;
+            }
+        }
+
+        // The callbacks only post to the strand of the connection, they are called without the lock anyway.
+        if (overflow)
+        {
+            overflow_();
+            return false;
+        }
+        if (wake)
+        {
+            wake_();
+        }
+        return true;
+    }
+
+    bool Mailbox::take(std::vector<std::shared_ptr<const Message>> &messages)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        messages.swap(messages_);
+        wake_pending_ = !messages.empty();
+        return wake_pending_;
+    }
+
+    /**
+     * Starts an asynchronous command on the fast lane of the command executor and completes with its reply on the given
+     * strand.
+     *
+     * Starting the command may wait for the locks of its keys, so it does not run on the strand. The command may be
+     * completed from any thread.
+     */
+    template <typename CompletionToken>
+    auto async_complete(CommandExecutor &executor, boost::shared_ptr<AsyncCommand> command, ConnectionStrand strand, CompletionToken &&token)
+    {
+        auto initiation = [&executor, strand](auto handler, boost::shared_ptr<AsyncCommand> command)
+        {
+            using Handler = decltype(handler);
+            struct PendingCompletion
+            {
+                Handler completion;
+                boost::asio::executor_work_guard<ConnectionStrand> work;
+            };
+            auto pending = std::make_shared<PendingCompletion>(PendingCompletion{std::move(handler), boost::asio::make_work_guard(strand)});
+
+            CommandCompletion completion = [pending, strand](std::string result, std::exception_ptr error)
+            {
+                Reply reply = execute_guarded([&]
+                                              {
+                                                  if (error)
+                                                  {
+                                                      std::rethrow_exception(error);
+                                                  }
+                                                  return std::move(result); });
+                boost::asio::post(strand, [pending, reply = std::move(reply)]() mutable
+                                  { pending->completion(std::move(reply)); });
+            };
+            executor.submit(ExecutionLane::FAST, [command, completion = std::move(completion)]
+                            { command->execute_async(completion); });
+        };
+        return boost::asio::async_initiate<CompletionToken, void(Reply)>(initiation, token, std::move(command));
+    }
+
+    template <typename Protocol>
+    BasicReadWithResponseConnection<Protocol>::BasicReadWithResponseConnection(boost::asio::io_service &io_service,
+                                                                               boost::shared_ptr<DefaultExecutionIoC> execution_ioc,
+                                                                               const ConnectionLimits &limits,
+                                                                               AdmissionControl &admission,
+                                                                               TimerWheel &wheel)
         : socket_{io_service},
-          buffer_{},
-          execution_ioc_{execution_ioc}
+          strand_{boost::asio::make_strand(io_service)},
+          buffer_{limits.max_request_bytes},
+          execution_ioc_{execution_ioc},
+          protocol_{WireProtocol::TEXT},
+          limits_{limits},
+          admission_{admission},
+          admitted_{false},
+          wheel_{wheel},
+          closed_by_server_{false},
+          reading_request_{false},
+          writing_{false},
+          write_turn_{strand_},
+          follow_snapshot_{false},
+          log_ready_{false},
+          log_wait_{strand_},
+          asking_{false}
     {
+        write_turn_.expires_at(boost::asio::steady_timer::time_point::max());
+        log_wait_.expires_at(boost::asio::steady_timer::time_point::max());
     }
 
-    DefaultReadWithResponseConnection::~DefaultReadWithResponseConnection()
+    template <typename Protocol>
+    BasicReadWithResponseConnection<Protocol>::~BasicReadWithResponseConnection()
     {
+        if (admitted_)
+        {
+            admission_.release();
+        }
     }
 
-    void DefaultReadWithResponseConnection::perform_connection()
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::perform_connection()
     {
-        boost::asio::async_read_until(socket_, buffer_, boost::asio::string_view{"|"},
-                                      boost::bind(&DefaultReadWithResponseConnection::handle_read_finished,
-                                                  shared_from_this(),
-                                                  boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+        // The coroutine owns the only reference to the connection for as long as the connection is served.
+        boost::asio::co_spawn(strand_, [self = this->shared_from_this()]
+                              { return self->serve(); },
+                              boost::asio::detached);
     }
 
-    boost::asio::ip::tcp::socket &DefaultReadWithResponseConnection::get_socket()
+    template <typename Protocol>
+    typename Protocol::socket &BasicReadWithResponseConnection<Protocol>::get_socket()
     {
         return socket_;
     }
 
-    void DefaultReadWithResponseConnection::handle_read_finished(const boost::system::error_code ec, std::size_t bytes_transferred)
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::expire()
     {
-        if (!ec)
+        boost::asio::post(strand_, [self = this->shared_from_this()]
+                          {
+                              // The connection may have finished the timed phase after the wheel saw the deadline.
+                              if (self->expired())
+                              {
+                                  self->closed_by_server_ = true;
+                                  boost::system::error_code ignored;
+                                  self->socket_.close(ignored);
+                              } });
+    }
+
+    template <typename Protocol>
+    std::size_t BasicReadWithResponseConnection<Protocol>::subscribe(const std::string &channel)
+    {
+        if (!this->mailbox_)
+        {
+            // The mailbox outlives neither the connection nor its strand, it only posts to them.
+            boost::weak_ptr<BasicReadWithResponseConnection> weak_self = this->shared_from_this();
+            ConnectionStrand strand = this->strand_;
+            auto wake = [weak_self, strand]
+            {
+                boost::asio::post(strand, [weak_self]
+                                  {
+                                      if (auto self = weak_self.lock())
+                                      {
+                                          boost::asio::co_spawn(self->strand_, [self]
+                                                                { return self->push_messages(); },
+                                                                boost::asio::detached);
+                                      } });
+            };
+            auto overflow = [weak_self, strand]
+            {
+                boost::asio::post(strand, [weak_self]
+                                  {
+                                      if (auto self = weak_self.lock())
+                                      {
+                                          self->closed_by_server_ = true;
+                                          boost::system::error_code ignored;
+                                          self->socket_.close(ignored);
+                                      } });
+            };
+            this->mailbox_ = std::make_shared<Mailbox>(this->limits_.max_pending_messages, std::move(wake), std::move(overflow));
+        }
+
+        if (this->channels_.insert(channel).second)
+        {
+            ChannelRegistry::get_instance().subscribe(channel, this->mailbox_);
+        }
+        return this->channels_.size();
+    }
+
+    template <typename Protocol>
+    std::size_t BasicReadWithResponseConnection<Protocol>::unsubscribe(const std::string &channel)
+    {
+        if (this->channels_.erase(channel) > 0)
+        {
+            ChannelRegistry::get_instance().unsubscribe(channel, this->mailbox_.get());
+        }
+        return this->channels_.size();
+    }
+
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::unsubscribe_all()
+    {
+        for (auto &&channel : this->channels_)
+        {
+            ChannelRegistry::get_instance().unsubscribe(channel, this->mailbox_.get());
+        }
+        this->channels_.clear();
+    }
+
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::follow_replication_log(std::uint64_t offset)
+    {
+        if (this->protocol_ != WireProtocol::BINARY)
+        {
+            throw DatabaseException("Replication requires the binary protocol", "CMD_PROTOCOL");
+        }
+        this->replication_offset_ = offset;
+    }
+
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::follow_snapshot()
+    {
+        if (this->protocol_ != WireProtocol::BINARY)
+        {
+            throw DatabaseException("Replication requires the binary protocol", "CMD_PROTOCOL");
+        }
+        this->follow_snapshot_ = true;
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<void> BasicReadWithResponseConnection<Protocol>::serve()
+    {
+        this->admitted_ = this->admission_.try_admit();
+        this->wheel_.add(this->shared_from_this());
+        Metrics::get_instance().connection_opened();
+
+        // A rejected client does not get to hold its socket while it is idle. It is told why in the protocol it speaks only
+        // if its first bytes already arrived, otherwise the connection is closed right away.
+        boost::system::error_code ec;
+        if (!this->admitted_ && this->socket_.available(ec) == 0)
+        {
+            close(ec);
+            co_return;
+        }
+
+        ec = co_await wait_for_request();
+        if (!ec && static_cast<std::uint8_t>(*boost::asio::buffers_begin(this->buffer_.data())) == protocol::MAGIC)
+        {
+            this->protocol_ = WireProtocol::BINARY;
+            this->buffer_.consume(1);
+            Metrics::get_instance().add_bytes_in(1);
+        }
+
+        if (!ec && !this->admitted_)
+        {
+            Reply reply{false, "Too many connections", "MAX_CONNECTIONS"};
+            co_await reject(std::move(reply));
+            co_return;
+        }
+
+        // Pipelined requests that already arrived are still in buffer_, so the next read completes immediately for them and
+        // replies are sent in the order of the requests.
+        while (!ec)
+        {
+            std::vector<boost::shared_ptr<Command>> commands;
+            Reply parse_reply{true, "", ""};
+            ec = co_await wait_for_request();
+            if (ec)
+            {
+                break;
+            }
+
+            arm(this->limits_.read_timeout);
+            this->reading_request_ = true;
+            if (this->protocol_ == WireProtocol::BINARY)
+            {
+                ec = co_await read_frame(commands, parse_reply);
+            }
+            else
+            {
+                ec = co_await read_text_request(commands, parse_reply);
+            }
+            if (ec == boost::asio::error::message_size)
+            {
+                // The stream cannot be resynchronized after an oversized request, so the connection is closed.
+                Reply reply{false, "Request exceeds " + std::to_string(this->limits_.max_request_bytes) + " bytes", "REQUEST_TOO_LARGE"};
+                co_await reject(std::move(reply));
+                co_return;
+            }
+            if (ec)
+            {
+                break;
+            }
+            this->reading_request_ = false;
+            disarm();
+
+            // The kinds are taken before executing, which may replace a command with its rejection.
+            std::vector<CommandType> types;
+            types.reserve(commands.size());
+            for (auto &&command : commands)
+            {
+                types.push_back(command->type());
+            }
+            std::vector<Reply> replies = co_await execute(std::move(commands), std::move(parse_reply));
+            serialize(std::move(replies), types);
+            ec = co_await write_response();
+            if (!ec && std::exchange(this->follow_snapshot_, false))
+            {
+                ec = co_await stream_snapshot();
+            }
+            if (!ec && this->replication_offset_)
+            {
+                ec = co_await stream_replication_log();
+            }
+        }
+
+        close(ec);
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<boost::system::error_code> BasicReadWithResponseConnection<Protocol>::wait_for_request()
+    {
+        // A subscribed client may wait for messages as long as it likes, a dead one is detected by a failing push.
+        arm(this->channels_.empty() ? this->limits_.idle_timeout : std::chrono::seconds(0));
+        co_return co_await read_at_least(1);
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<boost::system::error_code> BasicReadWithResponseConnection<Protocol>::read_at_least(std::size_t size)
+    {
+        boost::system::error_code ec;
+        if (this->buffer_.size() < size)
+        {
+            co_await boost::asio::async_read(socket_, buffer_, boost::asio::transfer_at_least(size - this->buffer_.size()),
+                                             boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        }
+        co_return ec;
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<boost::system::error_code> BasicReadWithResponseConnection<Protocol>::read_text_request(std::vector<boost::shared_ptr<Command>> &commands,
+                                                                                                            Reply &parse_reply)
+    {
+        boost::system::error_code ec;
+        std::size_t size = co_await boost::asio::async_read_until(socket_, buffer_, boost::asio::string_view{"|"},
+                                                                  boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        if (ec == boost::asio::error::not_found)
+        {
+            // The buffer reached `max_request_bytes` without a complete request.
+            co_return boost::asio::error::message_size;
+        }
+        if (ec)
+        {
+            co_return ec;
+        }
+
+        // The request is parsed in place, the buffer is consumed only after the commands are built.
+        std::string_view request(boost::asio::buffer_cast<const char *>(this->buffer_.data()), size - 1);
+        parse_reply = execute_guarded([&]
+                                      {
+                                          CommandArena::Scope arena;
+                                          commands = this->execution_ioc_->getParser().extract_commands(request, this->limits_.max_commands);
+                                          return std::string{}; });
+        this->buffer_.consume(size);
+        Metrics::get_instance().add_bytes_in(size);
+        co_return ec;
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<boost::system::error_code> BasicReadWithResponseConnection<Protocol>::read_frame(std::vector<boost::shared_ptr<Command>> &commands,
+                                                                                                     Reply &parse_reply)
+    {
+        boost::system::error_code ec = co_await read_at_least(protocol::HEADER_SIZE);
+        if (ec)
+        {
+            co_return ec;
+        }
+
+        protocol::FrameHeader header = protocol::decode_header(boost::asio::buffer_cast<const char *>(this->buffer_.data()));
+        if (header.length > this->limits_.max_request_bytes - protocol::HEADER_SIZE)
+        {
+            co_return boost::asio::error::message_size;
+        }
+        ec = co_await read_at_least(protocol::HEADER_SIZE + header.length);
+        if (ec)
+        {
+            co_return ec;
+        }
+
+        auto parse_frame = [&](const protocol::FrameHeader &header)
+        {
+            const char *body = boost::asio::buffer_cast<const char *>(this->buffer_.data()) + protocol::HEADER_SIZE;
+            return execute_guarded([&]
+                                   {
+                                       if (header.opcode != protocol::Opcode::COMMAND)
+                                       {
+                                           throw DatabaseException("Unsupported frame opcode", "BAD_OPCODE");
+                                       }
+                                       auto arguments = protocol::decode_arguments(header, body);
+                                       commands.push_back(this->execution_ioc_->getParser().extract_command(arguments));
+                                       return std::string{}; });
+        };
+        std::size_t consumed = protocol::HEADER_SIZE + header.length;
+        {
+            // The commands of the frames read together share an arena, the scope ends before the coroutine suspends again.
+            CommandArena::Scope arena;
+            parse_reply = parse_frame(header);
+            this->buffer_.consume(protocol::HEADER_SIZE + header.length);
+
+            // Frames pipelined behind this one are executed with it, so they share one round trip to the executor and one write.
+            // A frame which fails to parse is left in the buffer and rejected on its own by the next read.
+            while (parse_reply.success && commands.size() < this->limits_.max_commands && this->buffer_.size() >= protocol::HEADER_SIZE)
+            {
+                header = protocol::decode_header(boost::asio::buffer_cast<const char *>(this->buffer_.data()));
+                if (header.opcode != protocol::Opcode::COMMAND || this->buffer_.size() < protocol::HEADER_SIZE + header.length ||
+                    !parse_frame(header).success)
+                {
+                    break;
+                }
+                this->buffer_.consume(protocol::HEADER_SIZE + header.length);
+                consumed += protocol::HEADER_SIZE + header.length;
+            }
+        }
+        Metrics::get_instance().add_bytes_in(consumed);
+        co_return ec;
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<std::vector<Reply>> BasicReadWithResponseConnection<Protocol>::execute(std::vector<boost::shared_ptr<Command>> commands,
+                                                                                           Reply parse_reply)
+    {
+        // A request that fails to parse is rejected as a whole with a single reply.
+        if (!parse_reply.success || commands.empty())
+        {
+            std::vector<Reply> replies;
+            replies.push_back(std::move(parse_reply));
+            co_return replies;
+        }
+
+        if (this->limits_.read_only)
+        {
+            for (auto &&command : commands)
+            {
+                // The slots of a replica are assigned like the slots of any node, they are not part of the keyspace.
+                if (!command->is_read_only() && command->type() != CommandType::CLUSTER_SETSLOT)
+                {
+                    command = boost::make_shared<RejectedCommand>(DatabaseException("Replicas execute read-only commands only", "READ_ONLY"));
+                }
+            }
+        }
+
+        auto &cluster = ClusterState::get_instance();
+        if (cluster.enabled())
         {
-            std::string response;
-            std::istream is(&this->buffer_);
-            std::string received_data(std::istreambuf_iterator<char>(is), {});
-            std::string trimmed_data = boost::trim_right_copy_if(received_data, [](char c)
-                                                                 { return c != '|'; });
-            trimmed_data = trimmed_data.substr(0, trimmed_data.size() - 1);
+            for (auto &&command : commands)
+            {
+                // ASKING applies to the next command, which may arrive with a later request.
+                if (dynamic_cast<AskingCommand *>(command.get()) != nullptr)
+                {
+                    this->asking_ = true;
+                    continue;
+                }
+                if (auto redirect = cluster.route(command->keys(), std::exchange(this->asking_, false)))
+                {
+                    command = boost::make_shared<RejectedCommand>(std::move(*redirect));
+                }
+            }
+        }
 
-            try
+        auto runs_on_connection = [](const boost::shared_ptr<Command> &command)
+        {
+            return dynamic_cast<AsyncCommand *>(command.get()) != nullptr || dynamic_cast<SessionCommand *>(command.get()) != nullptr;
+        };
+        if (std::none_of(commands.begin(), commands.end(), runs_on_connection))
+        {
+            co_return co_await execute_batch(std::move(commands));
+        }
+
+        // Commands up to the next command running on the connection run as one batch, so the replies keep the order of the
+        // commands.
+        std::vector<Reply> replies;
+        replies.reserve(commands.size());
+        auto begin = commands.begin();
+        while (begin != commands.end())
+        {
+            auto next = std::find_if(begin, commands.end(), runs_on_connection);
+            if (next != begin)
             {
-                std::vector<boost::shared_ptr<Command>> commands = this->execution_ioc_->getParser().extract_commands(trimmed_data);
-                for (auto &&command : commands)
+                std::vector<boost::shared_ptr<Command>> batch(std::make_move_iterator(begin), std::make_move_iterator(next));
+                std::vector<Reply> batch_replies = co_await execute_batch(std::move(batch));
+                std::move(batch_replies.begin(), batch_replies.end(), std::back_inserter(replies));
+            }
+            if (next != commands.end())
+            {
+                auto start = std::chrono::steady_clock::now();
+                if (auto session_command = boost::dynamic_pointer_cast<SessionCommand>(*next))
                 {
-                    response = command->execute();
+                    replies.push_back(execute_guarded([&]
+                                                      { return session_command->execute_in(*this); }));
                 }
-                response = "[1][" + response + "]" + "[]\n";
+                else if (!this->channels_.empty())
+                {
+                    // Waiting for a disconnect would cancel the pushes of the subscribed channels.
+                    replies.push_back(Reply{false, "Blocking commands are not allowed while subscribed", "CMD_SUBSCRIBED"});
+                }
+                else
+                {
+                    boost::shared_ptr<AsyncCommand> command = boost::dynamic_pointer_cast<AsyncCommand>(*next);
+                    Reply reply = co_await execute_async_command(std::move(command));
+                    replies.push_back(std::move(reply));
+                }
+                // A blocking command is measured until it completes, including the time it waited.
+                Metrics::get_instance().record(static_cast<std::size_t>((*next)->type()), Phase::EXECUTE, std::chrono::steady_clock::now() - start);
+                ++next;
+            }
+            begin = next;
+        }
+        co_return replies;
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<std::vector<Reply>> BasicReadWithResponseConnection<Protocol>::execute_batch(std::vector<boost::shared_ptr<Command>> commands)
+    {
+        ExecutionLane lane = ExecutionLane::FAST;
+        for (auto &&command : commands)
+        {
+            if (command->lane() == ExecutionLane::SLOW)
+            {
+                lane = ExecutionLane::SLOW;
             }
-            catch (const DatabaseException &e)
+        }
+
+        co_return co_await async_execute(this->execution_ioc_->getExecutor(), lane, std::move(commands), strand_, boost::asio::use_awaitable);
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<Reply> BasicReadWithResponseConnection<Protocol>::execute_async_command(boost::shared_ptr<AsyncCommand> command)
+    {
+        boost::asio::steady_timer timer{strand_};
+        if (command->timeout().count() > 0)
+        {
+            timer.expires_after(command->timeout());
+            timer.async_wait([command](const boost::system::error_code &ec)
+                             {
+                                 if (!ec)
+                                 {
+                                     command->cancel();
+                                 } });
+        }
+
+        // A client which disconnects while it waits must give up its place, otherwise it would swallow the next pushed item.
+        // The peek completes when the peer closes the socket or sends the next request, nothing is consumed.
+        this->socket_.async_receive(boost::asio::buffer(&this->peek_byte_, 1), Protocol::socket::message_peek,
+                                    [self = this->shared_from_this(), command](const boost::system::error_code &ec, std::size_t size)
+                                    {
+                                        if (ec != boost::asio::error::operation_aborted && (ec || size == 0))
+                                        {
+                                            command->cancel();
+                                        }
+                                    });
+
+        Reply reply = co_await async_complete(this->execution_ioc_->getExecutor(), command, strand_, boost::asio::use_awaitable);
+
+        timer.cancel();
+        boost::system::error_code ignored;
+        this->socket_.cancel(ignored);
+        co_return reply;
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<void> BasicReadWithResponseConnection<Protocol>::push_messages()
+    {
+        co_await acquire_write_turn();
+
+        boost::system::error_code ec;
+        while (!ec && this->mailbox_->take(this->pushed_messages_))
+        {
+            for (auto &&message : this->pushed_messages_)
             {
-                response = "[0][" + e.get_message() + "][" + e.get_code() + "]\n";
+                append_message(this->push_response_, this->protocol_, *message);
             }
-            catch (const boost::bad_lexical_cast &e)
+
+            arm(this->limits_.write_timeout);
+            std::size_t written = co_await boost::asio::async_write(socket_, this->push_response_.buffers(), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            Metrics::get_instance().add_bytes_out(written);
+            this->push_response_.clear();
+            this->pushed_messages_.clear();
+            // The serving coroutine may be in the middle of reading a request, its deadline is restored.
+            if (this->reading_request_)
             {
-                response = "[0][" + std::string{e.what()} + "][BAD_CAST]\n";
+                arm(this->limits_.read_timeout);
             }
-            catch (...)
+            else
             {
-                response = "[0][Unknown error][UNKNOWN]\n";
+                disarm();
             }
+        }
+        release_write_turn();
 
-            std::vector<char> data(response.length());
-            std::copy(response.begin(), response.end(), data.begin());
+        if (ec)
+        {
+            // The serving coroutine notices the closed socket and finishes the connection.
+            this->closed_by_server_ = true;
+            boost::system::error_code ignored;
+            this->socket_.close(ignored);
+        }
+    }
 
-            boost::asio::async_write(socket_, boost::asio::buffer(data),
-                                     boost::bind(&DefaultReadWithResponseConnection::handle_write_finished,
-                                                 shared_from_this(),
-                                                 boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+    template <typename Protocol>
+    boost::asio::awaitable<boost::system::error_code> BasicReadWithResponseConnection<Protocol>::stream_snapshot()
+    {
+        auto &executor = this->execution_ioc_->getExecutor();
+
+        // Forking waits for the writes in progress, so it does not run on the strand.
+        ReplicationLog::ForkedSnapshot snapshot;
+        Reply reply{true, "", ""};
+        std::function<void()> fork = [&]
+        {
+            reply = execute_guarded([&]
+                                    {
+                                        snapshot = ReplicationLog::get_instance().fork_snapshot();
+                                        return std::to_string(snapshot.offset); });
+        };
+        co_await async_submit(executor, ExecutionLane::SLOW, std::move(fork), strand_, boost::asio::use_awaitable);
+        if (!reply.success)
+        {
+            serialize({std::move(reply)}, {});
+            co_return co_await write_response();
+        }
+
+        // Every chunk read from the pipe is sent before the next one is read, so the child is slowed down to the pace of
+        // the replica instead of the snapshot piling up in memory.
+        boost::asio::posix::stream_descriptor pipe{strand_, snapshot.fd};
+        std::string chunk;
+        boost::system::error_code ec;
+        boost::system::error_code read_ec;
+        while (!ec && !read_ec)
+        {
+            chunk.resize(SnapshotWriter::CHUNK_SIZE);
+            std::size_t size = co_await boost::asio::async_read(pipe, boost::asio::buffer(chunk), boost::asio::redirect_error(boost::asio::use_awaitable, read_ec));
+            if (size == 0)
+            {
+                continue;
+            }
+            chunk.resize(size);
+
+            protocol::FrameHeader header;
+            header.opcode = protocol::Opcode::SNAPSHOT;
+            header.argc = 1;
+            header.length = protocol::ARGUMENT_PREFIX_SIZE + chunk.size();
+            protocol::encode_header(this->response_.storage(), header);
+            protocol::encode_argument_size(this->response_.storage(), chunk.size());
+            this->response_.commit_storage();
+            this->response_.append_static(chunk);
+
+            arm(this->limits_.write_timeout);
+            std::size_t written = co_await boost::asio::async_write(socket_, this->response_.buffers(), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            Metrics::get_instance().add_bytes_out(written);
+            this->response_.clear();
+            disarm();
+        }
+        pipe.close();
+
+        // A child that is not done yet is killed, its snapshot is no longer needed.
+        bool complete = false;
+        std::function<void()> wait = [&]
+        {
+            complete = DataExporter::wait_save(snapshot.pid, read_ec != boost::asio::error::eof);
+        };
+        co_await async_submit(executor, ExecutionLane::SLOW, std::move(wait), strand_, boost::asio::use_awaitable);
+        if (ec)
+        {
+            co_return ec;
+        }
+
+        if (!complete)
+        {
+            reply = Reply{false, "Snapshot failed", "REPL_SNAPSHOT"};
         }
         else
         {
-            std::cerr << "Error connection read handle : " << ec.message() << std::endl;
+            this->replication_offset_ = snapshot.offset;
+        }
+        serialize({std::move(reply)}, {});
+        co_return co_await write_response();
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<boost::system::error_code> BasicReadWithResponseConnection<Protocol>::stream_replication_log()
+    {
+        // The bytes written at once, a replica far behind catches up in steps of this size.
+        constexpr std::size_t MAX_BATCH_BYTES = 1 << 20;
+
+        auto &log = ReplicationLog::get_instance();
+        boost::weak_ptr<BasicReadWithResponseConnection> weak_self = this->shared_from_this();
+        ConnectionStrand strand = this->strand_;
+        auto wake_pending = std::make_shared<std::atomic<bool>>(false);
+        std::uint64_t watcher = log.watch([weak_self, strand, wake_pending]
+                                          {
+                                              // Recording only posts to the strand once until the stream reads the log again.
+                                              if (!wake_pending->exchange(true))
+                                              {
+                                                  boost::asio::post(strand, [weak_self]
+                                                                    {
+                                                                        if (auto self = weak_self.lock())
+                                                                        {
+                                                                            self->log_ready_ = true;
+                                                                            self->log_wait_.cancel();
+                                                                        } });
+                                              } });
+
+        // The replica sends nothing after REPLSYNC, so a disconnect is noticed by the next write.
+        std::uint64_t offset = *this->replication_offset_;
+        std::vector<ReplicationLog::Entry> entries;
+        boost::system::error_code ec;
+        while (!ec)
+        {
+            wake_pending->store(false);
+            entries.clear();
+            if (!log.read(offset, entries, MAX_BATCH_BYTES))
+            {
+                // The replica fell behind the backlog, it reconnects and loads a new snapshot.
+                this->closed_by_server_ = true;
+                ec = boost::asio::error::no_buffer_space;
+                break;
+            }
+            if (entries.empty())
+            {
+                if (!this->log_ready_)
+                {
+                    boost::system::error_code ignored;
+                    co_await this->log_wait_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ignored));
+                }
+                this->log_ready_ = false;
+                continue;
+            }
+
+            for (auto &&entry : entries)
+            {
+                this->response_.append_static(*entry);
+            }
+            arm(this->limits_.write_timeout);
+            std::size_t written = co_await boost::asio::async_write(socket_, this->response_.buffers(), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+            Metrics::get_instance().add_bytes_out(written);
+            this->response_.clear();
+            disarm();
+            offset += entries.size();
+        }
+
+        log.unwatch(watcher);
+        co_return ec;
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<void> BasicReadWithResponseConnection<Protocol>::acquire_write_turn()
+    {
+        while (this->writing_)
+        {
+            boost::system::error_code ignored;
+            co_await this->write_turn_.async_wait(boost::asio::redirect_error(boost::asio::use_awaitable, ignored));
+        }
+        this->writing_ = true;
+    }
+
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::release_write_turn()
+    {
+        this->writing_ = false;
+        this->write_turn_.cancel();
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<boost::system::error_code> BasicReadWithResponseConnection<Protocol>::write_response()
+    {
+        co_await acquire_write_turn();
+
+        boost::system::error_code ec;
+        arm(this->limits_.write_timeout);
+        std::size_t written = co_await boost::asio::async_write(socket_, this->response_.buffers(), boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+        Metrics::get_instance().add_bytes_out(written);
+        this->response_.clear();
+        disarm();
+
+        release_write_turn();
+        co_return ec;
+    }
+
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::serialize(std::vector<Reply> replies, const std::vector<CommandType> &types)
+    {
+        auto &metrics = Metrics::get_instance();
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < replies.size(); ++i)
+        {
+            if (!replies[i].success)
+            {
+                metrics.record_error(replies[i].code);
+            }
+            if (this->protocol_ == WireProtocol::BINARY)
+            {
+                append_frame_reply(this->response_, std::move(replies[i]));
+            }
+            else
+            {
+                append_text_reply(this->response_, std::move(replies[i]));
+            }
+            auto end = std::chrono::steady_clock::now();
+            metrics.record(static_cast<std::size_t>(i < types.size() ? types[i] : CommandType::OTHER), Phase::SERIALIZE, end - start);
+            start = end;
+        }
+
+        if (this->protocol_ == WireProtocol::TEXT)
+        {
+            this->response_.append_static("\n");
+        }
+    }
+
+    template <typename Protocol>
+    boost::asio::awaitable<void> BasicReadWithResponseConnection<Protocol>::reject(Reply reply)
+    {
+        std::vector<Reply> replies;
+        replies.push_back(std::move(reply));
+        serialize(std::move(replies), {});
+
+        boost::system::error_code ec = co_await write_response();
+        close(ec);
+    }
+
+    template <typename Protocol>
+    void BasicReadWithResponseConnection<Protocol>::close(const boost::system::error_code ec)
+    {
+        Metrics::get_instance().connection_closed();
+        disarm();
+        unsubscribe_all();
+        if (ec && !this->closed_by_server_ && ec != boost::asio::error::eof && ec != boost::asio::error::connection_reset)
+        {
+            std::cerr << "Error connection handle : " << ec.message() << std::endl;
+        }
+        boost::system::error_code ignored;
+        this->socket_.close(ignored);
+    }
+
+    template class BasicReadWithResponseConnection<boost::asio::ip::tcp>;
+    template class BasicReadWithResponseConnection<boost::asio::local::stream_protocol>;
+
+    IoShard::IoShard(int concurrency_hint, int port, bool reuse_port, std::chrono::seconds shortest_timeout)
+        : io_service{concurrency_hint},
+          acceptor{io_service},
+          wheel{io_service, shortest_timeout}
+    {
+        using reuse_port_option = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+        boost::asio::ip::tcp::endpoint endpoint{boost::asio::ip::tcp::v4(), static_cast<unsigned short>(port)};
+        acceptor.open(endpoint.protocol());
+        acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+        if (reuse_port)
+        {
+            acceptor.set_option(reuse_port_option(true));
+        }
+        acceptor.bind(endpoint);
+        acceptor.listen();
+    }
+
+    int resolve_thread_count(const Config &config)
+    {
+        int thread_count = config.get_thread_count();
+        if (thread_count <= 0)
+        {
+            thread_count = std::max(1u, std::thread::hardware_concurrency());
         }
+        return thread_count;
     }
 
-    void DefaultReadWithResponseConnection::handle_write_finished(const boost::system::error_code ec, std::size_t bytes_transferred)
+    void pin_to_cpu(std::thread &thread, unsigned int cpu)
     {
-        this->socket_.close();
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpu_set) != 0)
+        {
+            std::cerr << "Cannot pin worker thread to CPU " << cpu << std::endl;
+        }
     }
 
     DefaultTcpServer::DefaultTcpServer(const Config &config, boost::shared_ptr<DefaultExecutionIoC> execution_ioc)
-        : io_service_{config.get_thread_count()},
-          acceptor_(this->io_service_, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), config.get_port())),
+        : config_{config},
+          shards_{make_shards(config)},
           execution_ioc_{execution_ioc},
-          timer_{this->io_service_, boost::posix_time::seconds(config.get_dump_period())},
-          config_{config}
+          timer_{shards_.front()->io_service, boost::posix_time::seconds(config.get_dump_period())},
+          limits_{config},
+          admission_{config.get_max_connections()}
     {
         DataImporter::load(config.get_persistence_file());
+        if (!config.get_cluster_address().empty())
+        {
+            ClusterState::get_instance().configure(config.get_cluster_address(), config.get_cluster_nodes());
+        }
+        if (!config.get_replica_of().empty())
+        {
+            replica_ = std::make_unique<ReplicaClient>(shards_.front()->io_service, config.get_replica_of(), execution_ioc_);
+            replica_->start();
+        }
+        else if (config.get_replication_backlog() > 0)
+        {
+            ReplicationLog::get_instance().enable(config.get_replication_backlog());
+        }
+        if (!config.get_unix_socket_path().empty())
+        {
+            listen_local();
+        }
         accept();
+        for (auto &&shard : shards_)
+        {
+            shard->wheel.start();
+        }
         timer_.async_wait(boost::bind(&DefaultTcpServer::schedule, this, boost::asio::placeholders::error));
     }
 
+    std::vector<std::unique_ptr<IoShard>> DefaultTcpServer::make_shards(const Config &config)
+    {
+        int thread_count = resolve_thread_count(config);
+        std::chrono::seconds shortest_timeout = ConnectionLimits(config).shortest_timeout();
+        std::vector<std::unique_ptr<IoShard>> shards;
+
+        if (!config.get_per_core_mode())
+        {
+            shards.push_back(std::make_unique<IoShard>(thread_count, config.get_port(), false, shortest_timeout));
+            return shards;
+        }
+
+        shards.reserve(thread_count);
+        for (int i = 0; i < thread_count; ++i)
+        {
+            shards.push_back(std::make_unique<IoShard>(1, config.get_port(), true, shortest_timeout));
+        }
+        return shards;
+    }
+
     void DefaultTcpServer::run()
     {
-        io_service_.run();
+        int thread_count = resolve_thread_count(config_);
+
+        workers_.reserve(thread_count);
+        if (config_.get_per_core_mode())
+        {
+            unsigned int cpu_count = std::max(1u, std::thread::hardware_concurrency());
+            for (auto &&shard : shards_)
+            {
+                workers_.emplace_back([&shard]
+                                      { shard->io_service.run(); });
+                pin_to_cpu(workers_.back(), (workers_.size() - 1) % cpu_count);
+            }
+        }
+        else
+        {
+            IoShard &shard = *shards_.front();
+            for (int i = 0; i < thread_count; ++i)
+            {
+                workers_.emplace_back([&shard]
+                                      { shard.io_service.run(); });
+            }
+        }
+
+        for (auto &&worker : workers_)
+        {
+            worker.join();
+        }
+        workers_.clear();
     }
 
     void DefaultTcpServer::accept()
     {
-        boost::shared_ptr<Connection> connection = boost::make_shared<DefaultReadWithResponseConnection>(this->io_service_, this->execution_ioc_);
-        acceptor_.async_accept(connection->get_socket(),
-                               boost::bind(&DefaultTcpServer::handle_accept, this, connection, boost::asio::placeholders::error));
+        for (auto &&shard : shards_)
+        {
+            accept(*shard);
+        }
+        if (local_acceptor_)
+        {
+            accept_local();
+        }
     }
 
-    void DefaultTcpServer::handle_accept(boost::shared_ptr<Connection> conn, const boost::system::error_code &ec)
+    void DefaultTcpServer::accept(IoShard &shard)
     {
+        auto connection = boost::make_shared<DefaultReadWithResponseConnection>(shard.io_service, this->execution_ioc_, limits_, admission_, shard.wheel);
+        shard.acceptor.async_accept(connection->get_socket(),
+                                    boost::bind(&DefaultTcpServer::handle_shard_accept, this, boost::ref(shard), boost::shared_ptr<Connection>(connection), boost::asio::placeholders::error));
+    }
+
+    void DefaultTcpServer::listen_local()
+    {
+        const std::string &path = config_.get_unix_socket_path();
+        ::unlink(path.c_str());
+
+        local_acceptor_ = std::make_unique<boost::asio::local::stream_protocol::acceptor>(shards_.front()->io_service);
+        boost::asio::local::stream_protocol::endpoint endpoint{path};
+        local_acceptor_->open(endpoint.protocol());
+        local_acceptor_->bind(endpoint);
+        local_acceptor_->listen();
+    }
+
+    void DefaultTcpServer::accept_local()
+    {
+        IoShard &shard = *shards_[next_local_shard_];
+        next_local_shard_ = (next_local_shard_ + 1) % shards_.size();
+
+        auto connection = boost::make_shared<LocalReadWithResponseConnection>(shard.io_service, this->execution_ioc_, limits_, admission_, shard.wheel);
+        local_acceptor_->async_accept(connection->get_socket(),
+                                      boost::bind(&DefaultTcpServer::handle_local_accept, this, boost::shared_ptr<Connection>(connection), boost::asio::placeholders::error));
+    }
+
+    void DefaultTcpServer::handle_local_accept(boost::shared_ptr<Connection> conn, const boost::system::error_code &ec)
+    {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+        handle_accept(conn, ec);
+        accept_local();
+    }
 
+    void DefaultTcpServer::handle_accept(boost::shared_ptr<Connection> conn, const boost::system::error_code &ec)
+    {
         if (!ec)
         {
             conn->perform_connection();
         }
-        else
+    }
+
+    void DefaultTcpServer::handle_shard_accept(IoShard &shard, boost::shared_ptr<Connection> conn, const boost::system::error_code &ec)
+    {
+        if (ec == boost::asio::error::operation_aborted)
         {
             return;
         }
-        accept();
+        handle_accept(conn, ec);
+        accept(shard);
     }
+
     void DefaultTcpServer::schedule(const boost::system::error_code &ec)
     {
-        DataExporter::save(config_.get_persistence_file());
-        timer_.expires_from_now(boost::posix_time::seconds(10));
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+
+        // Forking waits for the writes in progress, so it runs on the slow lane instead of the IO thread. The child saves
+        // while writes go on, and the timer is only rearmed once it exited, so saves never overlap.
+        execution_ioc_->getExecutor().submit(ExecutionLane::SLOW, [this]
+                                             {
+                                                 pid_t pid = DataExporter::fork_save([this]
+                                                                                     { return DataExporter::save(config_.get_persistence_file(), config_.get_io_backend()); });
+                                                 if (pid < 0)
+                                                 {
+                                                     std::cerr << "Error forking the snapshot: " << std::strerror(errno) << std::endl;
+                                                 }
+                                                 boost::asio::post(timer_.get_executor(), [this, pid]
+                                                                   { await_save(pid); }); });
+    }
+
+    void DefaultTcpServer::await_save(pid_t pid)
+    {
+        if (pid < 0)
+        {
+            rearm_save();
+            return;
+        }
+
+        int pidfd = static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+        if (pidfd < 0)
+        {
+            execution_ioc_->getExecutor().submit(ExecutionLane::SLOW, [this, pid]
+                                                 {
+                                                     DataExporter::wait_save(pid, false);
+                                                     boost::asio::post(timer_.get_executor(), [this]
+                                                                       { rearm_save(); }); });
+            return;
+        }
+
+        // The pidfd becomes readable once the child exited, so reaping it does not block.
+        auto child = std::make_shared<boost::asio::posix::stream_descriptor>(timer_.get_executor(), pidfd);
+        child->async_wait(boost::asio::posix::stream_descriptor::wait_read, [this, pid, child](const boost::system::error_code &ec)
+                          {
+                              DataExporter::wait_save(pid, ec.failed());
+                              if (ec != boost::asio::error::operation_aborted)
+                              {
+                                  rearm_save();
+                              } });
+    }
+
+    void DefaultTcpServer::rearm_save()
+    {
+        timer_.expires_from_now(boost::posix_time::seconds(config_.get_dump_period()));
         timer_.async_wait(boost::bind(&DefaultTcpServer::schedule, this, boost::asio::placeholders::error));
     }
 }
@@ -1,26 +1,47 @@
 #pragma once
 
+#include <utility>
 #include <boost/asio.hpp>
+#include <atomic>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/bind.hpp>
 #include <parser.hpp>
+#include <channels.hpp>
+#include <replication_log.hpp>
+#include <cluster.hpp>
 #include <execution_ioc.hpp>
+#include <protocol.hpp>
+#include <response.hpp>
+#include <timer_wheel.hpp>
+#include <replica.hpp>
 
 namespace db
 {
     using DefaultExecutionIoC = ExecutionIoC<DefaultParser>;
 
+    /** The strand type serializing the coroutine of a connection. */
+    using ConnectionStrand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
     /**
      * @brief Interface for a database connection.
      *
      * A database connection represents an active connection to a database server. It provides methods for executing queries and
-     * other operations on the database.
+     * other operations on the database. The socket of a connection depends on its transport and is exposed by the
+     * implementations.
      */
     class Connection
     {
     public:
+        virtual ~Connection() = default;
+
         /**
          * @brief Performs the connection to the database.
          *
@@ -28,15 +49,173 @@ namespace db
          * initialization steps.
          */
         virtual void perform_connection() = 0;
+    };
+
+    /**
+     * @brief The outcome of a single command, independent of the wire protocol it is sent with.
+     */
+    struct Reply
+    {
+        /** Whether the command succeeded. */
+        bool success;
+
+        /** The result of the command, or the error message if it failed. */
+        std::string payload;
 
+        /** The error code if the command failed, empty otherwise. */
+        std::string code;
+    };
+
+    /**
+     * @brief The wire protocol spoken on a connection.
+     */
+    enum class WireProtocol
+    {
         /**
-         * @brief Returns the underlying socket of the connection.
+         * Requests are `|`-terminated text made of `;`-separated commands. A reply is a line with one `[status][payload][code]`
+         * triple per command, in the order of the commands.
+         */
+        TEXT,
+
+        /** Requests and replies are length-prefixed frames, see protocol.hpp. */
+        BINARY
+    };
+
+    /**
+     * @brief The limits every connection enforces on its requests.
+     */
+    struct ConnectionLimits
+    {
+        /**
+         * The maximum number of bytes buffered for a request, including pipelined requests that are not served yet. A client
+         * exceeding it gets a `REQUEST_TOO_LARGE` error and is disconnected. While a request is executed nothing is read, so
+         * a client sending faster than it is served is paused by TCP flow control.
+         */
+        std::size_t max_request_bytes = std::numeric_limits<std::size_t>::max();
+
+        /** The maximum number of commands in a single text request. Longer requests fail with `TOO_MANY_COMMANDS`. */
+        std::size_t max_commands = std::numeric_limits<std::size_t>::max();
+
+        /** The time a connection may wait for the next request, zero means no timeout. */
+        std::chrono::seconds idle_timeout{0};
+
+        /** The time a client may take to send the rest of a started request, zero means no timeout. */
+        std::chrono::seconds read_timeout{0};
+
+        /** The time a client may take to receive a reply, zero means no timeout. */
+        std::chrono::seconds write_timeout{0};
+
+        /**
+         * The maximum number of published messages queued for a subscribed client before it is disconnected. It is never
+         * unlimited, a subscriber that stops reading would otherwise hold every message published meanwhile.
+         */
+        std::size_t max_pending_messages = Config::DEFAULT_MAX_PENDING_MESSAGES;
+
+        /** Whether commands modifying the keyspace are refused with `READ_ONLY`, because the server is a replica. */
+        bool read_only = false;
+
+        ConnectionLimits() = default;
+
+        /**
+         * @brief Reads the limits from the configuration, non-positive values mean no limit.
          *
-         * The returned socket can be used for sending and receiving data over the connection.
+         * @param config The configuration for the server.
+         */
+        explicit ConnectionLimits(const Config &config);
+
+        /**
+         * @brief Returns the shortest enabled timeout, zero if no timeout is enabled.
+         */
+        std::chrono::seconds shortest_timeout() const;
+    };
+
+    /**
+     * @brief Counts the served connections and rejects connections over the configured maximum.
+     *
+     * The counter is shared by all shards and acceptors of a server.
+     */
+    class AdmissionControl
+    {
+    private:
+        /** The maximum number of served connections, non-positive values mean no limit. */
+        int max_connections_;
+
+        /** The number of admitted connections. */
+        std::atomic<int> active_{0};
+
+    public:
+        /**
+         * @brief Constructs an AdmissionControl object.
          *
-         * @return The underlying socket of the connection.
+         * @param max_connections The maximum number of served connections, non-positive values mean no limit.
+         */
+        explicit AdmissionControl(int max_connections);
+
+        /**
+         * @brief Admits a new connection if the maximum is not reached.
+         *
+         * @return True if the connection is admitted and must be released later, false otherwise.
+         */
+        bool try_admit();
+
+        /**
+         * @brief Releases an admitted connection.
+         */
+        void release();
+    };
+
+    /**
+     * @brief The bounded queue of published messages waiting to be pushed to a subscribed connection.
+     *
+     * Publishers only append a shared pointer to the message and wake the connection once per batch, so a publish neither
+     * copies nor serializes the payload per subscriber and never waits for a slow client. The connection drains the whole
+     * queue and sends it with a single write.
+     */
+    class Mailbox : public Subscriber
+    {
+    private:
+        std::mutex mutex_;
+
+        /** The messages not taken by the connection yet. */
+        std::vector<std::shared_ptr<const Message>> messages_;
+
+        /** The maximum number of queued messages. */
+        std::size_t capacity_;
+
+        /** Whether the connection was woken and has not found the queue empty since. */
+        bool wake_pending_ = false;
+
+        /** Whether the queue overflowed. Further messages are dropped. */
+        bool overflowed_ = false;
+
+        /** Makes the connection drain the queue. Called at most once until the connection finds the queue empty. */
+        std::function<void()> wake_;
+
+        /** Makes the connection give up the client. Called once, when the queue overflows. */
+        std::function<void()> overflow_;
+
+    public:
+        /**
+         * @brief Constructs a Mailbox object.
+         *
+         * @param capacity The maximum number of queued messages.
+         * @param wake Makes the connection drain the queue. It must not block.
+         * @param overflow Makes the connection give up the client. It must not block.
+         */
+        Mailbox(std::size_t capacity, std::function<void()> wake, std::function<void()> overflow);
+
+        /**
+         * @brief Queues a message, or drops it if the queue is full.
+         */
+        bool deliver(const std::shared_ptr<const Message> &message) override;
+
+        /**
+         * @brief Takes all queued messages.
+         *
+         * @param messages Receives the queued messages, it must be empty.
+         * @return False if the queue was empty. The next delivered message wakes the connection again.
          */
-        virtual boost::asio::ip::tcp::socket &get_socket() = 0;
+        bool take(std::vector<std::shared_ptr<const Message>> &messages);
     };
 
     /**
@@ -44,12 +223,33 @@ namespace db
      *
      * This class implements the Connection interface for a connection that reads data from the database server in response to
      * a request. It uses an IO service to handle asynchronous operations, and provides methods for sending and receiving data.
+     * The wire protocol is negotiated from the first byte the client sends.
+     *
+     * A connection is served by a single coroutine running on the strand of the connection, which reads a request, awaits its
+     * execution and writes the reply in a straight-line loop. The coroutine frame keeps the connection alive.
+     *
+     * Every phase of a connection is bounded by a deadline kept in the timer wheel of its IO service: waiting for a request
+     * by the idle timeout, receiving the rest of it by the read timeout and sending the reply by the write timeout. No
+     * deadline is armed while the commands execute.
+     *
+     * A connection subscribed to channels is additionally served by a coroutine pushing the published messages. Both
+     * coroutines take turns on the socket, so a push is never interleaved with a reply. A connection of a replica stops
+     * serving requests after `REPLSYNC` and streams the replication log instead.
+     *
+     * @tparam Protocol The stream protocol of the socket, `boost::asio::ip::tcp` or `boost::asio::local::stream_protocol`.
      */
-    class DefaultReadWithResponseConnection : public Connection, public boost::enable_shared_from_this<DefaultReadWithResponseConnection>
+    template <typename Protocol>
+    class BasicReadWithResponseConnection : public Connection,
+                                            public Session,
+                                            public TimerWheel::Entry,
+                                            public boost::enable_shared_from_this<BasicReadWithResponseConnection<Protocol>>
     {
     private:
         /** The underlying socket of the connection. */
-        boost::asio::ip::tcp::socket socket_;
+        typename Protocol::socket socket_;
+
+        /** The strand the coroutine of this connection runs on when the IO service runs on several threads. */
+        ConnectionStrand strand_;
 
         /** The buffer for receiving data from the server. */
         boost::asio::streambuf buffer_;
@@ -57,58 +257,289 @@ namespace db
         /** The execution IO context for executing queries and other operations on the database. */
         boost::shared_ptr<DefaultExecutionIoC> execution_ioc_;
 
+        /** The wire protocol negotiated for this connection. */
+        WireProtocol protocol_;
+
+        /** The reply being written. It must outlive the asynchronous write operation and is reused for every reply. */
+        ResponseBuilder response_;
+
+        /** The limits enforced on the requests of this connection. */
+        ConnectionLimits limits_;
+
+        /** The admission control of the server. */
+        AdmissionControl &admission_;
+
+        /** Whether the connection was admitted and has to be released when it is destroyed. */
+        bool admitted_;
+
+        /** The timer wheel watching the deadlines of this connection. */
+        TimerWheel &wheel_;
+
+        /** Whether the socket was closed by the server, because a deadline passed or the client fell behind its messages. */
+        bool closed_by_server_;
+
+        /** The target of the peek watching for a disconnect while an asynchronous command waits. */
+        char peek_byte_;
+
+        /** Whether a started request is being read, so its read deadline is armed. */
+        bool reading_request_;
+
+        /** Whether a coroutine is writing to the socket. */
+        bool writing_;
+
+        /** Wakes the coroutines waiting for their turn to write. It never expires, it is only cancelled. */
+        boost::asio::steady_timer write_turn_;
+
+        /** The channels the client is subscribed to. */
+        std::set<std::string> channels_;
+
+        /** The queue of messages published to the subscribed channels, created by the first subscription. */
+        std::shared_ptr<Mailbox> mailbox_;
+
+        /** The messages being pushed. They own the bytes referenced by `push_response_` until the write completes. */
+        std::vector<std::shared_ptr<const Message>> pushed_messages_;
+
+        /** The pushed messages being written. */
+        ResponseBuilder push_response_;
+
+        /** The offset the replication log is streamed from once the current reply is sent, if the client is a replica. */
+        std::optional<std::uint64_t> replication_offset_;
+
+        /** Whether a new snapshot is sent before the replication log, once the current reply is sent. */
+        bool follow_snapshot_;
+
+        /** Whether entries were recorded since the stream last waited for the replication log. */
+        bool log_ready_;
+
+        /** Wakes the stream waiting for new entries of the replication log. It never expires, it is only cancelled. */
+        boost::asio::steady_timer log_wait_;
+
+        /** Whether the client sent `ASKING`, so its next command may access a slot this node is importing. */
+        bool asking_;
+
     public:
         /**
-         * @brief Constructs a DefaultReadWithResponseConnection object.
+         * @brief Constructs a BasicReadWithResponseConnection object.
          *
          * @param io_service The IO service to use for asynchronous operations.
          * @param execution_ioc The execution IO context for executing queries and other operations on the database.
+         * @param limits The limits enforced on the requests of this connection.
+         * @param admission The admission control of the server, it must outlive the connection.
+         * @param wheel The timer wheel of the IO service, it must outlive the connection.
          */
-        DefaultReadWithResponseConnection(boost::asio::io_service &io_service, boost::shared_ptr<DefaultExecutionIoC> execution_ioc);
+        BasicReadWithResponseConnection(boost::asio::io_service &io_service, boost::shared_ptr<DefaultExecutionIoC> execution_ioc,
+                                        const ConnectionLimits &limits, AdmissionControl &admission, TimerWheel &wheel);
 
         /**
-         * @brief Destroys a DefaultReadWithResponseConnection object.
+         * @brief Destroys a BasicReadWithResponseConnection object.
          */
-        ~DefaultReadWithResponseConnection();
+        ~BasicReadWithResponseConnection();
 
         /**
          * @brief Performs the connection to the database.
          *
-         * This method establishes a connection to the database server and initializes the underlying socket.
+         * This method waits for the first byte of the client to select the wire protocol and starts serving requests.
          */
         void perform_connection() override;
 
         /**
          * @brief Returns the underlying socket of the connection.
          *
+         * The socket is accepted into before the connection is performed.
+         *
          * @return The underlying socket of the connection.
          */
-        boost::asio::ip::tcp::socket &get_socket() override;
+        typename Protocol::socket &get_socket();
+
+        /**
+         * @brief Closes the socket on the strand of the connection if the deadline is still expired there.
+         */
+        void expire() override;
+
+        /**
+         * @brief Subscribes the client to a channel. Must be called on the strand of the connection.
+         */
+        std::size_t subscribe(const std::string &channel) override;
+
+        /**
+         * @brief Unsubscribes the client from a channel. Must be called on the strand of the connection.
+         */
+        std::size_t unsubscribe(const std::string &channel) override;
+
+        /**
+         * @brief Unsubscribes the client from all channels. Must be called on the strand of the connection.
+         */
+        void unsubscribe_all() override;
+
+        /**
+         * @brief Streams the replication log after the current reply. Must be called on the strand of the connection.
+         *
+         * @throws DatabaseException with the `CMD_PROTOCOL` code if the connection does not use the binary protocol.
+         */
+        void follow_replication_log(std::uint64_t offset) override;
+
+        /**
+         * @brief Sends a new snapshot and streams the replication log after the current reply. Must be called on the strand
+         * of the connection.
+         *
+         * @throws DatabaseException with the `CMD_PROTOCOL` code if the connection does not use the binary protocol.
+         */
+        void follow_snapshot() override;
 
     private:
         /**
-         * @brief Callback function for handling the completion of a read operation.
+         * @brief Serves the connection until the client disconnects or an operation fails.
+         *
+         * Selects the binary protocol if the first byte is `protocol::MAGIC`, and the text protocol otherwise, then serves one
+         * request after another on the same connection. Connections over the maximum of the server are rejected.
+         */
+        boost::asio::awaitable<void> serve();
+
+        /**
+         * @brief Waits until the first byte of the next request is buffered.
+         *
+         * @return The error code of the read operation.
+         */
+        boost::asio::awaitable<boost::system::error_code> wait_for_request();
+
+        /**
+         * @brief Makes sure the buffer holds at least the given number of bytes.
+         *
+         * Completes right away if the bytes are already buffered, e.g. for pipelined frames.
+         *
+         * @param size The number of bytes the buffer must hold.
+         * @return The error code of the read operation.
+         */
+        boost::asio::awaitable<boost::system::error_code> read_at_least(std::size_t size);
+
+        /**
+         * @brief Reads and parses the next `|`-terminated text request.
+         *
+         * @param commands Receives the parsed commands of the request.
+         * @param parse_reply Receives the outcome of parsing the request.
+         * @return The error code of the read operation, `message_size` if the request exceeds `max_request_bytes`.
+         */
+        boost::asio::awaitable<boost::system::error_code> read_text_request(std::vector<boost::shared_ptr<Command>> &commands, Reply &parse_reply);
+
+        /**
+         * @brief Reads and parses the next binary frame, and the complete frames already received behind it.
+         *
+         * @param commands Receives the commands carried by the frames.
+         * @param parse_reply Receives the outcome of parsing the frame.
+         * @return The error code of the read operation, `message_size` if the frame exceeds `max_request_bytes`.
+         */
+        boost::asio::awaitable<boost::system::error_code> read_frame(std::vector<boost::shared_ptr<Command>> &commands, Reply &parse_reply);
+
+        /**
+         * @brief Executes the commands of a request.
+         *
+         * Synchronous commands run on the command executor, asynchronous commands park the connection until they complete.
+         * The replies are in the order of the commands.
+         *
+         * @param commands The parsed commands of the request.
+         * @param parse_reply The outcome of parsing the request. If parsing failed, it is the only reply.
+         * @return The replies, one per command of the request.
+         */
+        boost::asio::awaitable<std::vector<Reply>> execute(std::vector<boost::shared_ptr<Command>> commands, Reply parse_reply);
+
+        /**
+         * @brief Executes synchronous commands as one batch on the command executor.
          *
-         * This function is called when a read operation completes, either successfully or with an error. It processes the
-         * received data and sends it to the execution IO context for processing.
+         * The commands run on the lane of the slowest command, the coroutine resumes on the strand of the connection once
+         * they are done.
          *
-         * @param ec The error code indicating whether the read operation succeeded or failed.
-         * @param bytes_transferred The number of bytes transferred during the read operation.
+         * @param commands The commands to be executed.
+         * @return The replies, one per command.
          */
-        void handle_read_finished(const boost::system::error_code ec, std::size_t bytes_transferred);
+        boost::asio::awaitable<std::vector<Reply>> execute_batch(std::vector<boost::shared_ptr<Command>> commands);
 
         /**
-         * @brief Callback function for handling the completion of a write operation.
+         * @brief Executes an asynchronous command, e.g. a blocking pop, without occupying an executor thread.
          *
-         * This function is called when a write operation completes, either successfully or with an error. It processes the
-         * response data from the database server and sends it to the client.
+         * The coroutine is suspended until the command completes. The command is cancelled when its timeout passes or
+         * the client disconnects.
+         *
+         * @param command The command to be executed.
+         * @return The reply of the command.
+         */
+        boost::asio::awaitable<Reply> execute_async_command(boost::shared_ptr<AsyncCommand> command);
+
+        /**
+         * @brief Pushes the queued messages of the mailbox until it is empty.
+         *
+         * Every round takes all messages queued meanwhile and sends them with a single write. The payloads are referenced,
+         * not copied.
+         */
+        boost::asio::awaitable<void> push_messages();
+
+        /**
+         * @brief Sends a new snapshot to a replica and sets the offset the replication log is streamed from.
+         *
+         * A child process forked on the slow lane serializes the snapshot into a pipe, the connection relays it in `SNAPSHOT`
+         * frames as it is read. Writes to the keyspace are only held off while the server forks. The snapshot is closed by a
+         * reply with its offset, or with the error if it failed.
+         *
+         * @return The error code of the failed write.
+         */
+        boost::asio::awaitable<boost::system::error_code> stream_snapshot();
+
+        /**
+         * @brief Streams the entries of the replication log to a replica until the connection breaks.
+         *
+         * The entries are shared with the log and written without copying, all entries recorded since the previous write
+         * are sent with a single write.
+         *
+         * @return The error code of the failed write.
+         */
+        boost::asio::awaitable<boost::system::error_code> stream_replication_log();
+
+        /**
+         * @brief Waits until no other coroutine of this connection writes to the socket and takes the turn.
+         */
+        boost::asio::awaitable<void> acquire_write_turn();
+
+        /**
+         * @brief Gives up the turn to write and wakes the waiting coroutines.
+         */
+        void release_write_turn();
+
+        /**
+         * @brief Writes `response_` in turn with the pushed messages, bounded by the write timeout.
+         *
+         * @return The error code of the write operation.
+         */
+        boost::asio::awaitable<boost::system::error_code> write_response();
+
+        /**
+         * @brief Serializes the replies of a request into `response_` in the negotiated protocol.
+         *
+         * @param replies The replies, one per command of the request.
+         * @param types The kinds of the commands the serialization time is recorded for, `CommandType::OTHER` for replies
+         *              without one.
+         */
+        void serialize(std::vector<Reply> replies, const std::vector<CommandType> &types);
+
+        /**
+         * @brief Sends the reply explaining why the connection is refused and closes it.
+         *
+         * @param reply The error reply.
+         */
+        boost::asio::awaitable<void> reject(Reply reply);
+
+        /**
+         * @brief Closes the socket once the connection is no longer served.
          *
-         * @param ec The error code indicating whether the write operation succeeded or failed.
-         * @param bytes_transferred The number of bytes transferred during the write operation.
+         * @param ec The error code of the failed operation. Errors other than a closed peer are logged.
          */
-        void handle_write_finished(const boost::system::error_code ec, std::size_t bytes_transferred);
+        void close(const boost::system::error_code ec);
     };
 
+    /** The connection served over TCP. */
+    using DefaultReadWithResponseConnection = BasicReadWithResponseConnection<boost::asio::ip::tcp>;
+
+    /** The connection served over a Unix domain stream socket, for clients running on the same host. */
+    using LocalReadWithResponseConnection = BasicReadWithResponseConnection<boost::asio::local::stream_protocol>;
+
     /**
      * @brief Interface for a database server.
      *
@@ -131,6 +562,34 @@ namespace db
         virtual void handle_accept(boost::shared_ptr<Connection> conn, const boost::system::error_code &ec) = 0;
     };
 
+    /**
+     * @brief A single IO service together with the acceptor feeding it.
+     *
+     * In the shared mode the server owns one shard drained by all worker threads. In the per-core mode every worker thread owns
+     * its own shard, so connections accepted by a shard are served by the same thread (and CPU) for their whole lifetime.
+     */
+    struct IoShard
+    {
+        /** The IO service used for asynchronous operations of this shard. */
+        boost::asio::io_service io_service;
+
+        /** The TCP acceptor for listening for incoming connections. */
+        boost::asio::ip::tcp::acceptor acceptor;
+
+        /** The timer wheel watching the deadlines of the connections served by this shard. */
+        TimerWheel wheel;
+
+        /**
+         * @brief Constructs an IoShard listening on the given port.
+         *
+         * @param concurrency_hint The number of threads that will run the IO service.
+         * @param port The port to listen on.
+         * @param reuse_port Whether the acceptor should set SO_REUSEPORT, so several shards can listen on the same port.
+         * @param shortest_timeout The shortest connection timeout, zero if connections have no timeouts.
+         */
+        IoShard(int concurrency_hint, int port, bool reuse_port, std::chrono::seconds shortest_timeout);
+    };
+
     /**
      * @brief Implementation of the TcpServer class for a TCP server.
      *
@@ -152,16 +611,20 @@ namespace db
          * @brief Starts the server listening for incoming connections.
          *
          * This method starts the server listening for incoming connections on the specified port. Once a connection is
-         * established, the server calls the provided handler function to manage the connection.
+         * established, the server calls the provided handler function to manage the connection. The IO services are drained by
+         * `thread_count` worker threads and the method blocks until all of them finish.
          */
         void run() override;
 
     private:
-        /** The IO service used for asynchronous operations. */
-        boost::asio::io_service io_service_;
+        /** The configuration for the server. */
+        Config config_;
 
-        /** The TCP acceptor for listening for incoming connections. */
-        boost::asio::ip::tcp::acceptor acceptor_;
+        /** The IO shards of the server. There is exactly one shard unless the per-core mode is enabled. */
+        std::vector<std::unique_ptr<IoShard>> shards_;
+
+        /** The worker threads running the IO services. */
+        std::vector<std::thread> workers_;
 
         /** The buffer for receiving data from the client. */
         boost::asio::streambuf buffer_;
@@ -169,13 +632,33 @@ namespace db
         /** The execution IO context for executing queries and other operations on the database. */
         boost::shared_ptr<DefaultExecutionIoC> execution_ioc_;
 
-        /** The timer for scheduling periodic tasks. */
+        /** The timer for scheduling periodic tasks. It runs on the first shard. */
         boost::asio::deadline_timer timer_;
 
-        /** The configuration for the server. */
-        Config config_;
+        /** The acceptor of the Unix domain socket, if `unix_socket_path` is configured. It runs on the first shard. */
+        std::unique_ptr<boost::asio::local::stream_protocol::acceptor> local_acceptor_;
+
+        /** The shard serving the next connection accepted on the Unix domain socket. */
+        std::size_t next_local_shard_ = 0;
+
+        /** The limits enforced on the requests of every connection. */
+        ConnectionLimits limits_;
+
+        /** The admission control shared by all connections of the server. */
+        AdmissionControl admission_;
+
+        /** Replicates the primary, if `replica_of` is configured. It runs on the first shard. */
+        std::unique_ptr<ReplicaClient> replica_;
 
     private:
+        /**
+         * @brief Creates the IO shards described by the configuration.
+         *
+         * @param config The configuration for the server.
+         * @return One shard for the shared mode, or one SO_REUSEPORT shard per worker thread for the per-core mode.
+         */
+        static std::vector<std::unique_ptr<IoShard>> make_shards(const Config &config);
+
         /**
          * @brief Callback function for handling the completion of an accept operation.
          *
@@ -187,6 +670,27 @@ namespace db
          */
         void handle_accept(boost::shared_ptr<Connection> conn, const boost::system::error_code &ec);
 
+        /**
+         * @brief Callback function for handling the completion of an accept operation on a given shard.
+         *
+         * Starts the accepted connection and re-arms the acceptor of the shard.
+         *
+         * @param shard The shard which accepted the connection.
+         * @param conn The connection object for the incoming client.
+         * @param ec The error code indicating whether the accept operation succeeded or failed.
+         */
+        void handle_shard_accept(IoShard &shard, boost::shared_ptr<Connection> conn, const boost::system::error_code &ec);
+
+        /**
+         * @brief Callback function for handling the completion of an accept operation on the Unix domain socket.
+         *
+         * Starts the accepted connection and re-arms the Unix domain socket acceptor.
+         *
+         * @param conn The connection object for the incoming client.
+         * @param ec The error code indicating whether the accept operation succeeded or failed.
+         */
+        void handle_local_accept(boost::shared_ptr<Connection> conn, const boost::system::error_code &ec);
+
         /**
          * @brief Schedules the next task.
          *
@@ -196,11 +700,45 @@ namespace db
          */
         void schedule(const boost::system::error_code &ec);
 
+        /**
+         * @brief Reaps the child saving the periodic snapshot and rearms the timer once it exited.
+         *
+         * Waits for the child on the IO service through a pidfd, so no thread blocks for the duration of the save. Without
+         * pidfd support the child is reaped on the slow lane instead.
+         *
+         * @param pid The child created by `DataExporter::fork_save()`, or -1 if the fork failed.
+         */
+        void await_save(pid_t pid);
+
+        /**
+         * @brief Arms the timer for the next periodic snapshot after the configured dump period.
+         */
+        void rearm_save();
+
         /**
          * @brief Starts the server listening for incoming connections.
          *
          * This method called when the server is started. It starts the server listening for incoming connections on the specified port.
          */
         void accept() override;
+
+        /**
+         * @brief Arms the acceptor of the given shard for the next incoming connection.
+         *
+         * @param shard The shard whose acceptor should accept the next connection.
+         */
+        void accept(IoShard &shard);
+
+        /**
+         * @brief Binds the Unix domain socket at the configured path, replacing a stale socket file left by an earlier run.
+         */
+        void listen_local();
+
+        /**
+         * @brief Arms the Unix domain socket acceptor for the next incoming connection.
+         *
+         * Accepted connections are spread over the shards round robin, so they are served like TCP connections.
+         */
+        void accept_local();
     };
 }
\ No newline at end of file
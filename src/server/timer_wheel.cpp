@@ -0,0 +1,126 @@
+#include <timer_wheel.hpp>
+#include <algorithm>
+
+namespace db
+{
+    void TimerWheel::Entry::arm(std::chrono::seconds timeout)
+    {
+        if (timeout.count() <= 0)
+        {
+            disarm();
+            return;
+        }
+        deadline_.store((Clock::now() + timeout).time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void TimerWheel::Entry::disarm()
+    {
+        deadline_.store(0, std::memory_order_relaxed);
+    }
+
+    bool TimerWheel::Entry::expired(Clock::time_point now) const
+    {
+        Clock::rep deadline = deadline_.load(std::memory_order_relaxed);
+        return deadline != 0 && deadline <= now.time_since_epoch().count();
+    }
+
+    TimerWheel::TimerWheel(boost::asio::io_context &io_service, std::chrono::seconds shortest_timeout)
+        : timer_{io_service},
+          tick_{std::chrono::seconds(1)}
+    {
+        if (shortest_timeout.count() > 0)
+        {
+            slots_.resize(shortest_timeout / tick_ + 1);
+        }
+    }
+
+    void TimerWheel::start()
+    {
+        if (slots_.empty())
+        {
+            return;
+        }
+        timer_.expires_after(tick_);
+        timer_.async_wait([this](const boost::system::error_code &ec)
+                          { on_tick(ec); });
+    }
+
+    void TimerWheel::add(const boost::shared_ptr<Entry> &entry)
+    {
+        if (slots_.empty())
+        {
+            return;
+        }
+        std::size_t ticks = ticks_until_visit(*entry, Clock::now());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_[(cursor_ + ticks - 1) % slots_.size()].emplace_back(entry);
+    }
+
+    std::size_t TimerWheel::ticks_until_visit(const Entry &entry, Clock::time_point now) const
+    {
+        Clock::rep deadline = entry.deadline_.load(std::memory_order_relaxed);
+        std::size_t max_ticks = slots_.size() - 1;
+        if (deadline == 0)
+        {
+            return max_ticks;
+        }
+
+        auto remaining = Clock::time_point(Clock::duration(deadline)) - now;
+        if (remaining <= Clock::duration::zero())
+        {
+            return 1;
+        }
+        auto ticks = static_cast<std::size_t>((remaining + tick_ - Clock::duration(1)) / tick_);
+        return std::clamp<std::size_t>(ticks, 1, max_ticks);
+    }
+
+    void TimerWheel::on_tick(const boost::system::error_code &ec)
+    {
+        if (ec == boost::asio::error::operation_aborted)
+        {
+            return;
+        }
+
+        std::vector<boost::weak_ptr<Entry>> due;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            due.swap(slots_[cursor_]);
+            cursor_ = (cursor_ + 1) % slots_.size();
+        }
+
+        // Entries are visited without the lock, expire() only posts work to the strand of the entry.
+        auto now = Clock::now();
+        std::vector<std::pair<boost::shared_ptr<Entry>, std::size_t>> revisits;
+        revisits.reserve(due.size());
+        for (auto &&weak_entry : due)
+        {
+            boost::shared_ptr<Entry> entry = weak_entry.lock();
+            if (!entry)
+            {
+                continue;
+            }
+            if (entry->expired(now))
+            {
+                entry->expire();
+            }
+            revisits.emplace_back(entry, ticks_until_visit(*entry, now));
+        }
+
+        due.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto &&[entry, ticks] : revisits)
+            {
+                slots_[(cursor_ + ticks - 1) % slots_.size()].emplace_back(entry);
+            }
+
+            // Nothing is placed a whole turn ahead, so the visited slot is still empty and gets its capacity back.
+            slots_[(cursor_ + slots_.size() - 1) % slots_.size()].swap(due);
+        }
+
+        timer_.expires_after(tick_);
+        timer_.async_wait([this](const boost::system::error_code &ec)
+                          { on_tick(ec); });
+    }
+}
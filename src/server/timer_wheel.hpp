@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+namespace db
+{
+    /**
+     * @brief A hashed timer wheel shared by all connections of an IO service.
+     *
+     * Connections do not own timers. Every connection is registered once and only stores its current deadline, so arming
+     * and disarming a timeout is a single atomic store and no timer operation. One steady timer ticks the wheel, every tick
+     * visits the entries of a single slot: expired entries are expired, the others are moved to the slot of their deadline.
+     *
+     * An entry is never placed further than the shortest timeout ahead. Any deadline armed later is at least that far away,
+     * so it is always visited in time and the wheel needs no more slots than the shortest timeout has ticks.
+     */
+    class TimerWheel
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief Something with a deadline, e.g. a connection.
+         */
+        class Entry
+        {
+        private:
+            /** The deadline in clock ticks since the epoch of the clock, zero if no deadline is armed. */
+            std::atomic<Clock::rep> deadline_{0};
+
+        public:
+            virtual ~Entry() = default;
+
+            /**
+             * @brief Arms the deadline, replacing the previous one.
+             *
+             * @param timeout The time from now until the deadline. A zero timeout disarms the deadline.
+             */
+            void arm(std::chrono::seconds timeout);
+
+            /**
+             * @brief Disarms the deadline.
+             */
+            void disarm();
+
+            /**
+             * @brief Returns whether the deadline is armed and has passed.
+             */
+            bool expired(Clock::time_point now = Clock::now()) const;
+
+            /**
+             * @brief Called by the wheel once the deadline passed.
+             *
+             * It runs on a thread of the IO service of the wheel, not necessarily on the strand of the entry, so the entry has
+             * to check `expired()` again on its own strand before acting.
+             */
+            virtual void expire() = 0;
+
+            friend class TimerWheel;
+        };
+
+    private:
+        /** The timer ticking the wheel. */
+        boost::asio::steady_timer timer_;
+
+        /** The time between two ticks. */
+        std::chrono::milliseconds tick_;
+
+        /** The slots of the wheel. */
+        std::vector<std::vector<boost::weak_ptr<Entry>>> slots_;
+
+        /** The slot visited by the next tick. */
+        std::size_t cursor_ = 0;
+
+        /** Guards `slots_` and `cursor_` against connections registering from other threads. */
+        std::mutex mutex_;
+
+    public:
+        /**
+         * @brief Constructs a TimerWheel object.
+         *
+         * @param io_service The IO service running the wheel and the connections it watches.
+         * @param shortest_timeout The shortest timeout ever armed, zero if no timeout is used at all.
+         */
+        TimerWheel(boost::asio::io_context &io_service, std::chrono::seconds shortest_timeout);
+
+        /**
+         * @brief Starts ticking the wheel. Does nothing if no timeout is used.
+         */
+        void start();
+
+        /**
+         * @brief Registers an entry for the rest of its lifetime. The wheel holds only a weak reference to the entry.
+         *
+         * @param entry The entry to be watched.
+         */
+        void add(const boost::shared_ptr<Entry> &entry);
+
+    private:
+        /**
+         * @brief Visits the entries of the current slot and schedules the next tick.
+         */
+        void on_tick(const boost::system::error_code &ec);
+
+        /**
+         * @brief Returns the number of ticks from now until the entry has to be visited again, between 1 and the last slot.
+         */
+        std::size_t ticks_until_visit(const Entry &entry, Clock::time_point now) const;
+    };
+}
@@ -0,0 +1,146 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace db
+{
+    std::size_t LatencyHistogram::bucket(std::uint64_t nanoseconds)
+    {
+        if (nanoseconds < SUB_BUCKETS)
+        {
+            return nanoseconds;
+        }
+        // The highest bit selects the power of two, the next SUB_BUCKET_BITS bits the linear bucket within it.
+        std::size_t magnitude = std::bit_width(nanoseconds) - 1;
+        std::size_t shift = magnitude - SUB_BUCKET_BITS;
+        std::size_t index = (shift + 1) * SUB_BUCKETS + ((nanoseconds >> shift) & (SUB_BUCKETS - 1));
+        return std::min(index, BUCKET_COUNT - 1);
+    }
+
+    std::uint64_t LatencyHistogram::upper_bound(std::size_t bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+        {
+            return bucket;
+        }
+        std::size_t shift = bucket / SUB_BUCKETS - 1;
+        std::uint64_t lower = (SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+        return lower + (std::uint64_t{1} << shift) - 1;
+    }
+
+    void LatencySummary::add(const LatencyHistogram &histogram)
+    {
+        for (std::size_t bucket = 0; bucket < counts_.size(); ++bucket)
+        {
+            std::uint64_t count = histogram.count(bucket);
+            counts_[bucket] += count;
+            total_ += count;
+        }
+    }
+
+    std::uint64_t LatencySummary::percentile(double fraction) const
+    {
+        if (total_ == 0)
+        {
+            return 0;
+        }
+        std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(fraction * total_ + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < counts_.size(); ++bucket)
+        {
+            seen += counts_[bucket];
+            if (seen >= rank)
+            {
+                return LatencyHistogram::upper_bound(bucket);
+            }
+        }
+        return LatencyHistogram::upper_bound(counts_.size() - 1);
+    }
+
+    Metrics::ThreadMetrics::~ThreadMetrics()
+    {
+        for (auto &&histograms : commands)
+        {
+            delete histograms.load();
+        }
+    }
+
+    Metrics::ThreadMetrics &Metrics::local()
+    {
+        thread_local ThreadMetrics *metrics = nullptr;
+        if (metrics == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.push_back(std::make_unique<ThreadMetrics>());
+            metrics = threads_.back().get();
+        }
+        return *metrics;
+    }
+
+    void Metrics::record_error(std::string_view code)
+    {
+        if (code.empty())
+        {
+            code = "UNKNOWN";
+        }
+        auto &metrics = local();
+        std::lock_guard<std::mutex> lock(metrics.errors_mutex);
+        auto count = metrics.errors.find(code);
+        if (count == metrics.errors.end())
+        {
+            count = metrics.errors.emplace(std::string{code}, 0).first;
+        }
+        ++count->second;
+    }
+
+    std::uint64_t Metrics::bytes_in()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::uint64_t bytes = 0;
+        for (auto &&thread : threads_)
+        {
+            bytes += thread->bytes_in.load(std::memory_order_relaxed);
+        }
+        return bytes;
+    }
+
+    std::uint64_t Metrics::bytes_out()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::uint64_t bytes = 0;
+        for (auto &&thread : threads_)
+        {
+            bytes += thread->bytes_out.load(std::memory_order_relaxed);
+        }
+        return bytes;
+    }
+
+    std::map<std::string, std::uint64_t> Metrics::errors()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, std::uint64_t> errors;
+        for (auto &&thread : threads_)
+        {
+            std::lock_guard<std::mutex> errors_lock(thread->errors_mutex);
+            for (auto &&[code, count] : thread->errors)
+            {
+                errors[code] += count;
+            }
+        }
+        return errors;
+    }
+
+    LatencySummary Metrics::summarize(std::size_t type, Phase phase)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LatencySummary summary;
+        for (auto &&thread : threads_)
+        {
+            if (auto histograms = thread->commands[type].load(std::memory_order_acquire))
+            {
+                summary.add(histograms->phases[static_cast<std::size_t>(phase)]);
+            }
+        }
+        return summary;
+    }
+}
@@ -0,0 +1,244 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace db
+{
+    /**
+     * \brief The phases of a command whose latency is measured.
+     */
+    enum class Phase
+    {
+        /** Building the command from the tokens of the request. */
+        PARSE,
+
+        /** Executing the command. */
+        EXECUTE,
+
+        /** Appending the reply to the response. */
+        SERIALIZE
+    };
+
+    /**
+     * \class LatencyHistogram
+     * \brief A log-linear histogram of latencies in nanoseconds, written by a single thread and read by any.
+     *
+     * Every power of two is split into `SUB_BUCKETS` linear buckets, so a percentile is off by at most 1/16 of its value,
+     * like an HDR histogram with one significant digit. Recording is a relaxed increment of one counter.
+     */
+    class LatencyHistogram
+    {
+    public:
+        static constexpr std::size_t SUB_BUCKET_BITS = 4;
+        static constexpr std::size_t SUB_BUCKETS = std::size_t{1} << SUB_BUCKET_BITS;
+
+        /** Latencies from 2^40 ns, about 18 minutes, on fall into the last bucket. */
+        static constexpr std::size_t BUCKET_COUNT = (40 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    private:
+        std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> counts_{};
+
+    public:
+        /**
+         * Records a latency. Must only be called by the thread owning the histogram.
+         *
+         * \param nanoseconds The latency.
+         */
+        void record(std::uint64_t nanoseconds)
+        {
+            auto &count = counts_[bucket(nanoseconds)];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * Returns the number of latencies recorded in a bucket.
+         */
+        std::uint64_t count(std::size_t bucket) const { return counts_[bucket].load(std::memory_order_relaxed); }
+
+        /**
+         * Returns the bucket a latency is counted in.
+         */
+        static std::size_t bucket(std::uint64_t nanoseconds);
+
+        /**
+         * Returns the largest latency counted in a bucket.
+         */
+        static std::uint64_t upper_bound(std::size_t bucket);
+    };
+
+    /**
+     * \class LatencySummary
+     * \brief The sum of the histograms of several threads.
+     */
+    class LatencySummary
+    {
+    private:
+        std::array<std::uint64_t, LatencyHistogram::BUCKET_COUNT> counts_{};
+        std::uint64_t total_ = 0;
+
+    public:
+        /**
+         * Adds the latencies recorded by a histogram.
+         */
+        void add(const LatencyHistogram &histogram);
+
+        /**
+         * Returns the number of latencies.
+         */
+        std::uint64_t count() const { return total_; }
+
+        /**
+         * Returns the latency below which the given fraction of the latencies lies, in nanoseconds.
+         *
+         * \param fraction The fraction, e.g. 0.99 for the 99th percentile.
+         */
+        std::uint64_t percentile(double fraction) const;
+    };
+
+    /**
+     * \class Metrics
+     * \brief Counters and latency histograms describing what the server does.
+     *
+     * Every thread records into its own histograms, allocated when the thread first records a command type, so the hot path
+     * neither locks nor shares cache lines. Reading the metrics sums the histograms of all threads.
+     */
+    class Metrics
+    {
+    public:
+        /** The maximum number of command types. */
+        static constexpr std::size_t MAX_COMMAND_TYPES = 64;
+
+        static constexpr std::size_t PHASE_COUNT = 3;
+
+    private:
+        /** The histograms of a command type recorded by one thread. */
+        struct CommandHistograms
+        {
+            std::array<LatencyHistogram, PHASE_COUNT> phases;
+        };
+
+        /** The metrics recorded by one thread. */
+        struct ThreadMetrics
+        {
+            std::array<std::atomic<CommandHistograms *>, MAX_COMMAND_TYPES> commands{};
+            std::atomic<std::uint64_t> bytes_in{0};
+            std::atomic<std::uint64_t> bytes_out{0};
+
+            /** Guards `errors`, so it is only contended while the metrics are read. */
+            std::mutex errors_mutex;
+
+            /** The number of failed commands by error code. */
+            std::map<std::string, std::uint64_t, std::less<>> errors;
+
+            ~ThreadMetrics();
+        };
+
+        /** Guards `threads_`. */
+        std::mutex mutex_;
+
+        /** The metrics of every thread which recorded anything, kept after the thread exits. */
+        std::vector<std::unique_ptr<ThreadMetrics>> threads_;
+
+        std::atomic<std::uint64_t> connections_opened_{0};
+        std::atomic<std::uint64_t> connections_closed_{0};
+
+        Metrics() = default;
+
+        /**
+         * Returns the metrics of the calling thread, registering them on first use.
+         */
+        ThreadMetrics &local();
+
+    public:
+        /**
+         * Records the latency of a phase of a command.
+         *
+         * \param type The index of the command type, below `MAX_COMMAND_TYPES`.
+         * \param phase The phase.
+         * \param latency The latency.
+         */
+        void record(std::size_t type, Phase phase, std::chrono::nanoseconds latency)
+        {
+            auto &slot = local().commands[type];
+            CommandHistograms *histograms = slot.load(std::memory_order_relaxed);
+            if (histograms == nullptr)
+            {
+                histograms = new CommandHistograms;
+                slot.store(histograms, std::memory_order_release);
+            }
+            histograms->phases[static_cast<std::size_t>(phase)].record(latency.count() > 0 ? latency.count() : 0);
+        }
+
+        /**
+         * Counts bytes received from clients.
+         */
+        void add_bytes_in(std::uint64_t bytes)
+        {
+            auto &counter = local().bytes_in;
+            counter.store(counter.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+        }
+
+        /**
+         * Counts bytes sent to clients.
+         */
+        void add_bytes_out(std::uint64_t bytes)
+        {
+            auto &counter = local().bytes_out;
+            counter.store(counter.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+        }
+
+        /**
+         * Counts a failed command.
+         *
+         * \param code The error code the command failed with.
+         */
+        void record_error(std::string_view code);
+
+        void connection_opened() { connections_opened_.fetch_add(1, std::memory_order_relaxed); }
+
+        void connection_closed() { connections_closed_.fetch_add(1, std::memory_order_relaxed); }
+
+        std::uint64_t connections_opened() const { return connections_opened_.load(std::memory_order_relaxed); }
+
+        std::uint64_t connections_closed() const { return connections_closed_.load(std::memory_order_relaxed); }
+
+        /**
+         * Returns the number of bytes received from clients.
+         */
+        std::uint64_t bytes_in();
+
+        /**
+         * Returns the number of bytes sent to clients.
+         */
+        std::uint64_t bytes_out();
+
+        /**
+         * Returns the number of failed commands by error code.
+         */
+        std::map<std::string, std::uint64_t> errors();
+
+        /**
+         * Sums the latencies of a phase of a command type recorded by all threads.
+         */
+        LatencySummary summarize(std::size_t type, Phase phase);
+
+        /**
+         * Singleton access method returning a reference to the single instance of Metrics.
+         *
+         * @return A reference to the single instance of Metrics.
+         */
+        static Metrics &get_instance()
+        {
+            static Metrics instance;
+            return instance;
+        }
+    };
+}
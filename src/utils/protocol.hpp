@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/endian/conversion.hpp>
+#include <utils.hpp>
+
+namespace db
+{
+    /**
+     * @brief Definitions of the length-prefixed binary wire protocol.
+     *
+     * A client selects the binary protocol by sending `MAGIC` as the very first byte of the connection, any other first byte
+     * selects the `|`-terminated text protocol. After the magic byte both sides exchange frames:
+     *
+     *     | length : u32 | opcode : u8 | flags : u8 | argc : u16 | argc x ( size : u32 | bytes ) |
+     *
+     * All integers are big-endian. `length` counts the bytes following the header, so the receiver always knows how many
+     * bytes to read and never scans for delimiters. Arguments are raw bytes and may contain any character.
+     */
+    namespace protocol
+    {
+        /** The first byte a client sends to select the binary protocol. */
+        constexpr std::uint8_t MAGIC = 0xDB;
+
+        /** The size of the frame header in bytes. */
+        constexpr std::size_t HEADER_SIZE = 8;
+
+        /** The size of the length prefix of every argument in bytes. */
+        constexpr std::size_t ARGUMENT_PREFIX_SIZE = 4;
+
+        /**
+         * @brief Frame opcodes.
+         */
+        enum class Opcode : std::uint8_t
+        {
+            /** Request: the arguments are the tokens of a single command, e.g. `STR`, `name`, `GET`. */
+            COMMAND = 0x01,
+
+            /** Reply: the command succeeded, the only argument is its result. */
+            REPLY_OK = 0x80,
+
+            /** Reply: the command failed, the arguments are the error message and the error code. */
+            REPLY_ERROR = 0x81,
+
+            /** Push: a message published to a subscribed channel, the arguments are the channel and the payload. */
+            MESSAGE = 0x82,
+
+            /** Push: a chunk of the snapshot a primary sends to a replica, the only argument is the chunk. */
+            SNAPSHOT = 0x83
+        };
+
+        /**
+         * @brief The decoded frame header.
+         */
+        struct FrameHeader
+        {
+            std::uint32_t length = 0;
+            Opcode opcode = Opcode::COMMAND;
+            std::uint8_t flags = 0;
+            std::uint16_t argc = 0;
+        };
+
+        /**
+         * Decodes a frame header.
+         *
+         * @param data Pointer to at least `HEADER_SIZE` bytes.
+         * @return The decoded header.
+         */
+        inline FrameHeader decode_header(const char *data)
+        {
+            FrameHeader header;
+            header.length = boost::endian::load_big_u32(reinterpret_cast<const unsigned char *>(data));
+            header.opcode = static_cast<Opcode>(data[4]);
+            header.flags = static_cast<std::uint8_t>(data[5]);
+            header.argc = boost::endian::load_big_u16(reinterpret_cast<const unsigned char *>(data + 6));
+            return header;
+        }
+
+        /**
+         * Appends an encoded frame header to the output.
+         *
+         * @param out The output the header is appended to.
+         * @param header The header to be encoded.
+         */
+        inline void encode_header(std::string &out, const FrameHeader &header)
+        {
+            unsigned char raw[HEADER_SIZE];
+            boost::endian::store_big_u32(raw, header.length);
+            raw[4] = static_cast<unsigned char>(header.opcode);
+            raw[5] = header.flags;
+            boost::endian::store_big_u16(raw + 6, header.argc);
+            out.append(reinterpret_cast<const char *>(raw), HEADER_SIZE);
+        }
+
+        /**
+         * Appends the length prefix of an argument to the output, for arguments whose bytes are sent from another buffer.
+         *
+         * @param out The output the prefix is appended to.
+         * @param size The size of the argument in bytes.
+         */
+        inline void encode_argument_size(std::string &out, std::size_t size)
+        {
+            unsigned char raw[ARGUMENT_PREFIX_SIZE];
+            boost::endian::store_big_u32(raw, static_cast<std::uint32_t>(size));
+            out.append(reinterpret_cast<const char *>(raw), ARGUMENT_PREFIX_SIZE);
+        }
+
+        /**
+         * Appends a length-prefixed argument to the output.
+         *
+         * @param out The output the argument is appended to.
+         * @param argument The argument to be encoded.
+         */
+        inline void encode_argument(std::string &out, std::string_view argument)
+        {
+            encode_argument_size(out, argument.size());
+            out.append(argument);
+        }
+
+        /**
+         * Appends a whole frame to the output.
+         *
+         * @param out The output the frame is appended to.
+         * @param opcode The opcode of the frame.
+         * @param arguments The arguments of the frame.
+         */
+        inline void encode_frame(std::string &out, Opcode opcode, std::span<const std::string_view> arguments)
+        {
+            FrameHeader header;
+            header.opcode = opcode;
+            header.argc = static_cast<std::uint16_t>(arguments.size());
+            for (auto &&argument : arguments)
+            {
+                header.length += ARGUMENT_PREFIX_SIZE + argument.size();
+            }
+            encode_header(out, header);
+            for (auto &&argument : arguments)
+            {
+                encode_argument(out, argument);
+            }
+        }
+
+        /**
+         * Appends a whole frame to the output.
+         *
+         * @param out The output the frame is appended to.
+         * @param opcode The opcode of the frame.
+         * @param arguments The arguments of the frame.
+         */
+        inline void encode_frame(std::string &out, Opcode opcode, std::initializer_list<std::string_view> arguments)
+        {
+            encode_frame(out, opcode, std::span<const std::string_view>(arguments.begin(), arguments.size()));
+        }
+
+        /**
+         * Decodes the arguments of a frame body.
+         *
+         * The returned views point into `body`, so no argument is copied.
+         *
+         * @param header The header of the frame.
+         * @param body Pointer to `header.length` bytes following the header.
+         * @return The arguments of the frame.
+         * @throws DatabaseException with the `BAD_FRAME` code if the arguments do not fit into the frame.
+         */
+        inline std::vector<std::string_view> decode_arguments(const FrameHeader &header, const char *body)
+        {
+            std::vector<std::string_view> arguments;
+            arguments.reserve(header.argc);
+
+            std::size_t offset = 0;
+            for (std::uint16_t i = 0; i < header.argc; ++i)
+            {
+                if (header.length - offset < ARGUMENT_PREFIX_SIZE)
+                {
+                    throw DatabaseException("Frame is truncated", "BAD_FRAME");
+                }
+                std::uint32_t size = boost::endian::load_big_u32(reinterpret_cast<const unsigned char *>(body + offset));
+                offset += ARGUMENT_PREFIX_SIZE;
+                if (header.length - offset < size)
+                {
+                    throw DatabaseException("Frame is truncated", "BAD_FRAME");
+                }
+                arguments.emplace_back(body + offset, size);
+                offset += size;
+            }
+
+            if (offset != header.length)
+            {
+                throw DatabaseException("Frame has trailing bytes", "BAD_FRAME");
+            }
+            return arguments;
+        }
+    }
+}
@@ -59,6 +59,82 @@ namespace db
             {
                 config.set_dump_period(std::stoi(value));
             }
+            else if (key == "per_core_mode")
+            {
+                config.set_per_core_mode(value == "true" || value == "1");
+            }
+            else if (key == "fast_lane_threads")
+            {
+                config.set_fast_lane_threads(std::stoi(value));
+            }
+            else if (key == "slow_lane_threads")
+            {
+                config.set_slow_lane_threads(std::stoi(value));
+            }
+            else if (key == "unix_socket_path")
+            {
+                config.set_unix_socket_path(value);
+            }
+            else if (key == "max_connections")
+            {
+                config.set_max_connections(std::stoi(value));
+            }
+            else if (key == "max_request_bytes")
+            {
+                config.set_max_request_bytes(std::stoll(value));
+            }
+            else if (key == "max_commands_per_request")
+            {
+                config.set_max_commands_per_request(std::stoi(value));
+            }
+            else if (key == "idle_timeout")
+            {
+                config.set_idle_timeout(std::stoi(value));
+            }
+            else if (key == "read_timeout")
+            {
+                config.set_read_timeout(std::stoi(value));
+            }
+            else if (key == "write_timeout")
+            {
+                config.set_write_timeout(std::stoi(value));
+            }
+            else if (key == "max_pending_messages")
+            {
+                config.set_max_pending_messages(std::stoi(value));
+            }
+            else if (key == "replication_backlog")
+            {
+                config.set_replication_backlog(std::stoll(value));
+            }
+            else if (key == "replica_of")
+            {
+                config.set_replica_of(value);
+            }
+            else if (key == "cluster_address")
+            {
+                config.set_cluster_address(value);
+            }
+            else if (key == "cluster_nodes")
+            {
+                config.set_cluster_nodes(value);
+            }
+            else if (key == "io_backend")
+            {
+                if (value == "io_uring")
+                {
+                    config.set_io_backend(IoBackend::IO_URING);
+                }
+                else if (value == "posix")
+                {
+                    config.set_io_backend(IoBackend::POSIX);
+                }
+                else
+                {
+                    std::cerr << "Unknown io_backend: " << value << std::endl;
+                    exit(1);
+                }
+            }
         }
         return config;
     }
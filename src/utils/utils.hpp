@@ -42,6 +42,18 @@ namespace db
         std::string code_;    ///< The error code.
     };
 
+    /**
+     * \brief The IO backend used for snapshot files and, if the server is built with `DATABASE_ASIO_IO_URING`, for sockets.
+     */
+    enum class IoBackend
+    {
+        /** Blocking `write(2)` calls for files and the epoll reactor for sockets. */
+        POSIX,
+
+        /** Batched io_uring submissions from registered buffers. */
+        IO_URING
+    };
+
     /**
      * \class Config
      * \brief Class representing a configuration.
@@ -50,6 +62,12 @@ namespace db
      */
     class Config
     {
+    public:
+        /**
+         * The number of published messages queued for a subscribed client if the configuration does not set a positive one.
+         */
+        static constexpr int DEFAULT_MAX_PENDING_MESSAGES = 10000;
+
     private:
         /**
          * The port on which the server should listen for incoming connections.
@@ -57,7 +75,7 @@ namespace db
         int port_ = 1234;
 
         /**
-         * The number of threads to use for handling requests.
+         * The number of threads to use for handling requests. Non-positive values mean one thread per hardware core.
          */
         int thread_count_ = 4;
 
@@ -71,6 +89,88 @@ namespace db
          */
         std::string persistence_file_ = "server.config";
 
+        /**
+         * Whether the server runs one IO service, one thread and one SO_REUSEPORT acceptor per core instead of a shared IO service.
+         */
+        bool per_core_mode_ = false;
+
+        /**
+         * The number of threads executing fast commands. Non-positive values mean one thread per hardware core.
+         */
+        int fast_lane_threads_ = 0;
+
+        /**
+         * The number of threads executing slow commands, e.g. set algebra or `KEYS`.
+         */
+        int slow_lane_threads_ = 1;
+
+        /**
+         * The IO backend used for snapshot files.
+         */
+        IoBackend io_backend_ = IoBackend::POSIX;
+
+        /**
+         * The path of the Unix domain socket the server additionally listens on. Empty means no Unix domain socket.
+         */
+        std::string unix_socket_path_;
+
+        /**
+         * The maximum number of served connections. Non-positive values mean no limit.
+         */
+        int max_connections_ = 10000;
+
+        /**
+         * The maximum number of bytes buffered for the requests of a connection. Non-positive values mean no limit.
+         */
+        long long max_request_bytes_ = 16 * 1024 * 1024;
+
+        /**
+         * The maximum number of commands in a single request. Non-positive values mean no limit.
+         */
+        int max_commands_per_request_ = 1024;
+
+        /**
+         * The number of seconds a connection may wait for the next request before it is closed. Zero disables the timeout.
+         */
+        int idle_timeout_ = 300;
+
+        /**
+         * The number of seconds a client may take to send the rest of a started request. Zero disables the timeout.
+         */
+        int read_timeout_ = 30;
+
+        /**
+         * The number of seconds a client may take to receive a reply. Zero disables the timeout.
+         */
+        int write_timeout_ = 30;
+
+        /**
+         * The maximum number of published messages queued for a subscribed client. A client falling further behind is
+         * disconnected. The queue is always bounded, non-positive values mean `DEFAULT_MAX_PENDING_MESSAGES`.
+         */
+        int max_pending_messages_ = DEFAULT_MAX_PENDING_MESSAGES;
+
+        /**
+         * The number of bytes of recent mutations kept for replicas catching up after a reconnect. Zero disables
+         * replication, so mutations are not logged at all.
+         */
+        long long replication_backlog_ = 0;
+
+        /**
+         * The `host:port` of the primary this server replicates. Empty means the server is a primary.
+         */
+        std::string replica_of_;
+
+        /**
+         * The `host:port` other nodes and clients reach this server at. Empty means the server is not part of a cluster.
+         */
+        std::string cluster_address_;
+
+        /**
+         * The initial assignment of hash slots to the nodes of the cluster, e.g. `127.0.0.1:5555@0-8191,127.0.0.1:5556@8192-16383`.
+         */
+        std::string cluster_nodes_;
+
     public:
         /**
          * Returns the port on which the server should listen for incoming connections.
@@ -92,6 +192,86 @@ namespace db
          */
         int get_dump_period() const { return dump_period_; }
 
+        /**
+         * Returns whether the server runs one IO service, one thread and one SO_REUSEPORT acceptor per core.
+         */
+        bool get_per_core_mode() const { return per_core_mode_; }
+
+        /**
+         * Returns the number of threads executing fast commands.
+         */
+        int get_fast_lane_threads() const { return fast_lane_threads_; }
+
+        /**
+         * Returns the number of threads executing slow commands.
+         */
+        int get_slow_lane_threads() const { return slow_lane_threads_; }
+
+        /**
+         * Returns the IO backend used for snapshot files.
+         */
+        IoBackend get_io_backend() const { return io_backend_; }
+
+        /**
+         * Returns the path of the Unix domain socket the server additionally listens on.
+         */
+        const std::string &get_unix_socket_path() const { return unix_socket_path_; }
+
+        /**
+         * Returns the maximum number of served connections.
+         */
+        int get_max_connections() const { return max_connections_; }
+
+        /**
+         * Returns the maximum number of bytes buffered for the requests of a connection.
+         */
+        long long get_max_request_bytes() const { return max_request_bytes_; }
+
+        /**
+         * Returns the maximum number of commands in a single request.
+         */
+        int get_max_commands_per_request() const { return max_commands_per_request_; }
+
+        /**
+         * Returns the number of seconds a connection may wait for the next request.
+         */
+        int get_idle_timeout() const { return idle_timeout_; }
+
+        /**
+         * Returns the number of seconds a client may take to send the rest of a started request.
+         */
+        int get_read_timeout() const { return read_timeout_; }
+
+        /**
+         * Returns the number of seconds a client may take to receive a reply.
+         */
+        int get_write_timeout() const { return write_timeout_; }
+
+        /**
+         * Returns the maximum number of published messages queued for a subscribed client.
+         */
+        int get_max_pending_messages() const { return max_pending_messages_; }
+
+        /**
+         * Returns the number of bytes of recent mutations kept for replicas.
+         */
+        long long get_replication_backlog() const { return replication_backlog_; }
+
+        /**
+         * Returns the `host:port` of the primary this server replicates.
+         */
+        const std::string &get_replica_of() const { return replica_of_; }
+
+        /**
+         * Returns the `host:port` other nodes and clients reach this server at.
+         */
+        const std::string &get_cluster_address() const { return cluster_address_; }
+
+        /**
+         * Returns the initial assignment of hash slots to the nodes of the cluster.
+         */
+        const std::string &get_cluster_nodes() const { return cluster_nodes_; }
+
         /**
          * Sets the port on which the server should listen for incoming connections.
          */
@@ -111,6 +291,86 @@ namespace db
          * Sets the file name to use for persistent storage of server data.
          */
         void set_persistence_file(const std::string &persistence_file) { persistence_file_ = persistence_file; }
+
+        /**
+         * Sets whether the server runs one IO service, one thread and one SO_REUSEPORT acceptor per core.
+         */
+        void set_per_core_mode(bool per_core_mode) { per_core_mode_ = per_core_mode; }
+
+        /**
+         * Sets the number of threads executing fast commands.
+         */
+        void set_fast_lane_threads(int fast_lane_threads) { fast_lane_threads_ = fast_lane_threads; }
+
+        /**
+         * Sets the number of threads executing slow commands.
+         */
+        void set_slow_lane_threads(int slow_lane_threads) { slow_lane_threads_ = slow_lane_threads; }
+
+        /**
+         * Sets the IO backend used for snapshot files.
+         */
+        void set_io_backend(IoBackend io_backend) { io_backend_ = io_backend; }
+
+        /**
+         * Sets the path of the Unix domain socket the server additionally listens on.
+         */
+        void set_unix_socket_path(const std::string &unix_socket_path) { unix_socket_path_ = unix_socket_path; }
+
+        /**
+         * Sets the maximum number of served connections.
+         */
+        void set_max_connections(int max_connections) { max_connections_ = max_connections; }
+
+        /**
+         * Sets the maximum number of bytes buffered for the requests of a connection.
+         */
+        void set_max_request_bytes(long long max_request_bytes) { max_request_bytes_ = max_request_bytes; }
+
+        /**
+         * Sets the maximum number of commands in a single request.
+         */
+        void set_max_commands_per_request(int max_commands_per_request) { max_commands_per_request_ = max_commands_per_request; }
+
+        /**
+         * Sets the number of seconds a connection may wait for the next request.
+         */
+        void set_idle_timeout(int idle_timeout) { idle_timeout_ = idle_timeout; }
+
+        /**
+         * Sets the number of seconds a client may take to send the rest of a started request.
+         */
+        void set_read_timeout(int read_timeout) { read_timeout_ = read_timeout; }
+
+        /**
+         * Sets the number of seconds a client may take to receive a reply.
+         */
+        void set_write_timeout(int write_timeout) { write_timeout_ = write_timeout; }
+
+        /**
+         * Sets the maximum number of published messages queued for a subscribed client.
+         */
+        void set_max_pending_messages(int max_pending_messages) { max_pending_messages_ = max_pending_messages; }
+
+        /**
+         * Sets the number of bytes of recent mutations kept for replicas.
+         */
+        void set_replication_backlog(long long replication_backlog) { replication_backlog_ = replication_backlog; }
+
+        /**
+         * Sets the `host:port` of the primary this server replicates.
+         */
+        void set_replica_of(const std::string &replica_of) { replica_of_ = replica_of; }
+
+        /**
+         * Sets the `host:port` other nodes and clients reach this server at.
+         */
+        void set_cluster_address(const std::string &cluster_address) { cluster_address_ = cluster_address; }
+
+        /**
+         * Sets the initial assignment of hash slots to the nodes of the cluster.
+         */
+        void set_cluster_nodes(const std::string &cluster_nodes) { cluster_nodes_ = cluster_nodes; }
     };
 
     /**